@@ -0,0 +1,731 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+
+/* c-runtime */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdatomic.h>
+
+/* system */
+#include <fcntl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+#include <lib_convention__mem.h>
+#include <lib_thread.h>
+
+/* project */
+#include <lib_console.h>
+#include <lib_console_factory.h>
+#include <lib_console_transport.h>
+
+/* ****************************************************************************
+ * defines
+ * ****************************************************************************/
+#define M_BENCH__MAX_THREADS_DEFAULT	8
+#define M_BENCH__MAX_THREADS			64
+#define M_BENCH__MESSAGES_DEFAULT		20000
+#define M_BENCH__MESSAGE_SIZE_MAX		1024
+#define M_BENCH__LINE_SIZE_MAX			512
+#define M_BENCH__INJECT_CHUNK			4096
+#define M_BENCH__COALESCE_SIZE			4096
+#define M_BENCH__COALESCE_DELAY_MS		5
+
+/* ****************************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ****************************************************************************/
+enum bench_transport {
+	BENCH_TRANSPORT_LOOPBACK,
+	BENCH_TRANSPORT_PTY
+};
+
+enum bench_mode {
+	BENCH_MODE_SYNC,
+	BENCH_MODE_ASYNC,
+	/* synchronous with lib_console__set_coalesce */
+	BENCH_MODE_COALESCE,
+	BENCH_MODE_COUNT
+};
+
+enum bench_op {
+	BENCH_OP_PRINT,
+	BENCH_OP_PUTCHAR,
+	/* a label and one value, formatted print against the typed print */
+	BENCH_OP_PRINTF_U32,
+	BENCH_OP_TYPED_U32,
+	BENCH_OP_PRINTF_HEX,
+	BENCH_OP_TYPED_HEX
+};
+
+/* console under test and its peer side */
+struct bench_target {
+	enum bench_transport transport;
+	console_hdl_t console;
+	console_loopback_hdl_t loopback;
+	console_fd_hdl_t pty;
+	int slaveFd;
+	thread_hdl_t drainThd;
+	atomic_bool drainStop;
+	atomic_uint_least64_t peerBytes;
+	/* the console lives in an arena to size its line storage */
+	struct console_arena arena;
+	void *arenaMemory;
+};
+
+struct bench_producer {
+	struct bench_target *target;
+	enum bench_op op;
+	const char *payload;
+	unsigned int messages;
+	uint64_t *latency;
+	atomic_uint *startGate;
+	thread_hdl_t thd;
+};
+
+struct bench_feeder {
+	struct bench_target *target;
+	const uint8_t *data;
+	size_t length;
+	thread_hdl_t thd;
+};
+
+struct bench_result {
+	uint64_t operations;
+	uint64_t bytes;
+	uint64_t writes;
+	uint64_t wallNs;
+	uint64_t cpuNs;
+	uint64_t p50;
+	uint64_t p99;
+	uint64_t p999;
+};
+
+/* ****************************************************************************
+ * static function declarations
+ * ***************************************************************************/
+static uint64_t bench__now(void);
+static uint64_t bench__cpu(void);
+static int bench__cmp_u64(const void *_a, const void *_b);
+static void bench__percentiles(uint64_t *_latency, size_t _count, struct bench_result *_result);
+static void bench__report(const char *_scenario, const char *_mode, unsigned int _threads, size_t _size,
+						  const struct bench_result *_result);
+static int bench__target_create(struct bench_target *_target, enum bench_transport _transport);
+static console_hdl_t bench__console_create(struct bench_target *_target, const struct lib_console_transport *_transport,
+										   void *_ctx);
+static void bench__target_destroy(struct bench_target *_target);
+static uint64_t bench__target_bytes(struct bench_target *_target);
+static uint64_t bench__target_writes(struct bench_target *_target);
+static int bench__peer_send(struct bench_target *_target, const uint8_t *_data, size_t _length);
+static void* bench__drain_worker(void *_arg);
+static void* bench__producer_worker(void *_arg);
+static void* bench__feeder_worker(void *_arg);
+static int bench__run_tx(enum bench_transport _transport, enum bench_op _op, enum bench_mode _mode,
+						 unsigned int _threads, size_t _size, unsigned int _messages);
+static int bench__run_getline(enum bench_transport _transport, bool _rxEngine, size_t _size, unsigned int _lines);
+
+/* *******************************************************************
+ * (static) variables declarations
+ * ******************************************************************/
+static const char * const s_opNames[] = {
+	[BENCH_OP_PRINT]		= "print",
+	[BENCH_OP_PUTCHAR]		= "putchar",
+	[BENCH_OP_PRINTF_U32]	= "printf_u32",
+	[BENCH_OP_TYPED_U32]	= "typed_u32",
+	[BENCH_OP_PRINTF_HEX]	= "printf_hex",
+	[BENCH_OP_TYPED_HEX]	= "typed_hex"
+};
+static const char * const s_modeNames[] = {
+	[BENCH_MODE_SYNC]		= "sync",
+	[BENCH_MODE_ASYNC]		= "async",
+	[BENCH_MODE_COALESCE]	= "coal"
+};
+static const size_t s_printSizes[] = { 16, 64, 180, 512 };
+static const size_t s_lineSizes[] = { 8, 32, 120, 512 };
+
+/* ****************************************************************************
+ * Global Functions
+ * ****************************************************************************/
+int main(int _argc, char *_argv[])
+{
+	enum bench_transport transport = BENCH_TRANSPORT_LOOPBACK;
+	unsigned int maxThreads = M_BENCH__MAX_THREADS_DEFAULT;
+	unsigned int messages = M_BENCH__MESSAGES_DEFAULT;
+	unsigned int threads, mode, op;
+	size_t i;
+	int opt;
+
+	while ((opt = getopt(_argc, _argv, "t:n:ph")) != -1) {
+		switch (opt) {
+			case 't':
+				maxThreads = (unsigned int)strtoul(optarg, NULL, 0);
+				break;
+			case 'n':
+				messages = (unsigned int)strtoul(optarg, NULL, 0);
+				break;
+			case 'p':
+				transport = BENCH_TRANSPORT_PTY;
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-t max_threads] [-n messages_per_thread] [-p]\n"
+						"  -p  run over a pseudo terminal instead of the loopback transport\n", _argv[0]);
+				return (opt == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+
+	if ((maxThreads == 0) || (maxThreads > M_BENCH__MAX_THREADS) || (messages == 0)) {
+		fprintf(stderr, "invalid arguments\n");
+		return EXIT_FAILURE;
+	}
+
+	printf("transport: %s, messages per thread: %u\n",
+		   (transport == BENCH_TRANSPORT_PTY) ? "pty" : "loopback", messages);
+	printf("%-10s %-6s %4s %5s %12s %10s %9s %9s %9s %8s %10s\n",
+		   "scenario", "mode", "thr", "size", "ops/s", "MB/s", "p50[ns]", "p99[ns]", "p999[ns]",
+		   "wr/op", "cpu/op[ns]");
+
+	for (mode = 0; mode < BENCH_MODE_COUNT; mode++) {
+		for (i = 0; i < sizeof(s_printSizes) / sizeof(s_printSizes[0]); i++) {
+			for (threads = 1; threads <= maxThreads; threads *= 2) {
+				if (bench__run_tx(transport, BENCH_OP_PRINT, (enum bench_mode)mode, threads, s_printSizes[i], messages) < EOK) {
+					return EXIT_FAILURE;
+				}
+			}
+		}
+	}
+
+	for (mode = 0; mode < BENCH_MODE_COUNT; mode++) {
+		for (threads = 1; threads <= maxThreads; threads *= 2) {
+			if (bench__run_tx(transport, BENCH_OP_PUTCHAR, (enum bench_mode)mode, threads, 1, messages) < EOK) {
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	for (mode = 0; mode < 2; mode++) {
+		for (op = BENCH_OP_PRINTF_U32; op <= BENCH_OP_TYPED_HEX; op++) {
+			if (bench__run_tx(transport, (enum bench_op)op, (enum bench_mode)mode, 1, 0, messages) < EOK) {
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	for (mode = 0; mode < 2; mode++) {
+		for (i = 0; i < sizeof(s_lineSizes) / sizeof(s_lineSizes[0]); i++) {
+			if (bench__run_getline(transport, (mode == 1), s_lineSizes[i], messages) < EOK) {
+				return EXIT_FAILURE;
+			}
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+static uint64_t bench__now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t bench__cpu(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int bench__cmp_u64(const void *_a, const void *_b)
+{
+	uint64_t a = *(const uint64_t*)_a;
+	uint64_t b = *(const uint64_t*)_b;
+	return (a > b) - (a < b);
+}
+
+static void bench__percentiles(uint64_t *_latency, size_t _count, struct bench_result *_result)
+{
+	qsort(_latency, _count, sizeof(uint64_t), &bench__cmp_u64);
+	_result->p50 = _latency[(_count * 500) / 1000];
+	_result->p99 = _latency[(_count * 990) / 1000];
+	_result->p999 = _latency[(_count * 999) / 1000];
+}
+
+static void bench__report(const char *_scenario, const char *_mode, unsigned int _threads, size_t _size,
+						  const struct bench_result *_result)
+{
+	double seconds = (double)_result->wallNs / 1e9;
+
+	printf("%-10s %-6s %4u %5zu %12.0f %10.2f %9llu %9llu %9llu %8.3f %10.0f\n",
+		   _scenario, _mode, _threads, _size,
+		   (double)_result->operations / seconds,
+		   (double)_result->bytes / seconds / 1e6,
+		   (unsigned long long)_result->p50,
+		   (unsigned long long)_result->p99,
+		   (unsigned long long)_result->p999,
+		   (double)_result->writes / (double)_result->operations,
+		   (double)_result->cpuNs / (double)_result->operations);
+	fflush(stdout);
+}
+
+static int bench__target_create(struct bench_target *_target, enum bench_transport _transport)
+{
+	char slaveName[64];
+	struct termios tio;
+	int ret;
+
+	memset(_target, 0, sizeof(*_target));
+	_target->transport = _transport;
+	_target->slaveFd = -1;
+	atomic_init(&_target->drainStop, false);
+	atomic_init(&_target->peerBytes, 0);
+
+	if (_transport == BENCH_TRANSPORT_LOOPBACK) {
+		/* no tap installed, the written data is counted and discarded */
+		_target->loopback = lib_console_loopback__create(M_BENCH__INJECT_CHUNK * 16);
+		if (_target->loopback == NULL) {
+			return -ESTD_NOMEM;
+		}
+		_target->console = bench__console_create(_target, &lib_console_transport__loopback, _target->loopback);
+	}
+	else {
+		_target->pty = lib_console_fd__openpty(&slaveName[0], sizeof(slaveName));
+		if (_target->pty == NULL) {
+			return -ESTD_IO;
+		}
+
+		_target->slaveFd = open(slaveName, O_RDWR | O_NOCTTY);
+		if (_target->slaveFd < 0) {
+			return -ESTD_IO;
+		}
+
+		if (tcgetattr(_target->slaveFd, &tio) == 0) {
+			cfmakeraw(&tio);
+			tcsetattr(_target->slaveFd, TCSANOW, &tio);
+		}
+
+		ret = lib_thread__create(&_target->drainThd, &bench__drain_worker, _target, 0, "bench_drain");
+		if (ret < EOK) {
+			return ret;
+		}
+		_target->console = bench__console_create(_target, &lib_console_transport__fd, _target->pty);
+	}
+
+	if (_target->console == NULL) {
+		return -ESTD_NOMEM;
+	}
+	return lib_console__open(_target->console, BAUD_115200, DATA_8N1);
+}
+
+static void bench__target_destroy(struct bench_target *_target)
+{
+	if (_target->console != NULL) {
+		lib_console_factory__destroy(&_target->console);
+	}
+
+	if (_target->drainThd != NULL) {
+		atomic_store(&_target->drainStop, true);
+		lib_thread__join(&_target->drainThd, NULL);
+	}
+
+	if (_target->slaveFd >= 0) {
+		close(_target->slaveFd);
+	}
+
+	if (_target->pty != NULL) {
+		lib_console_fd__destroy(&_target->pty);
+	}
+
+	if (_target->loopback != NULL) {
+		lib_console_loopback__destroy(&_target->loopback);
+	}
+
+	if (_target->arenaMemory != NULL) {
+		free_memory(_target->arenaMemory);
+	}
+}
+
+static console_hdl_t bench__console_create(struct bench_target *_target, const struct lib_console_transport *_transport,
+										   void *_ctx)
+{
+	struct console_attr attr;
+	size_t size;
+
+	/* the longest benchmarked line has to stay one line in the receive engine */
+	memset(&attr, 0, sizeof(attr));
+	attr.lineSize = M_BENCH__LINE_SIZE_MAX;
+	attr.coalesceSize = M_BENCH__COALESCE_SIZE;
+	attr.arena = &_target->arena;
+
+	size = lib_console_factory__memory_size(&attr);
+	_target->arenaMemory = alloc_memory(1, size);
+	if ((_target->arenaMemory == NULL) || (lib_console_arena__init(&_target->arena, _target->arenaMemory, size) < EOK)) {
+		return NULL;
+	}
+	return lib_console_factory__create(&attr, _transport, _ctx);
+}
+
+static uint64_t bench__target_bytes(struct bench_target *_target)
+{
+	uint64_t bytes = 0;
+
+	if (_target->transport == BENCH_TRANSPORT_LOOPBACK) {
+		lib_console_loopback__counters(_target->loopback, &bytes, NULL);
+		return bytes;
+	}
+	return atomic_load(&_target->peerBytes);
+}
+
+static uint64_t bench__target_writes(struct bench_target *_target)
+{
+	struct console_stats stats;
+	uint64_t writes = 0;
+
+	/* the pty has no counter of its own, the console statistics count the writes */
+	if (_target->transport == BENCH_TRANSPORT_LOOPBACK) {
+		lib_console_loopback__counters(_target->loopback, NULL, &writes);
+		return writes;
+	}
+	if (lib_console__get_stats(_target->console, &stats) < EOK) {
+		return 0;
+	}
+	return stats.write.count;
+}
+
+static int bench__peer_send(struct bench_target *_target, const uint8_t *_data, size_t _length)
+{
+	size_t done = 0;
+	ssize_t ret;
+
+	while (done < _length) {
+		if (_target->transport == BENCH_TRANSPORT_LOOPBACK) {
+			ret = lib_console_loopback__inject(_target->loopback, &_data[done], _length - done);
+		}
+		else {
+			ret = write(_target->slaveFd, &_data[done], _length - done);
+			if ((ret < 0) && ((errno == EAGAIN) || (errno == EINTR))) {
+				ret = 0;
+			}
+		}
+
+		if (ret < 0) {
+			return -ESTD_IO;
+		}
+		else if (ret == 0) {
+			/* receive side is full, give the console time to consume */
+			lib_thread__msleep(1);
+		}
+		done += (size_t)ret;
+	}
+	return EOK;
+}
+
+static void* bench__drain_worker(void *_arg)
+{
+	struct bench_target *target = (struct bench_target*)_arg;
+	struct timespec pause = { .tv_sec = 0, .tv_nsec = 1000000 };
+	uint8_t buffer[M_BENCH__INJECT_CHUNK];
+	ssize_t ret;
+	int flags;
+
+	flags = fcntl(target->slaveFd, F_GETFL);
+	fcntl(target->slaveFd, F_SETFL, flags | O_NONBLOCK);
+
+	while (!atomic_load(&target->drainStop)) {
+		ret = read(target->slaveFd, &buffer[0], sizeof(buffer));
+		if (ret > 0) {
+			atomic_fetch_add(&target->peerBytes, (uint64_t)ret);
+		}
+		else {
+			nanosleep(&pause, NULL);
+		}
+	}
+	return NULL;
+}
+
+static void* bench__producer_worker(void *_arg)
+{
+	struct bench_producer *producer = (struct bench_producer*)_arg;
+	console_hdl_t console = producer->target->console;
+	uint64_t start;
+	unsigned int i;
+
+	/* all producers start together to measure the contention */
+	atomic_fetch_sub(producer->startGate, 1);
+	while (atomic_load(producer->startGate) != 0) {
+	}
+
+	for (i = 0; i < producer->messages; i++) {
+		start = bench__now();
+		switch (producer->op) {
+			case BENCH_OP_PRINT:
+				lib_console__print_debug_message(console, "%s\n", producer->payload);
+				break;
+			case BENCH_OP_PUTCHAR:
+				lib_console__putchar(console, 'x');
+				break;
+			case BENCH_OP_PRINTF_U32:
+				lib_console__print_debug_message(console, "rx frames: %u\n", i * 7919u);
+				break;
+			case BENCH_OP_TYPED_U32:
+				lib_console__print_u32(console, "rx frames: ", i * 7919u);
+				break;
+			case BENCH_OP_PRINTF_HEX:
+				lib_console__print_debug_message(console, "status: %08x\n", i * 2654435761u);
+				break;
+			case BENCH_OP_TYPED_HEX:
+				lib_console__print_hex(console, "status: ", i * 2654435761u, 8);
+				break;
+		}
+		producer->latency[i] = bench__now() - start;
+	}
+	return NULL;
+}
+
+static void* bench__feeder_worker(void *_arg)
+{
+	struct bench_feeder *feeder = (struct bench_feeder*)_arg;
+	size_t pos, part;
+
+	for (pos = 0; pos < feeder->length; pos += part) {
+		part = feeder->length - pos;
+		if (part > M_BENCH__INJECT_CHUNK) {
+			part = M_BENCH__INJECT_CHUNK;
+		}
+
+		if (bench__peer_send(feeder->target, &feeder->data[pos], part) < EOK) {
+			break;
+		}
+	}
+	return NULL;
+}
+
+static int bench__run_tx(enum bench_transport _transport, enum bench_op _op, enum bench_mode _mode,
+						 unsigned int _threads, size_t _size, unsigned int _messages)
+{
+	struct bench_producer producer[M_BENCH__MAX_THREADS];
+	struct bench_target target;
+	struct bench_result result;
+	atomic_uint startGate;
+	uint64_t *latency;
+	char *payload;
+	uint64_t start, cpuStart, bytes;
+	unsigned int i;
+	int ret;
+
+	latency = (uint64_t*)alloc_memory((size_t)_threads * _messages, sizeof(uint64_t));
+	payload = (char*)alloc_memory(1, M_BENCH__MESSAGE_SIZE_MAX);
+	if ((latency == NULL) || (payload == NULL)) {
+		ret = -ESTD_NOMEM;
+		goto ERR_MEMORY;
+	}
+
+	/* the trailing newline completes the message to "_size" bytes,
+	   the value prints pass 0 and bring their own message */
+	if (_size > 0) {
+		memset(payload, 'x', _size - 1);
+		payload[_size - 1] = '\0';
+	}
+
+	ret = bench__target_create(&target, _transport);
+	if (ret < EOK) {
+		goto ERR_TARGET;
+	}
+
+	if (_mode == BENCH_MODE_ASYNC) {
+		ret = lib_console__async_start(target.console, 0);
+		if (ret < EOK) {
+			goto ERR_TARGET;
+		}
+	}
+	else if (_mode == BENCH_MODE_COALESCE) {
+		ret = lib_console__set_coalesce(target.console, M_BENCH__COALESCE_SIZE, CONSOLE_FLUSH_FULL,
+										M_BENCH__COALESCE_DELAY_MS);
+		if (ret < EOK) {
+			goto ERR_TARGET;
+		}
+	}
+
+	atomic_init(&startGate, _threads + 1);
+	for (i = 0; i < _threads; i++) {
+		producer[i].target = &target;
+		producer[i].op = _op;
+		producer[i].payload = payload;
+		producer[i].messages = _messages;
+		producer[i].latency = &latency[(size_t)i * _messages];
+		producer[i].startGate = &startGate;
+		ret = lib_thread__create(&producer[i].thd, &bench__producer_worker, &producer[i], 0, "bench_producer");
+		if (ret < EOK) {
+			_threads = i;
+			break;
+		}
+	}
+
+	start = bench__now();
+	cpuStart = bench__cpu();
+	atomic_fetch_sub(&startGate, 1);
+	for (i = 0; i < _threads; i++) {
+		lib_thread__join(&producer[i].thd, NULL);
+	}
+
+	/* the wall time includes draining the asynchronous writer or the coalescing buffer */
+	if (_mode == BENCH_MODE_ASYNC) {
+		lib_console__async_stop(target.console);
+	}
+	else if (_mode == BENCH_MODE_COALESCE) {
+		lib_console__flush(target.console);
+	}
+	result.wallNs = bench__now() - start;
+	result.cpuNs = bench__cpu() - cpuStart;
+
+	if (_transport == BENCH_TRANSPORT_PTY) {
+		/* the bytes are counted by the peer, wait until it saw everything */
+		bytes = bench__target_bytes(&target);
+		lib_thread__msleep(50);
+		while (bench__target_bytes(&target) != bytes) {
+			bytes = bench__target_bytes(&target);
+			lib_thread__msleep(50);
+		}
+	}
+
+	if ((ret == EOK) && (_threads > 0)) {
+		result.operations = (uint64_t)_threads * _messages;
+		result.bytes = bench__target_bytes(&target);
+		result.writes = bench__target_writes(&target);
+		bench__percentiles(latency, result.operations, &result);
+		bench__report(s_opNames[_op], s_modeNames[_mode], _threads, _size, &result);
+	}
+
+	ERR_TARGET:
+	bench__target_destroy(&target);
+
+	ERR_MEMORY:
+	if (payload != NULL) {
+		free_memory(payload);
+	}
+	if (latency != NULL) {
+		free_memory(latency);
+	}
+	return ret;
+}
+
+static int bench__run_getline(enum bench_transport _transport, bool _rxEngine, size_t _size, unsigned int _lines)
+{
+	struct bench_target target;
+	struct bench_result result;
+	struct bench_feeder feeder;
+	char line[M_BENCH__LINE_SIZE_MAX];
+	uint64_t *latency;
+	uint8_t *input;
+	uint64_t start, wallStart, cpuStart;
+	unsigned int i;
+	size_t n;
+	int ret;
+
+	latency = (uint64_t*)alloc_memory(_lines, sizeof(uint64_t));
+	input = (uint8_t*)alloc_memory(_lines, _size);
+	if ((latency == NULL) || (input == NULL)) {
+		ret = -ESTD_NOMEM;
+		goto ERR_MEMORY;
+	}
+
+	/* "_size" bytes per line, terminated by enter */
+	for (i = 0; i < _lines; i++) {
+		memset(&input[(size_t)i * _size], 'a' + (i % 26), _size - 1);
+		input[((size_t)i * _size) + _size - 1] = '\r';
+	}
+
+	ret = bench__target_create(&target, _transport);
+	if (ret < EOK) {
+		goto ERR_TARGET;
+	}
+
+	if (_rxEngine) {
+		ret = lib_console__rx_start(target.console, 0);
+		if (ret < EOK) {
+			goto ERR_TARGET;
+		}
+	}
+
+	feeder.target = &target;
+	feeder.data = input;
+	feeder.length = (size_t)_lines * _size;
+	ret = lib_thread__create(&feeder.thd, &bench__feeder_worker, &feeder, 0, "bench_feeder");
+	if (ret < EOK) {
+		goto ERR_FEEDER;
+	}
+
+	wallStart = bench__now();
+	cpuStart = bench__cpu();
+	for (i = 0; i < _lines; i++) {
+		n = sizeof(line);
+		start = bench__now();
+		ret = lib_console__getline(target.console, &line[0], &n);
+		latency[i] = bench__now() - start;
+		if (ret < EOK) {
+			break;
+		}
+	}
+	result.wallNs = bench__now() - wallStart;
+	result.cpuNs = bench__cpu() - cpuStart;
+	lib_thread__join(&feeder.thd, NULL);
+
+	if (ret == EOK) {
+		result.operations = _lines;
+		result.bytes = (uint64_t)_lines * _size;
+		result.writes = bench__target_writes(&target);
+		bench__percentiles(latency, _lines, &result);
+		bench__report("getline", _rxEngine ? "engine" : "sync", 1, _size, &result);
+	}
+
+	ERR_FEEDER:
+	if (_rxEngine) {
+		lib_console__rx_stop(target.console);
+	}
+
+	ERR_TARGET:
+	bench__target_destroy(&target);
+
+	ERR_MEMORY:
+	if (input != NULL) {
+		free_memory(input);
+	}
+	if (latency != NULL) {
+		free_memory(latency);
+	}
+	return ret;
+}
@@ -37,14 +37,101 @@ extern "C" {
 
 /* c-runtime */
 #include <stdio.h>
+#include <stdint.h>
 
 /* system */
 #include <stdarg.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/uio.h>
+#endif
 
 /*frame*/
 #include <lib_serial_types.h>
 #include "lib_console_types.h"
 
+/* ****************************************************************************
+ * defines
+ * ****************************************************************************/
+
+/* Levels below the build-time threshold compile to nothing, e.g.
+ * -DM_LIB_CONSOLE__LEVEL_MIN=CONSOLE_LEVEL_INFO drops trace and debug calls */
+#ifndef M_LIB_CONSOLE__LEVEL_MIN
+#define M_LIB_CONSOLE__LEVEL_MIN	CONSOLE_LEVEL_TRACE
+#endif
+
+/* lib_console__writev takes the POSIX struct iovec */
+#if defined(__unix__) || defined(__APPLE__)
+#define M_LIB_CONSOLE__WRITEV		1
+#else
+#define M_LIB_CONSOLE__WRITEV		0
+#endif
+
+#if defined(__GNUC__)
+#define M_LIB_CONSOLE__UNLIKELY(_x)	__builtin_expect(!!(_x), 0)
+#else
+#define M_LIB_CONSOLE__UNLIKELY(_x)	(_x)
+#endif
+
+/* Leveled print, the console level is checked before any argument is
+ * evaluated, locked or formatted. "_hdl" and "_level" are evaluated once,
+ * a NULL handle prints nothing. */
+#define M_LIB_CONSOLE__PRINT(_hdl, _level, ...)													\
+	do {																						\
+		console_hdl_t const lib_console_print_hdl = (_hdl);										\
+		enum console_level const lib_console_print_level = (_level);							\
+		if ((lib_console_print_level >= M_LIB_CONSOLE__LEVEL_MIN) &&							\
+			lib_console__level_enabled(lib_console_print_hdl, lib_console_print_level)) {		\
+			lib_console__print_debug_message(lib_console_print_hdl, __VA_ARGS__);				\
+		}																						\
+	} while (0)
+
+#define M_LIB_CONSOLE__PRINT_TRACE(_hdl, ...)	M_LIB_CONSOLE__PRINT((_hdl), CONSOLE_LEVEL_TRACE, __VA_ARGS__)
+#define M_LIB_CONSOLE__PRINT_DEBUG(_hdl, ...)	M_LIB_CONSOLE__PRINT((_hdl), CONSOLE_LEVEL_DEBUG, __VA_ARGS__)
+#define M_LIB_CONSOLE__PRINT_INFO(_hdl, ...)	M_LIB_CONSOLE__PRINT((_hdl), CONSOLE_LEVEL_INFO, __VA_ARGS__)
+#define M_LIB_CONSOLE__PRINT_WARN(_hdl, ...)	M_LIB_CONSOLE__PRINT((_hdl), CONSOLE_LEVEL_WARN, __VA_ARGS__)
+#define M_LIB_CONSOLE__PRINT_ERROR(_hdl, ...)	M_LIB_CONSOLE__PRINT((_hdl), CONSOLE_LEVEL_ERROR, __VA_ARGS__)
+
+/* first byte of a deferred record, it never occurs in UTF-8 text */
+#define M_LIB_CONSOLE__DEFERRED_MAGIC	0xFE
+
+/* Deferred print, only the format string offset and the raw arguments are
+ * sent. The format strings are collected in the "lib_console_fmt" section,
+ * tools/lib_console_decode.py rebuilds the text on the host. Toolchains
+ * without named ELF sections fall back to the leveled text print. */
+#if defined(__GNUC__) && defined(__ELF__)
+#define M_LIB_CONSOLE__LOG(_hdl, _level, _format, ...)											\
+	do {																						\
+		console_hdl_t const lib_console_log_hdl = (_hdl);										\
+		enum console_level const lib_console_log_level = (_level);								\
+		if ((lib_console_log_level >= M_LIB_CONSOLE__LEVEL_MIN) &&								\
+			lib_console__level_enabled(lib_console_log_hdl, lib_console_log_level)) {			\
+			static const char lib_console_fmt_entry[]											\
+				__attribute__((section("lib_console_fmt"), used)) = _format;					\
+			lib_console__log_deferred(lib_console_log_hdl, &lib_console_fmt_entry[0], ##__VA_ARGS__);	\
+		}																						\
+	} while (0)
+#else
+#define M_LIB_CONSOLE__LOG(_hdl, _level, ...)	M_LIB_CONSOLE__PRINT((_hdl), (_level), __VA_ARGS__)
+#endif
+
+/* ****************************************************************************
+ * inline functions
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Checks a message level against the runtime level of the console
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param	_level [IN]	:	level of the message
+ * \return	non zero if the message is printed, 0 for a NULL handle
+ * ****************************************************************************/
+static inline int lib_console__level_enabled(console_hdl_t _hdl, enum console_level _level)
+{
+	if (M_LIB_CONSOLE__UNLIKELY(_hdl == NULL)) {
+		return 0;
+	}
+	return !M_LIB_CONSOLE__UNLIKELY((unsigned int)_level < ((const struct console_hdl_head*)_hdl)->level);
+}
+
 /* ****************************************************************************
  * function declarations
  * ****************************************************************************/
@@ -82,6 +169,131 @@ int lib_console__print_debug_message(console_hdl_t _hdl, const char * const _for
  * ****************************************************************************/
 int lib_console__vprint_debug_message(console_hdl_t _hdl, const char * const _format, va_list _ap);
 
+/* ************************************************************************//**
+ * \brief	Emergency print for fault handlers and threads. The message is
+ * 			formatted on the stack and written to the transport without
+ * 			heap, blocking txMtx wait or asynchronous ring. Normal output in
+ * 			flight yields, a lock holder which does not release it within
+ * 			M_LIB_CONSOLE__PANIC_WAIT ms is overtaken and the message then
+ * 			bypasses the mirror and the coalescing buffer.
+ * 			From a signal handler the call is best effort: formatting, the
+ * 			clock and the fd transport are async-signal-safe, txMtx is only
+ * 			polled with lib_thread__mutex_trylock, which POSIX does not list
+ * 			as async-signal-safe. A handler interrupting the lock holder
+ * 			waits the full M_LIB_CONSOLE__PANIC_WAIT ms.
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param   _format 	:	"printf" style formatted string argument
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__panic(console_hdl_t _hdl, const char * const _format, ...);
+
+/* ************************************************************************//**
+ * \brief	Emergency print with a variable argument list, see lib_console__panic
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param   _format 	:	"printf" style formatted string argument
+ * \param	_ap		    :	variable argument list
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__vpanic(console_hdl_t _hdl, const char * const _format, va_list _ap);
+
+/* Typed prints of a label, one value and a new line. The value is converted
+ * by table without parsing a format string, e.g.
+ * lib_console__print_u32(hdl, "rx frames: ", count) */
+
+/* ************************************************************************//**
+ * \brief	Prints a label followed by an unsigned value and a new line
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param	_label [IN]	:	text in front of the value, may be NULL
+ * \param	_value [IN]	:	value to print in decimal
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__print_u32(console_hdl_t _hdl, const char *_label, uint32_t _value);
+
+/* ************************************************************************//**
+ * \brief	Prints a label followed by a signed value and a new line
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param	_label [IN]	:	text in front of the value, may be NULL
+ * \param	_value [IN]	:	value to print in decimal
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__print_i64(console_hdl_t _hdl, const char *_label, int64_t _value);
+
+/* ************************************************************************//**
+ * \brief	Prints a label followed by a hex value and a new line, the value
+ * 			is printed in lower case without "0x"
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param	_label [IN]	:	text in front of the value, may be NULL
+ * \param	_value [IN]	:	value to print
+ * \param	_width [IN]	:	minimum number of digits, zero padded, up to 16
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__print_hex(console_hdl_t _hdl, const char *_label, uint64_t _value, unsigned int _width);
+
+/* ************************************************************************//**
+ * \brief	Prints a label followed by a fixed point value and a new line,
+ * 			e.g. 12345 with 3 decimals is printed as "12.345"
+ * \param	_hdl [IN]		:	console handle used for communication
+ * \param	_label [IN]		:	text in front of the value, may be NULL
+ * \param	_value [IN]		:	value in units of 10^-_decimals
+ * \param	_decimals [IN]	:	number of fraction digits, up to 18
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__print_fixed(console_hdl_t _hdl, const char *_label, int64_t _value, unsigned int _decimals);
+
+/* ************************************************************************//**
+ * \brief	Prints a label followed by a string and a new line
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param	_label [IN]	:	text in front of the string, may be NULL
+ * \param	_str [IN]	:	string to print
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__print_str(console_hdl_t _hdl, const char *_label, const char *_str);
+
+/* ************************************************************************//**
+ * \brief	Printout an already formatted message, it is handled like a
+ * 			message of lib_console__print_debug_message
+ * \param	_hdl [IN]		:	console handle used for communication
+ * \param	_data [IN]		:	message, no terminating zero required
+ * \param	_length [IN]	:	number of bytes
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__print_buffer(console_hdl_t _hdl, const char *_data, size_t _length);
+
+/* ************************************************************************//**
+ * \brief	Sets the runtime level of the console, less severe messages of the
+ * 			M_LIB_CONSOLE__PRINT_<LEVEL> macros are discarded
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param	_level [IN]	:	lowest printed level, CONSOLE_LEVEL_OFF disables them
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__set_level(console_hdl_t _hdl, enum console_level _level);
+
+/* ************************************************************************//**
+ * \brief	Returns the runtime level of the console
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \return	level of the console, CONSOLE_LEVEL_OFF for an invalid handle
+ * ****************************************************************************/
+enum console_level lib_console__get_level(console_hdl_t _hdl);
+
+/* ************************************************************************//**
+ * \brief	Sends a deferred message, the format string is replaced by its
+ * 			offset in the format table and the arguments are sent raw.
+ * 			Use it through M_LIB_CONSOLE__LOG.
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param   _format 	:	format string located in the "lib_console_fmt" section
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__log_deferred(console_hdl_t _hdl, const char * const _format, ...);
+
+/* ************************************************************************//**
+ * \brief	Sends a deferred message with a variable argument list
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param   _format 	:	format string located in the "lib_console_fmt" section
+ * \param	_ap		    :	variable argument list
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__vlog_deferred(console_hdl_t _hdl, const char * const _format, va_list _ap);
+
 /* ************************************************************************//**
  * \brief Printout a character on the serial console
  * \param	_hdl [IN]	:	console handle used for communication
@@ -90,6 +302,18 @@ int lib_console__vprint_debug_message(console_hdl_t _hdl, const char * const _fo
  * ****************************************************************************/
 int lib_console__putchar(console_hdl_t _hdl, char _c);
 
+#if M_LIB_CONSOLE__WRITEV
+/* ************************************************************************//**
+ * \brief	Printout several buffers on the serial console as one unit, every
+ * 			new line is sent as "\n\r"
+ * \param	_hdl [IN]		:	console handle used for communication
+ * \param	_iov [IN]		:	buffers to print
+ * \param	_iovcnt [IN]	:	number of buffers
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__writev(console_hdl_t _hdl, const struct iovec *_iov, int _iovcnt);
+#endif
+
 /* ************************************************************************//**
  * \brief	Read of a full console log until the newline is reached
  * \param	_hdl [IN]	 :	console handle used for communication
@@ -109,6 +333,134 @@ int lib_console__getline(console_hdl_t _hdl, char *_lineptr, size_t *_n);
  * ****************************************************************************/
 int lib_console__getdelim(console_hdl_t _hdl, char *_lineptr, size_t *_n, char _delimiter);
 
+/* ************************************************************************//**
+ * \brief	Selects how received bytes are handled. In raw mode getline and
+ * 			getdelim return the bytes as received up to the delimiter, without
+ * 			echo, "\r" translation or editing keys.
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param	_mode [IN]	:	receive mode, CONSOLE_RX_MODE_EDIT by default
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__set_rx_mode(console_hdl_t _hdl, enum console_rx_mode _mode);
+
+/* ************************************************************************//**
+ * \brief	Returns the descriptor that polls readable when the console
+ * 			received data, e.g. to wait on many consoles with poll/epoll
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \return	descriptor, ret< EOK if the transport has none
+ * ****************************************************************************/
+int lib_console__fileno(console_hdl_t _hdl);
+
+/* ************************************************************************//**
+ * \brief	Selects what a print does when the transmission can not keep up.
+ * 			In asynchronous mode the policy applies to a full ring, in
+ * 			synchronous mode to a busy transmission. Dropped messages are
+ * 			counted and announced by a "N messages dropped" line.
+ * 			CONSOLE_OVERFLOW_DROP_OLDEST needs asynchronous mode, stopping it
+ * 			falls back to CONSOLE_OVERFLOW_DROP_NEWEST.
+ * \param	_hdl [IN]		:	console handle used for communication
+ * \param	_policy [IN]		:	overflow policy
+ * \param	_timeoutMs [IN]	:	maximum wait of CONSOLE_OVERFLOW_BLOCK_TIMEOUT
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__set_overflow(console_hdl_t _hdl, enum console_overflow _policy, unsigned int _timeoutMs);
+
+/* ************************************************************************//**
+ * \brief	Returns the number of dropped messages and bytes
+ * \param	_hdl [IN]		:	console handle used for communication
+ * \param	_messages [OUT]	:	dropped messages, may be NULL
+ * \param	_bytes [OUT]		:	dropped bytes, may be NULL
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__get_drops(console_hdl_t _hdl, uint64_t *_messages, uint64_t *_bytes);
+
+/* ************************************************************************//**
+ * \brief	Selects the timestamp put in front of every line of
+ * 			lib_console__print_debug_message and the print macros. The
+ * 			clock is read once per message, while formatting it.
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param	_mode [IN]	:	resolution, CONSOLE_TIMESTAMP_OFF disables it
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__set_timestamp(console_hdl_t _hdl, enum console_timestamp _mode);
+
+/* ************************************************************************//**
+ * \brief	Returns a snapshot of the console counters and of the latency
+ * 			histograms of lock wait, formatting and transport writes
+ * \param	_hdl [IN]		:	console handle used for communication
+ * \param	_stats [OUT]	:	snapshot
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__get_stats(console_hdl_t _hdl, struct console_stats *_stats);
+
+/* ************************************************************************//**
+ * \brief	Estimates a percentile of a histogram
+ * \param	_hist [IN]		:	histogram of lib_console__get_stats
+ * \param	_permille [IN]	:	percentile in 1/1000, e.g. 990 for p99
+ * \return	upper bound of the bucket holding the percentile in ns
+ * ****************************************************************************/
+uint64_t lib_console__stats_percentile(const struct console_histogram *_hist, unsigned int _permille);
+
+/* ************************************************************************//**
+ * \brief	Switches the console into asynchronous transmission. Prints are
+ * 			copied into a ring buffer and sent by a writer thread of the handle.
+ * \param	_hdl [IN]		:	console handle used for communication
+ * \param	_ringSize [IN]	:	size of the transmit ring in bytes, 0 for default
+ * 							or for all of the ring reserved at creation
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__async_start(console_hdl_t _hdl, size_t _ringSize);
+
+/* ************************************************************************//**
+ * \brief	Leaves the asynchronous transmission, pending messages are sent
+ * 			before the writer thread terminates. Must not race with prints.
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__async_stop(console_hdl_t _hdl);
+
+/* ************************************************************************//**
+ * \brief	Gathers the output of the console into a buffer which is written
+ * 			at once, when it is full, on the flush policy or after a delay
+ * 			measured from its first byte. A running configuration is
+ * 			flushed and replaced. Echoed input is never held back. A
+ * 			console of an arena or of the static pool only takes the buffer
+ * 			reserved at creation (console_attr.coalesceSize), it stays off
+ * 			the heap.
+ * \param	_hdl [IN]		:	console handle used for communication
+ * \param	_size [IN]		:	size of the buffer in bytes, 0 disables coalescing
+ * \param	_policy [IN]		:	additional flush point
+ * \param	_delayMs [IN]	:	maximum age of gathered output, 0 for none
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__set_coalesce(console_hdl_t _hdl, size_t _size, enum console_flush _policy, unsigned int _delayMs);
+
+/* ************************************************************************//**
+ * \brief	Writes out the coalesced output. In asynchronous mode the messages
+ * 			queued before the call are sent first.
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__flush(console_hdl_t _hdl);
+
+/* ************************************************************************//**
+ * \brief	Starts the receive engine of the console. A thread of the handle
+ * 			reads, echoes and assembles the input into complete lines, the
+ * 			getline/getdelim calls only dequeue them afterwards.
+ * \param	_hdl [IN]			:	console handle used for communication
+ * \param	_bufferSize [IN]	:	size of the receive buffer in bytes, 0 for default
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__rx_start(console_hdl_t _hdl, size_t _bufferSize);
+
+/* ************************************************************************//**
+ * \brief	Stops the receive engine, it is the counter-part of lib_console__rx_start.
+ * 			Must not race with getline/getdelim calls.
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__rx_stop(console_hdl_t _hdl);
+
 #ifdef __cplusplus
 }
 #endif
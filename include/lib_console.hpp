@@ -0,0 +1,634 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef _LIB_CONSOLE_HPP_
+#define _LIB_CONSOLE_HPP_
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+#error "lib_console.hpp requires C++17"
+#endif
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+
+/* c++-runtime */
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/* frame */
+#include <lib_convention__errno.h>
+
+/* project */
+#include "lib_console.h"
+
+/* ****************************************************************************
+ * defines
+ * ****************************************************************************/
+
+/* Compile time format string of lib_console::console::print. The string is
+ * carried by the type of the returned object, every call site gets its own
+ * parsed and checked formatter, e.g.
+ * con.print(M_LIB_CONSOLE__FMT("rx %u frames on %s\n"), count, name); */
+#define M_LIB_CONSOLE__FMT(_format)														\
+	([] {																				\
+		struct lib_console_format {														\
+			static constexpr std::string_view value() { return std::string_view(_format); }	\
+		};																				\
+		return lib_console_format{};													\
+	}())
+
+/* stack buffer of a print, longer messages continue on the heap */
+#ifndef M_LIB_CONSOLE__CXX_BUFFER_SIZE
+#define M_LIB_CONSOLE__CXX_BUFFER_SIZE	256
+#endif
+
+namespace lib_console {
+namespace detail {
+
+/* ****************************************************************************
+ * format parsing
+ * ****************************************************************************/
+inline constexpr unsigned int c_flagLeft	= 0x01;
+inline constexpr unsigned int c_flagZero	= 0x02;
+inline constexpr unsigned int c_flagPlus	= 0x04;
+inline constexpr unsigned int c_flagSpace	= 0x08;
+inline constexpr unsigned int c_flagAlt		= 0x10;
+
+inline constexpr int c_none = -1;
+inline constexpr int c_star = -2;
+inline constexpr std::size_t c_noError = static_cast<std::size_t>(-1);
+
+/* A literal piece of the format or one conversion. Width and precision are
+ * c_none, a number or c_star, which takes them from the argument list. */
+struct segment {
+	bool literal = true;
+	std::size_t pos = 0;
+	std::size_t len = 0;
+	char conv = '\0';
+	unsigned int flags = 0;
+	int width = c_none;
+	int precision = c_none;
+	std::size_t arg = 0;
+	std::size_t widthArg = 0;
+	std::size_t precisionArg = 0;
+};
+
+template<std::size_t N>
+struct format_table {
+	segment seg[N] = {};
+	std::size_t count = 0;
+	std::size_t args = 0;
+	std::size_t error = c_noError;
+};
+
+/* Supported are the conversions d i u x X o c s p % with the flags - 0 + space #,
+ * width, precision and the length modifiers hh h l ll z, like the C print.
+ * The length modifiers are accepted, the argument type decides the width. */
+template<std::size_t N>
+constexpr format_table<N> parse(std::string_view _format)
+{
+	format_table<N> table{};
+	std::size_t i = 0, literal = 0;
+
+	while (i < _format.size()) {
+		if (_format[i] != '%') {
+			i++;
+			continue;
+		}
+
+		if (i > literal) {
+			table.seg[table.count].pos = literal;
+			table.seg[table.count].len = i - literal;
+			table.count++;
+		}
+
+		segment spec{};
+		spec.literal = false;
+		spec.pos = i++;
+
+		for (;; i++) {
+			if (i >= _format.size()) {
+				break;
+			}
+			else if (_format[i] == '-') {
+				spec.flags |= c_flagLeft;
+			}
+			else if (_format[i] == '0') {
+				spec.flags |= c_flagZero;
+			}
+			else if (_format[i] == '+') {
+				spec.flags |= c_flagPlus;
+			}
+			else if (_format[i] == ' ') {
+				spec.flags |= c_flagSpace;
+			}
+			else if (_format[i] == '#') {
+				spec.flags |= c_flagAlt;
+			}
+			else {
+				break;
+			}
+		}
+
+		if ((i < _format.size()) && (_format[i] == '*')) {
+			spec.width = c_star;
+			spec.widthArg = table.args++;
+			i++;
+		}
+		else {
+			for (; (i < _format.size()) && (_format[i] >= '0') && (_format[i] <= '9'); i++) {
+				spec.width = ((spec.width < 0) ? 0 : spec.width * 10) + (_format[i] - '0');
+			}
+		}
+
+		if ((i < _format.size()) && (_format[i] == '.')) {
+			i++;
+			spec.precision = 0;
+			if ((i < _format.size()) && (_format[i] == '*')) {
+				spec.precision = c_star;
+				spec.precisionArg = table.args++;
+				i++;
+			}
+			else {
+				for (; (i < _format.size()) && (_format[i] >= '0') && (_format[i] <= '9'); i++) {
+					spec.precision = spec.precision * 10 + (_format[i] - '0');
+				}
+			}
+		}
+
+		for (; (i < _format.size()) && ((_format[i] == 'h') || (_format[i] == 'l') || (_format[i] == 'z')); i++) {
+		}
+
+		if (i >= _format.size()) {
+			table.error = spec.pos;
+			return table;
+		}
+
+		spec.conv = _format[i++];
+		switch (spec.conv) {
+			case 'd': case 'i': case 'u': case 'x': case 'X': case 'o':
+			case 'c': case 's': case 'p':
+				spec.arg = table.args++;
+				break;
+			case '%':
+				break;
+			default:
+				table.error = spec.pos;
+				return table;
+		}
+
+		spec.len = i - spec.pos;
+		table.seg[table.count++] = spec;
+		literal = i;
+	}
+
+	if (i > literal) {
+		table.seg[table.count].pos = literal;
+		table.seg[table.count].len = i - literal;
+		table.count++;
+	}
+	return table;
+}
+
+/* parsed once per format type, every segment needs at least one character */
+template<typename FmtT>
+struct format_of {
+	static constexpr std::string_view text = FmtT::value();
+	static constexpr format_table<text.size() + 1> table = parse<text.size() + 1>(text);
+};
+
+/* ****************************************************************************
+ * argument checks
+ * ****************************************************************************/
+template<typename T>
+using bare_t = std::remove_cv_t<std::remove_reference_t<T>>;
+
+template<typename T, typename = void>
+struct is_format : std::false_type {};
+
+template<typename T>
+struct is_format<T, std::void_t<decltype(T::value())>> : std::true_type {};
+
+template<typename T>
+inline constexpr bool is_integer_v = (std::is_integral_v<bare_t<T>> || std::is_enum_v<bare_t<T>>);
+
+template<typename T>
+inline constexpr bool is_string_v = (std::is_convertible_v<const bare_t<T>&, std::string_view> ||
+									 std::is_same_v<std::decay_t<bare_t<T>>, const char*> ||
+									 std::is_same_v<std::decay_t<bare_t<T>>, char*>);
+
+template<typename T>
+inline constexpr bool is_pointer_v = (std::is_pointer_v<std::decay_t<bare_t<T>>> || std::is_null_pointer_v<bare_t<T>>);
+
+template<char Conv, typename T>
+constexpr bool accepts()
+{
+	if constexpr ((Conv == 's')) {
+		return is_string_v<T>;
+	}
+	else if constexpr (Conv == 'p') {
+		return is_pointer_v<T>;
+	}
+	else {
+		return is_integer_v<T>;
+	}
+}
+
+template<typename FmtT, typename Tuple, std::size_t I>
+constexpr bool check_segment()
+{
+	constexpr segment spec = format_of<FmtT>::table.seg[I];
+
+	if constexpr (!spec.literal && (spec.conv != '%')) {
+		static_assert(accepts<spec.conv, std::tuple_element_t<spec.arg, Tuple>>(),
+					  "lib_console: argument type does not match its conversion");
+		if constexpr (spec.width == c_star) {
+			static_assert(is_integer_v<std::tuple_element_t<spec.widthArg, Tuple>>,
+						  "lib_console: \"*\" width needs an integer argument");
+		}
+		if constexpr (spec.precision == c_star) {
+			static_assert(is_integer_v<std::tuple_element_t<spec.precisionArg, Tuple>>,
+						  "lib_console: \"*\" precision needs an integer argument");
+		}
+	}
+	return true;
+}
+
+template<typename FmtT, typename Tuple, std::size_t... I>
+constexpr bool check_segments(std::index_sequence<I...>)
+{
+	return (true && ... && check_segment<FmtT, Tuple, I>());
+}
+
+template<typename FmtT, typename... Args>
+constexpr bool check()
+{
+	using table = format_of<FmtT>;
+
+	static_assert(table::table.error == c_noError, "lib_console: invalid conversion in the format string");
+	static_assert(table::table.args == sizeof...(Args), "lib_console: number of arguments does not match the format string");
+	if constexpr ((table::table.error == c_noError) && (table::table.args == sizeof...(Args))) {
+		return check_segments<FmtT, std::tuple<Args...>>(std::make_index_sequence<table::table.count>{});
+	}
+	else {
+		return false;
+	}
+}
+
+/* ****************************************************************************
+ * output
+ * ****************************************************************************/
+
+/* Collects one message, on the stack as long as it fits */
+class writer {
+public:
+	writer() noexcept : m_data(&m_stack[0]), m_size(0), m_capacity(sizeof(m_stack)) {}
+	writer(const writer&) = delete;
+	writer& operator=(const writer&) = delete;
+
+	void append(const char *_data, std::size_t _len)
+	{
+		if (m_size + _len > m_capacity) {
+			grow(_len);
+		}
+		std::memcpy(&m_data[m_size], _data, _len);
+		m_size += _len;
+	}
+
+	void fill(char _c, std::size_t _count)
+	{
+		if (m_size + _count > m_capacity) {
+			grow(_count);
+		}
+		std::memset(&m_data[m_size], _c, _count);
+		m_size += _count;
+	}
+
+	const char* data() const noexcept { return m_data; }
+	std::size_t size() const noexcept { return m_size; }
+
+private:
+	void grow(std::size_t _len)
+	{
+		std::size_t capacity = 2 * m_capacity;
+
+		if (capacity < m_size + _len) {
+			capacity = m_size + _len;
+		}
+		if (m_heap.empty()) {
+			m_heap.assign(m_data, m_size);
+		}
+		m_heap.resize(capacity);
+		m_data = &m_heap[0];
+		m_capacity = capacity;
+	}
+
+	char m_stack[M_LIB_CONSOLE__CXX_BUFFER_SIZE];
+	std::string m_heap;
+	char *m_data;
+	std::size_t m_size;
+	std::size_t m_capacity;
+};
+
+inline void put_field(writer &_w, unsigned int _flags, int _width, const char *_prefix, std::size_t _prefixLen,
+					  std::size_t _zeros, const char *_body, std::size_t _bodyLen)
+{
+	std::size_t total = _prefixLen + _zeros + _bodyLen;
+	std::size_t pad = ((_width > 0) && (static_cast<std::size_t>(_width) > total)) ? static_cast<std::size_t>(_width) - total : 0;
+
+	if (!(_flags & c_flagLeft)) {
+		_w.fill(' ', pad);
+	}
+	_w.append(_prefix, _prefixLen);
+	_w.fill('0', _zeros);
+	_w.append(_body, _bodyLen);
+	if (_flags & c_flagLeft) {
+		_w.fill(' ', pad);
+	}
+}
+
+template<char Conv, unsigned int Flags, typename T>
+void put_integer(writer &_w, T _value, int _width, int _precision)
+{
+	constexpr int base = ((Conv == 'x') || (Conv == 'X') || (Conv == 'p')) ? 16 : ((Conv == 'o') ? 8 : 10);
+	constexpr bool isSigned = ((Conv == 'd') || (Conv == 'i'));
+	char body[24], prefix[3];
+	std::size_t bodyLen = 0, prefixLen = 0, zeros = 0;
+	unsigned long long magnitude;
+	bool negative = false;
+
+	if constexpr (std::is_signed_v<T>) {
+		negative = (_value < 0);
+		magnitude = negative ? 0ull - static_cast<unsigned long long>(_value) : static_cast<unsigned long long>(_value);
+	}
+	else {
+		magnitude = static_cast<unsigned long long>(_value);
+	}
+
+	if (negative) {
+		prefix[prefixLen++] = '-';
+	}
+	else if constexpr (isSigned && (Flags & c_flagPlus)) {
+		prefix[prefixLen++] = '+';
+	}
+	else if constexpr (isSigned && (Flags & c_flagSpace)) {
+		prefix[prefixLen++] = ' ';
+	}
+
+	if constexpr ((base == 16) && (Flags & c_flagAlt)) {
+		if (magnitude != 0) {
+			prefix[prefixLen++] = '0';
+			prefix[prefixLen++] = (Conv == 'X') ? 'X' : 'x';
+		}
+	}
+
+	/* "%.0d" of zero prints no digits at all */
+	if ((magnitude != 0) || (_precision != 0)) {
+		bodyLen = static_cast<std::size_t>(std::to_chars(&body[0], &body[sizeof(body)], magnitude, base).ptr - &body[0]);
+	}
+	if constexpr (Conv == 'X') {
+		for (std::size_t i = 0; i < bodyLen; i++) {
+			body[i] = ((body[i] >= 'a') && (body[i] <= 'f')) ? static_cast<char>(body[i] - 'a' + 'A') : body[i];
+		}
+	}
+
+	if ((_precision >= 0) && (static_cast<std::size_t>(_precision) > bodyLen)) {
+		zeros = static_cast<std::size_t>(_precision) - bodyLen;
+	}
+	if constexpr ((base == 8) && (Flags & c_flagAlt)) {
+		if ((zeros == 0) && ((bodyLen == 0) || (body[0] != '0'))) {
+			zeros = 1;
+		}
+	}
+
+	/* an explicit precision disables the zero flag */
+	if constexpr ((Flags & c_flagZero) && !(Flags & c_flagLeft)) {
+		std::size_t total = prefixLen + zeros + bodyLen;
+		if ((_precision < 0) && (_width > 0) && (static_cast<std::size_t>(_width) > total)) {
+			zeros += static_cast<std::size_t>(_width) - total;
+		}
+	}
+
+	put_field(_w, Flags, _width, &prefix[0], prefixLen, zeros, &body[0], bodyLen);
+}
+
+template<typename T>
+auto integer_value(const T &_value)
+{
+	if constexpr (std::is_enum_v<T>) {
+		return static_cast<std::underlying_type_t<T>>(_value);
+	}
+	else {
+		return _value;
+	}
+}
+
+template<typename T>
+std::string_view string_value(const T &_value)
+{
+	if constexpr (std::is_pointer_v<T>) {
+		return (_value == nullptr) ? std::string_view("(null)") : std::string_view(_value);
+	}
+	else {
+		return std::string_view(_value);
+	}
+}
+
+template<typename FmtT, std::size_t I, typename Tuple>
+void put_segment(writer &_w, const Tuple &_args)
+{
+	constexpr segment spec = format_of<FmtT>::table.seg[I];
+
+	if constexpr (spec.literal) {
+		_w.append(&format_of<FmtT>::text[spec.pos], spec.len);
+	}
+	else if constexpr (spec.conv == '%') {
+		_w.append("%", 1);
+	}
+	else {
+		const auto &value = std::get<spec.arg>(_args);
+		int width = spec.width;
+		int precision = spec.precision;
+		unsigned int left = 0;
+
+		if constexpr (spec.width == c_star) {
+			width = static_cast<int>(std::get<spec.widthArg>(_args));
+			if (width < 0) {
+				/* a negative "*" width is a "-" flag */
+				width = -width;
+				left = c_flagLeft;
+			}
+		}
+		if constexpr (spec.precision == c_star) {
+			precision = static_cast<int>(std::get<spec.precisionArg>(_args));
+			if (precision < 0) {
+				precision = c_none;
+			}
+		}
+
+		if constexpr (spec.conv == 's') {
+			std::string_view str = string_value(value);
+			if ((precision >= 0) && (static_cast<std::size_t>(precision) < str.size())) {
+				str = str.substr(0, static_cast<std::size_t>(precision));
+			}
+			put_field(_w, spec.flags | left, width, nullptr, 0, 0, str.data(), str.size());
+		}
+		else if constexpr (spec.conv == 'c') {
+			char c = static_cast<char>(value);
+			put_field(_w, spec.flags | left, width, nullptr, 0, 0, &c, 1);
+		}
+		else if constexpr (spec.conv == 'p') {
+			constexpr unsigned int flags = (spec.flags & c_flagLeft) | c_flagAlt;
+			if (left) {
+				put_integer<'p', flags | c_flagLeft>(_w, reinterpret_cast<std::uintptr_t>(value), width, precision);
+			}
+			else {
+				put_integer<'p', flags>(_w, reinterpret_cast<std::uintptr_t>(value), width, precision);
+			}
+		}
+		else {
+			if (left) {
+				put_integer<spec.conv, (spec.flags | c_flagLeft) & ~c_flagZero>(_w, integer_value(value), width, precision);
+			}
+			else {
+				put_integer<spec.conv, spec.flags>(_w, integer_value(value), width, precision);
+			}
+		}
+	}
+}
+
+template<typename FmtT, typename Tuple, std::size_t... I>
+void put_segments(writer &_w, const Tuple &_args, std::index_sequence<I...>)
+{
+	(put_segment<FmtT, I>(_w, _args), ...);
+}
+
+#if defined(__cpp_nontype_template_args) && (__cpp_nontype_template_args >= 201911L)
+/* C++20 string literal as template argument, see console::print<"..."> */
+template<std::size_t N>
+struct fixed_string {
+	constexpr fixed_string(const char (&_str)[N])
+	{
+		for (std::size_t i = 0; i < N; i++) {
+			data[i] = _str[i];
+		}
+	}
+	char data[N] = {};
+};
+
+template<fixed_string S>
+struct literal_format {
+	static constexpr std::string_view value() { return std::string_view(&S.data[0], sizeof(S.data) - 1); }
+};
+#endif
+
+} /* namespace detail */
+
+/* ****************************************************************************
+ * console
+ * ****************************************************************************/
+
+/* Non owning front end of a console handle, the handle is created and
+ * destroyed by lib_console_factory. Every print formats with a formatter
+ * generated for its format string and sends the message in one piece. */
+class console {
+public:
+	explicit console(console_hdl_t _hdl) noexcept : m_hdl(_hdl) {}
+
+	console_hdl_t handle() const noexcept { return m_hdl; }
+
+	/* ************************************************************************//**
+	 * \brief	Printout a message, format and arguments are checked at compile time
+	 * \param	_format [IN]	:	M_LIB_CONSOLE__FMT("...")
+	 * \param	_args [IN]		:	arguments of the conversions, strings are taken
+	 * 							as std::string_view without a copy
+	 * \return	EOK, if successful, ret< EOK if not successful
+	 * ****************************************************************************/
+	template<typename FmtT, typename... Args, typename = std::enable_if_t<detail::is_format<FmtT>::value>>
+	int print(FmtT, const Args&... _args) const
+	{
+		static_assert(detail::check<FmtT, Args...>(), "lib_console: invalid print");
+		detail::writer w;
+
+		detail::put_segments<FmtT>(w, std::forward_as_tuple(_args...),
+								   std::make_index_sequence<detail::format_of<FmtT>::table.count>{});
+		return lib_console__print_buffer(m_hdl, w.data(), w.size());
+	}
+
+	/* ************************************************************************//**
+	 * \brief	Leveled print, nothing is formatted below the console level
+	 * \param	_level [IN]		:	level of the message
+	 * \param	_format [IN]	:	M_LIB_CONSOLE__FMT("...")
+	 * \param	_args [IN]		:	arguments of the conversions
+	 * \return	EOK, if successful, ret< EOK if not successful
+	 * ****************************************************************************/
+	template<typename FmtT, typename... Args>
+	int print(enum console_level _level, FmtT _format, const Args&... _args) const
+	{
+		if ((_level < M_LIB_CONSOLE__LEVEL_MIN) || !lib_console__level_enabled(m_hdl, _level)) {
+			return EOK;
+		}
+		return print(_format, _args...);
+	}
+
+#if defined(__cpp_nontype_template_args) && (__cpp_nontype_template_args >= 201911L)
+	template<detail::fixed_string S, typename... Args>
+	int print(const Args&... _args) const
+	{
+		return print(detail::literal_format<S>{}, _args...);
+	}
+#endif
+
+	/* ************************************************************************//**
+	 * \brief	Printout a message without any format
+	 * \param	_str [IN]	:	message
+	 * \return	EOK, if successful, ret< EOK if not successful
+	 * ****************************************************************************/
+	int write(std::string_view _str) const
+	{
+		return lib_console__print_buffer(m_hdl, _str.data(), _str.size());
+	}
+
+	int putchar(char _c) const { return lib_console__putchar(m_hdl, _c); }
+	int flush() const { return lib_console__flush(m_hdl); }
+	int set_level(enum console_level _level) const { return lib_console__set_level(m_hdl, _level); }
+	enum console_level level() const { return lib_console__get_level(m_hdl); }
+
+private:
+	console_hdl_t m_hdl;
+};
+
+} /* namespace lib_console */
+
+#endif /* _LIB_CONSOLE_HPP_ */
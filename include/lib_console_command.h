@@ -0,0 +1,140 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef _LIB_CONSOLE_COMMAND_H_
+#define _LIB_CONSOLE_COMMAND_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+
+/* c-runtime */
+#include <stddef.h>
+
+/* project */
+#include "lib_console_types.h"
+
+/* ****************************************************************************
+ * defines
+ * ****************************************************************************/
+/* arguments of one command line including the command name */
+#ifndef M_LIB_CONSOLE_COMMAND__MAX_ARGS
+#define M_LIB_CONSOLE_COMMAND__MAX_ARGS		16
+#endif
+
+/* Static registration at file scope, the entries are collected in the
+ * "lib_console_cmd" section and are part of every command table, e.g.
+ * M_LIB_CONSOLE__COMMAND("reset", cmd_reset, NULL, "restarts the device") */
+#if defined(__GNUC__) && defined(__ELF__)
+#define M_LIB_CONSOLE__COMMAND(_name, _fn, _arg, _help)										\
+	static const struct console_command lib_console_cmd_entry_##_fn								\
+		__attribute__((section("lib_console_cmd"), used, aligned(sizeof(void*)))) =				\
+		{ (_name), (_fn), (_arg), (_help) }
+#endif
+
+/* ****************************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ****************************************************************************/
+typedef struct console_command_table_handle *console_command_table_hdl_t;
+
+/* Command handler, _argv[0] is the command name and _argv[_argc] is NULL.
+ * The arguments point into the buffer passed to the dispatch. */
+typedef int (*console_command_fn_t)(console_hdl_t _hdl, int _argc, char *_argv[], void *_arg);
+
+/* command description, it has to stay valid as long as the table uses it */
+struct console_command {
+	const char *name;
+	console_command_fn_t fn;
+	void *arg;
+	const char *help;
+};
+
+/* ****************************************************************************
+ * function declarations
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Creation of a command table holding the statically registered
+ * 			commands and the given ones
+ * \param	_commands [IN]	:	commands to register, may be NULL
+ * \param	_count [IN]		:	number of commands
+ * \return	console_command_table_hdl_t if successfully, NULL if not successful
+ * ****************************************************************************/
+console_command_table_hdl_t lib_console_command__create(const struct console_command *_commands, size_t _count);
+
+/* ************************************************************************//**
+ * \brief	Destroys the command table, it is the counter-part of
+ * 			"lib_console_command__create"
+ * \param	_hdl [IN|OUT]	:	command table handle
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_command__destroy(console_command_table_hdl_t *_hdl);
+
+/* ************************************************************************//**
+ * \brief	Adds a command at runtime, the lookup table is rebuilt. Must not
+ * 			race with lib_console_command__dispatch.
+ * \param	_hdl [IN]		:	command table handle
+ * \param	_command [IN]	:	command to register
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_command__register(console_command_table_hdl_t _hdl, const struct console_command *_command);
+
+/* ************************************************************************//**
+ * \brief	Searches a command by name
+ * \param	_hdl [IN]	:	command table handle
+ * \param	_name [IN]	:	command name
+ * \param	_len [IN]	:	length of the name
+ * \return	command, NULL if it is not registered
+ * ****************************************************************************/
+const struct console_command* lib_console_command__find(console_command_table_hdl_t _hdl, const char *_name, size_t _len);
+
+/* ************************************************************************//**
+ * \brief	Splits a received line into arguments and calls the command.
+ * 			Blanks separate the arguments, double quotes group them, the
+ * 			trailing new line is ignored. Empty lines are skipped. The line is
+ * 			not modified, e.g. the line of a console_line_cb_t can be passed.
+ * \param	_hdl [IN]		:	command table handle
+ * \param	_consoleHdl [IN]:	console passed to the command
+ * \param	_line [IN]		:	received line, it needs no terminator
+ * \param	_len [IN]		:	length of the line
+ * \param	_buffer [OUT]	:	storage of the arguments passed to the command,
+ * 							valid during the call only
+ * \param	_size [IN]		:	size of the buffer, at least _len + 1 bytes
+ * \return	return value of the command, -ESTD_NOENT for an unknown command,
+ * 			ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_command__dispatch(console_command_table_hdl_t _hdl, console_hdl_t _consoleHdl, const char *_line, size_t _len,
+								  char *_buffer, size_t _size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LIB_CONSOLE_COMMAND_H_ */
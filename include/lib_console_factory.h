@@ -35,14 +35,39 @@ extern "C" {
  * includes
  * ****************************************************************************/
 
+/* c-runtime */
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
 /* project */
 #include "lib_console_types.h"
+#include "lib_console_transport.h"
 
 /* ****************************************************************************
  * custom data types (e.g. enumerations, structures, unions)
  * ****************************************************************************/
 typedef struct lib_serial_handle *lib_serial_hdl;
 
+/* caller supplied memory, handed out in order and never given back */
+struct console_arena {
+	uint8_t *base;
+	size_t size;
+	size_t used;
+};
+
+/* Per console sizes, 0 selects the default. The rings are reserved at
+ * creation and taken by lib_console__async_start / lib_console__rx_start,
+ * the coalescing buffer by lib_console__set_coalesce. */
+struct console_attr {
+	size_t rxChunkSize;				/* bytes read from the transport at once */
+	size_t txRingSize;				/* asynchronous transmission ring, 0 reserves none */
+	size_t rxRingSize;				/* line queue of the receive engine, 0 reserves none */
+	struct console_arena *arena;	/* memory source, NULL takes the static pool or the heap */
+	size_t lineSize;				/* longest line of the receive engine and the reactor, 0 takes 128 */
+	size_t coalesceSize;			/* write coalescing buffer, 0 reserves none */
+};
+
 /* ****************************************************************************
  * function declarations
  * ****************************************************************************/
@@ -55,7 +80,50 @@ typedef struct lib_serial_handle *lib_serial_hdl;
 console_hdl_t lib_console_factory__getInstance(const lib_serial_hdl _serialDev);
 
 /* ************************************************************************//**
- * \brief	Destroys the console handle, it is the counter-part of "lib_console_factory__getInstance"
+ * \brief	Creation of a new console handle on top of an arbitrary transport
+ * \param	_transport [IN]	:	transport operations
+ * \param	_ctx [IN]		:	transport specific handle passed to the operations
+ * \return	console_hdl_t if successfully, NULL if not successful
+ * ****************************************************************************/
+console_hdl_t lib_console_factory__getTransportInstance(const struct lib_console_transport *_transport, void *_ctx);
+
+/* ************************************************************************//**
+ * \brief	Creation of a new console handle sized by attributes. The handle
+ * 			and its buffers are one block of the arena or of the static pool
+ * 			(M_LIB_CONSOLE__STATIC_POOL_SIZE), no heap memory is used. A block
+ * 			of an arena or of the pool is not recycled by
+ * 			lib_console_factory__destroy. Without arena and pool the block is
+ * 			allocated on the heap and freed again. Sizes beyond a sixteenth of
+ * 			the address space are rejected.
+ * \param	_attr [IN]		:	sizes and memory source, NULL allocates the
+ * 							defaults on the heap
+ * \param	_transport [IN]	:	transport operations
+ * \param	_ctx [IN]		:	transport specific handle passed to the operations
+ * \return	console_hdl_t if successfully, NULL if not successful
+ * ****************************************************************************/
+console_hdl_t lib_console_factory__create(const struct console_attr *_attr, const struct lib_console_transport *_transport,
+										  void *_ctx);
+
+/* ************************************************************************//**
+ * \brief	Memory a console with these attributes takes from an arena
+ * \param	_attr [IN]	:	sizes of the console
+ * \return	number of bytes including the alignment, 0 for invalid sizes
+ * ****************************************************************************/
+size_t lib_console_factory__memory_size(const struct console_attr *_attr);
+
+/* ************************************************************************//**
+ * \brief	Initializes an arena on memory of the caller
+ * \param	_arena [OUT]	:	arena to initialize
+ * \param	_buffer [IN]	:	memory handed out by the arena
+ * \param	_size [IN]		:	size of _buffer
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_arena__init(struct console_arena *_arena, void *_buffer, size_t _size);
+
+/* ************************************************************************//**
+ * \brief	Destroys the console handle, it is the counter-part of "lib_console_factory__getInstance".
+ * 			The handle is closed and freed once the references taken by
+ * 			lib_console_factory__acquire are released.
  * \param	_hdl [IN|OUT]	:	console handle
  * \return	EOK, if successful, ret< EOK if not successful
  * ****************************************************************************/
@@ -63,16 +131,58 @@ int lib_console_factory__destroy(console_hdl_t *_hdl);
 
 /* ************************************************************************//**
  * \brief	Returns the number of registered consoles 
- * \return	void
+ * \return	number of registered consoles
  * ****************************************************************************/
 unsigned int lib_console_factory__instances(void);
 
 /* ************************************************************************//**
- * \brief Request idx corresponding console 
- * \return	console_hdl_t
+ * \brief Request idx corresponding console, the consoles are counted in
+ * 		  registration order. The console is not referenced, the caller
+ * 		  has to keep it from being destroyed meanwhile.
+ * \param	_idx [IN]	:	index below lib_console_factory__instances
+ * \return	console_hdl_t, NULL if there is no such console
  * ****************************************************************************/
 console_hdl_t lib_console_factory__instance(unsigned int _idx);
 
+/* ************************************************************************//**
+ * \brief	Returns the upper bound of the registry slots. A console keeps
+ * 			its slot until it is destroyed, released slots are reused.
+ * \return	number of slots to pass to lib_console_factory__acquire
+ * ****************************************************************************/
+unsigned int lib_console_factory__slots(void);
+
+/* ************************************************************************//**
+ * \brief	Takes a reference of the console of a registry slot without a
+ * 			lock. The console stays valid until lib_console_factory__release,
+ * 			a destroy waits for it.
+ * \param	_slot [IN]	:	slot below lib_console_factory__slots
+ * \return	console_hdl_t, NULL if no console uses the slot
+ * ****************************************************************************/
+console_hdl_t lib_console_factory__acquire(unsigned int _slot);
+
+/* ************************************************************************//**
+ * \brief	Releases a console of lib_console_factory__acquire
+ * \param	_hdl [IN]	:	console handle
+ * \return	void
+ * ****************************************************************************/
+void lib_console_factory__release(console_hdl_t _hdl);
+
+/* ************************************************************************//**
+ * \brief	Printout a message on all registered consoles. The message is
+ * 			formatted once and the same buffer is sent to every console.
+ * \param   _format 	:	"printf" style formatted string argument
+ * \return	EOK, if successful, ret< EOK if not successful on any console
+ * ****************************************************************************/
+int lib_console_factory__broadcast(const char * const _format, ...);
+
+/* ************************************************************************//**
+ * \brief	Printout a variable argument list message on all registered consoles
+ * \param   _format 	:	"printf" style formatted string argument
+ * \param	_ap		    :	variable argument list
+ * \return	EOK, if successful, ret< EOK if not successful on any console
+ * ****************************************************************************/
+int lib_console_factory__vbroadcast(const char * const _format, va_list _ap);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,111 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _LIB_CONSOLE_MIRROR_H_
+#define _LIB_CONSOLE_MIRROR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+
+/* c-runtime */
+#include <stddef.h>
+
+/* project */
+#include "lib_console_types.h"
+
+/* ****************************************************************************
+ * defines
+ * ****************************************************************************/
+#define M_LIB_CONSOLE_MIRROR__MAGIC		"LCMIRROR"
+#define M_LIB_CONSOLE_MIRROR__VERSION	1
+
+/* ****************************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ****************************************************************************/
+typedef struct console_mirror_handle *console_mirror_hdl_t;
+
+/* A mirror file starts with a header in host byte order, the ring data
+ * follows at headerSize. tools/lib_console_mirror.py extracts the text.
+ *
+ *   char     magic[8]		M_LIB_CONSOLE_MIRROR__MAGIC, not terminated
+ *   uint32_t version		M_LIB_CONSOLE_MIRROR__VERSION
+ *   uint32_t headerSize	offset of the ring data
+ *   uint64_t size			ring data in bytes, a power of two
+ *   uint64_t sequence		number of times the file was opened
+ *   uint64_t head			bytes written since creation, the next at head % size
+ *   uint64_t tail			oldest intact byte
+ *
+ * The bytes [tail, head) are intact at any time: a write first moves tail
+ * over the bytes it overwrites and publishes head after the copy. */
+
+/* ****************************************************************************
+ * function declarations
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Opens a mirror file, a valid file of the same size is continued
+ * 			and keeps its history, any other file is recreated. The file is
+ * 			mapped shared, written bytes survive a crash of the process.
+ * \param	_path [IN]	:	file to map
+ * \param	_size [IN]	:	ring data in bytes, rounded up to a power of two
+ * \return	console_mirror_hdl_t if successfully, NULL if not successful
+ * ****************************************************************************/
+console_mirror_hdl_t lib_console_mirror__open(const char *_path, size_t _size);
+
+/* ************************************************************************//**
+ * \brief	Unmaps the mirror file, it is the counter-part of
+ * 			"lib_console_mirror__open". It must not be attached anymore.
+ * \param	_hdl [IN|OUT]	:	mirror handle
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_mirror__close(console_mirror_hdl_t *_hdl);
+
+/* ************************************************************************//**
+ * \brief	Writes the mapped pages back to the file, a crash of the process
+ * 			does not need it, a loss of power does
+ * \param	_hdl [IN]	:	mirror handle
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_mirror__sync(console_mirror_hdl_t _hdl);
+
+/* ************************************************************************//**
+ * \brief	Mirrors every byte the console writes into the file, including
+ * 			the emergency prints. A mirror serves one console at a time.
+ * \param	_hdl [IN]		:	console handle used for communication
+ * \param	_mirror [IN]	:	mirror handle, NULL detaches the current one
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__set_mirror(console_hdl_t _hdl, console_mirror_hdl_t _mirror);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LIB_CONSOLE_MIRROR_H_ */
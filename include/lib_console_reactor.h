@@ -0,0 +1,91 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef _LIB_CONSOLE_REACTOR_H_
+#define _LIB_CONSOLE_REACTOR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+
+/* project */
+#include "lib_console_types.h"
+
+/* ****************************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ****************************************************************************/
+typedef struct console_reactor_handle *console_reactor_hdl_t;
+
+/* ****************************************************************************
+ * function declarations
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Creation of a reactor serving the received lines of all opened
+ * 			consoles of the factory on the calling thread. Consoles without
+ * 			readiness descriptor (see lib_console__fileno) or with a running
+ * 			receive engine are left out.
+ * \param	_cb [IN]	:	called with every completed line
+ * \param	_arg [IN]	:	argument passed to the callback
+ * \return	console_reactor_hdl_t if successfully, NULL if not successful
+ * ****************************************************************************/
+console_reactor_hdl_t lib_console_reactor__create(console_line_cb_t _cb, void *_arg);
+
+/* ************************************************************************//**
+ * \brief	Destroys the reactor, it is the counter-part of
+ * 			"lib_console_reactor__create"
+ * \param	_hdl [IN|OUT]	:	reactor handle
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_reactor__destroy(console_reactor_hdl_t *_hdl);
+
+/* ************************************************************************//**
+ * \brief	Waits for received data on the consoles and delivers the completed
+ * 			lines. Consoles opened since the last round are added first.
+ * 			Consoles are closed from the callbacks or while no round runs.
+ * \param	_hdl [IN]		:	reactor handle
+ * \param	_timeout [IN]	:	wait time in ms, -1 waits until data or wakeup
+ * \return	number of serviced consoles, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_reactor__run(console_reactor_hdl_t _hdl, int _timeout);
+
+/* ************************************************************************//**
+ * \brief	Returns from a waiting lib_console_reactor__run, e.g. to stop the
+ * 			reactor thread or to pick up a just opened console
+ * \param	_hdl [IN]	:	reactor handle
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_reactor__wakeup(console_reactor_hdl_t _hdl);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LIB_CONSOLE_REACTOR_H_ */
@@ -0,0 +1,154 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef _LIB_CONSOLE_TRANSPORT_H_
+#define _LIB_CONSOLE_TRANSPORT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+
+/* c-runtime */
+#include <stdint.h>
+#include <stddef.h>
+
+/*frame*/
+#include <lib_serial_types.h>
+
+/* ****************************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ****************************************************************************/
+
+/* Byte transport below a console, "_ctx" is the backend specific handle.
+ * read returns the number of received bytes, 0 on timeout. fileno is
+ * optional, it returns a descriptor that polls readable with received data. */
+struct lib_console_transport {
+	int (*open)(void *_ctx, enum baudrate _baudrate, enum data_format _format);
+	int (*close)(void *_ctx);
+	int (*write)(void *_ctx, const uint8_t *_data, unsigned int _length);
+	int (*read)(void *_ctx, uint8_t *_data, unsigned int _length, int _timeout);
+	int (*fileno)(void *_ctx);
+};
+
+typedef struct console_loopback_handle *console_loopback_hdl_t;
+typedef struct console_fd_handle *console_fd_hdl_t;
+
+/* Called with the data written by the console, the buffer is only valid
+ * during the call */
+typedef void (*console_loopback_tap_t)(void *_arg, const uint8_t *_data, unsigned int _length);
+
+/* ****************************************************************************
+ * global variables
+ * ****************************************************************************/
+
+/* lib_serial backend, _ctx is a lib_serial_hdl */
+extern const struct lib_console_transport lib_console_transport__serial;
+/* in-memory backend, _ctx is a console_loopback_hdl_t */
+extern const struct lib_console_transport lib_console_transport__loopback;
+/* file descriptor backend (pty, pipe, socket), _ctx is a console_fd_hdl_t */
+extern const struct lib_console_transport lib_console_transport__fd;
+
+/* ****************************************************************************
+ * function declarations
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Creation of an in-memory transport. Written data is handed to the
+ * 			tap without a copy, received data is injected by the peer.
+ * \param	_size [IN]	:	size of the receive buffer in bytes
+ * \return	console_loopback_hdl_t if successfully, NULL if not successful
+ * ****************************************************************************/
+console_loopback_hdl_t lib_console_loopback__create(size_t _size);
+
+/* ************************************************************************//**
+ * \brief	Destroys the in-memory transport, it is the counter-part of
+ * 			"lib_console_loopback__create"
+ * \param	_hdl [IN|OUT]	:	loopback handle
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_loopback__destroy(console_loopback_hdl_t *_hdl);
+
+/* ************************************************************************//**
+ * \brief	Installs the consumer of the written data, NULL discards it
+ * \param	_hdl [IN]	:	loopback handle
+ * \param	_tap [IN]	:	callback receiving the written data
+ * \param	_arg [IN]	:	argument passed to the callback
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_loopback__set_tap(console_loopback_hdl_t _hdl, console_loopback_tap_t _tap, void *_arg);
+
+/* ************************************************************************//**
+ * \brief	Provides data to be read by the console
+ * \param	_hdl [IN]	:	loopback handle
+ * \param	_data [IN]	:	data to inject
+ * \param	_length [IN]:	number of bytes
+ * \return	number of injected bytes, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_loopback__inject(console_loopback_hdl_t _hdl, const uint8_t *_data, size_t _length);
+
+/* ************************************************************************//**
+ * \brief	Returns the number of bytes and write calls seen by the transport
+ * \param	_hdl [IN]		:	loopback handle
+ * \param	_bytes [OUT]	:	written bytes, may be NULL
+ * \param	_writes [OUT]	:	write calls, may be NULL
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_loopback__counters(console_loopback_hdl_t _hdl, uint64_t *_bytes, uint64_t *_writes);
+
+/* ************************************************************************//**
+ * \brief	Creation of a file descriptor transport
+ * \param	_rdFd [IN]	:	descriptor to read from
+ * \param	_wrFd [IN]	:	descriptor to write to, may equal _rdFd
+ * \return	console_fd_hdl_t if successfully, NULL if not successful
+ * ****************************************************************************/
+console_fd_hdl_t lib_console_fd__create(int _rdFd, int _wrFd);
+
+/* ************************************************************************//**
+ * \brief	Creation of a pseudo terminal transport, the console operates
+ * 			the master side
+ * \param	_slaveName [OUT]	:	path of the slave device to attach to
+ * \param	_size [IN]			:	size of _slaveName
+ * \return	console_fd_hdl_t if successfully, NULL if not successful
+ * ****************************************************************************/
+console_fd_hdl_t lib_console_fd__openpty(char *_slaveName, size_t _size);
+
+/* ************************************************************************//**
+ * \brief	Destroys the file descriptor transport, descriptors opened by
+ * 			"lib_console_fd__openpty" are closed
+ * \param	_hdl [IN|OUT]	:	file descriptor handle
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_fd__destroy(console_fd_hdl_t *_hdl);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LIB_CONSOLE_TRANSPORT_H_ */
@@ -31,12 +31,93 @@
 extern "C" {
 #endif
 
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+/* c -runtime */
+#include <stdint.h>
+#include <stddef.h>
+
+/* ****************************************************************************
+ * defines
+ * ****************************************************************************/
+/* latency histogram, log2 buckets split into 8 linear sub-buckets */
+#define M_LIB_CONSOLE__HIST_SUB_BITS	3
+#define M_LIB_CONSOLE__HIST_BUCKETS		256
+
 /* ****************************************************************************
  * custom data types (e.g. enumerations, structures, unions)
  * ****************************************************************************/
 typedef struct lib_serial_handle *lib_serial_hdl;
 typedef struct console_hdl_handle* console_hdl_t;
 
+/* Receives a completed line including its delimiter, the line is only valid
+ * during the call */
+typedef void (*console_line_cb_t)(void *_arg, console_hdl_t _hdl, const char *_line, size_t _len);
+
+/* severity of a message, a console prints the levels from its own one up */
+enum console_level {
+	CONSOLE_LEVEL_TRACE = 0,
+	CONSOLE_LEVEL_DEBUG,
+	CONSOLE_LEVEL_INFO,
+	CONSOLE_LEVEL_WARN,
+	CONSOLE_LEVEL_ERROR,
+	CONSOLE_LEVEL_OFF
+};
+
+/* behaviour of a print when the transmission can not keep up */
+enum console_overflow {
+	CONSOLE_OVERFLOW_BLOCK = 0,		/* wait until the message is accepted */
+	CONSOLE_OVERFLOW_BLOCK_TIMEOUT,	/* wait up to a timeout, then drop the message */
+	CONSOLE_OVERFLOW_DROP_NEWEST,	/* drop the message to print */
+	CONSOLE_OVERFLOW_DROP_OLDEST	/* drop queued messages to make room */
+};
+
+/* monotonic time in front of every printed line */
+enum console_timestamp {
+	CONSOLE_TIMESTAMP_OFF = 0,
+	CONSOLE_TIMESTAMP_MS,			/* "[    12.345] " */
+	CONSOLE_TIMESTAMP_US			/* "[    12.345678] " */
+};
+
+/* handling of received bytes */
+enum console_rx_mode {
+	CONSOLE_RX_MODE_EDIT = 0,		/* line editing, echo and history, "\r" is enter */
+	CONSOLE_RX_MODE_RAW				/* bytes are passed unchanged, no echo */
+};
+
+/* additional flush point of coalesced output, see lib_console__set_coalesce */
+enum console_flush {
+	CONSOLE_FLUSH_FULL = 0,			/* only a full buffer, the delay or lib_console__flush */
+	CONSOLE_FLUSH_LINE				/* also every write containing a new line */
+};
+
+struct console_histogram {
+	uint64_t count;
+	uint64_t sumNs;
+	uint64_t maxNs;
+	uint64_t bucket[M_LIB_CONSOLE__HIST_BUCKETS];
+};
+
+struct console_stats {
+	uint64_t messages;			/* accepted prints */
+	uint64_t bytes;				/* bytes handed to the transport */
+	uint64_t streamed;			/* messages beyond the format buffer */
+	uint64_t truncations;		/* messages sent with cut content */
+	uint64_t serialErrors;		/* failed transport writes */
+	uint64_t dropMessages;		/* see lib_console__set_overflow */
+	uint64_t dropBytes;
+	struct console_histogram lockWait;	/* waiting for the transmission */
+	struct console_histogram format;	/* formatting a message */
+	struct console_histogram write;		/* transport write calls */
+};
+
+/* Public head of every console handle. It is read by the level macros
+ * without a function call, written by lib_console__set_level. */
+struct console_hdl_head {
+	volatile unsigned char level;
+};
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,136 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef _LIB_CONSOLE_EDITOR_H_
+#define _LIB_CONSOLE_EDITOR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+/* c -runtime */
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* ****************************************************************************
+ * defines
+ * ****************************************************************************/
+/* default line size, also the size of the history entries */
+#define M_LIB_CONSOLE_EDITOR__LINE_SIZE		128
+#define M_LIB_CONSOLE_EDITOR__HISTORY_DEPTH	8
+/* a key redrawing up to a history entry plus cursor control, redraws of
+ * longer lines go out through the echo callback */
+#define M_LIB_CONSOLE_EDITOR__KEY_ECHO_MAX	(M_LIB_CONSOLE_EDITOR__LINE_SIZE + 16)
+#define M_LIB_CONSOLE_EDITOR__ECHO_SIZE		(2 * M_LIB_CONSOLE_EDITOR__KEY_ECHO_MAX)
+
+/* ****************************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ****************************************************************************/
+/* sends echo which does not fit into the echo buffer anymore */
+typedef void (*console_editor_echo_t)(void *_arg, const char *_data, size_t _len);
+
+struct console_editor_entry {
+	char line[M_LIB_CONSOLE_EDITOR__LINE_SIZE];
+	size_t len;
+};
+
+struct console_editor {
+	/* line under edit, terminated lines keep their delimiter. It is the
+	   buffer of the caller or the line storage of the console. */
+	char *line;
+	char *storage;
+	size_t storageSize;
+	size_t len;
+	size_t cursor;
+	size_t capacity;
+	/* escape sequence parser */
+	unsigned int escState;
+	unsigned int escParam;
+	bool lastCr;
+	/* history, "draft" keeps the line under edit while browsing */
+	struct console_editor_entry history[M_LIB_CONSOLE_EDITOR__HISTORY_DEPTH];
+	struct console_editor_entry draft;
+	unsigned int histCount;
+	unsigned int histNewest;
+	unsigned int histBrowse;
+	/* echo and redraw output collected over one input batch */
+	char echo[M_LIB_CONSOLE_EDITOR__ECHO_SIZE];
+	size_t echoLen;
+	console_editor_echo_t echoCb;
+	void *echoArg;
+};
+
+/* ****************************************************************************
+ * function declarations
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Initializes the editor with an empty history
+ * \param	_editor [OUT]	:	editor to initialize
+ * \param	_storage [IN]	:	line storage used without a caller buffer
+ * \param	_size [IN]		:	size of _storage
+ * \param	_echoCb [IN]	:	sends echo exceeding the echo buffer
+ * \param	_echoArg [IN]	:	argument passed to the echo callback
+ * \return	void
+ * ****************************************************************************/
+void lib_console_editor__init(struct console_editor *_editor, char *_storage, size_t _size,
+							  console_editor_echo_t _echoCb, void *_echoArg);
+
+/* ************************************************************************//**
+ * \brief	Starts a new line
+ * \param	_editor [IN|OUT]	:	editor to use
+ * \param	_line [OUT]			:	buffer the line is edited in, NULL takes
+ * 								the line storage of the editor
+ * \param	_capacity [IN]		:	maximum line length including the delimiter,
+ * 								0 takes the full line storage
+ * \return	void
+ * ****************************************************************************/
+void lib_console_editor__begin(struct console_editor *_editor, char *_line, size_t _capacity);
+
+/* ************************************************************************//**
+ * \brief	Feeds received bytes into the editor. Processing stops as soon as a
+ * 			line is complete or the echo buffer has to be flushed.
+ * \param	_editor [IN|OUT]	:	editor to use
+ * \param	_data [IN]			:	received bytes
+ * \param	_len [IN]			:	number of received bytes
+ * \param	_delimiter [IN]		:	character terminating the line, enter ends
+ * 								the line only for '\n' and is a new line
+ * 								character of the line otherwise
+ * \param	_complete [OUT]		:	true if the line is complete
+ * \return	number of consumed bytes
+ * ****************************************************************************/
+size_t lib_console_editor__feed(struct console_editor *_editor, const uint8_t *_data, size_t _len,
+								char _delimiter, bool *_complete);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LIB_CONSOLE_EDITOR_H_ */
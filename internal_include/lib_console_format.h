@@ -0,0 +1,109 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef _LIB_CONSOLE_FORMAT_H_
+#define _LIB_CONSOLE_FORMAT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+/* c -runtime */
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+/* ****************************************************************************
+ * defines
+ * ****************************************************************************/
+/* digits of the largest 64 bit value in decimal */
+#define M_LIB_CONSOLE_FORMAT__DEC_MAX	20
+
+/* ****************************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ****************************************************************************/
+
+/* Called whenever the chunk buffer is full, returns ret < EOK to abort the
+ * formatting */
+typedef int (*console_format_flush_t)(void *_arg, const char *_data, size_t _len);
+
+struct console_format_stream {
+	char *buffer;
+	size_t size;
+	size_t pos;
+	console_format_flush_t flush;
+	void *arg;
+	size_t total;
+	char last;
+};
+
+/* ****************************************************************************
+ * function declarations
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Formats a "printf" style message chunk by chunk. Supported are the
+ * 			conversions d i u x X o c s p % with the flags - 0 + space #,
+ * 			width, precision and the length modifiers hh h l ll z, the latter
+ * 			only on the integer conversions. An unknown conversion is copied
+ * 			unchanged and takes no argument. Only full chunks are flushed, the last one stays in the buffer (pos bytes),
+ * 			so a message fitting the buffer is formatted without any flush.
+ * \param	_stream [IN|OUT]	:	chunk buffer and flush callback
+ * \param   _format 			:	"printf" style formatted string argument
+ * \param	_ap		    		:	variable argument list
+ * \return	EOK, if successful, ret< EOK returned by the flush callback
+ * ****************************************************************************/
+int lib_console_format__vstream(struct console_format_stream *_stream, const char *_format, va_list _ap);
+
+/* ************************************************************************//**
+ * \brief	Converts a value to decimal digits, two digits per step. The
+ * 			digits are written backwards and end right in front of _end.
+ * \param	_end [OUT]	:	end of the digits, M_LIB_CONSOLE_FORMAT__DEC_MAX
+ * 						bytes in front of it have to be writable
+ * \param	_value [IN]	:	value to convert
+ * \return	first digit
+ * ****************************************************************************/
+char* lib_console_format__dec(char *_end, uint64_t _value);
+
+/* ************************************************************************//**
+ * \brief	Converts a value to lower case hex digits, one byte per step.
+ * 			The digits are written backwards and end right in front of _end.
+ * \param	_end [OUT]		:	end of the digits, 16 bytes in front of it have
+ * 							to be writable
+ * \param	_value [IN]		:	value to convert
+ * \param	_width [IN]		:	minimum number of digits, zero padded, up to 16
+ * \return	first digit
+ * ****************************************************************************/
+char* lib_console_format__hex(char *_end, uint64_t _value, unsigned int _width);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LIB_CONSOLE_FORMAT_H_ */
@@ -0,0 +1,79 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+#ifndef _LIB_CONSOLE_NEWLINE_H_
+#define _LIB_CONSOLE_NEWLINE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+/* c -runtime */
+#include <stddef.h>
+
+/* ****************************************************************************
+ * function declarations
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Searches the first new line of a buffer
+ * \param	_data [IN]	:	buffer to search
+ * \param	_len [IN]	:	number of bytes
+ * \return	index of the first '\n', _len if there is none
+ * ****************************************************************************/
+size_t lib_console_newline__find(const char *_data, size_t _len);
+
+/* ************************************************************************//**
+ * \brief	Counts the new lines of a buffer, it is the number of bytes the
+ * 			translation adds
+ * \param	_data [IN]	:	buffer to search
+ * \param	_len [IN]	:	number of bytes
+ * \return	number of '\n'
+ * ****************************************************************************/
+size_t lib_console_newline__count(const char *_data, size_t _len);
+
+/* ************************************************************************//**
+ * \brief	Copies a buffer and sends every '\n' as "\n\r". The text between
+ * 			the new lines is block copied, a new line is never split from
+ * 			its carriage return.
+ * \param	_dst [OUT]			:	translated text
+ * \param	_size [IN]			:	size of _dst, at least 2 bytes
+ * \param	_src [IN]			:	text to translate
+ * \param	_len [IN]			:	number of bytes of _src
+ * \param	_consumed [OUT]		:	number of bytes of _src translated
+ * \return	number of bytes written to _dst
+ * ****************************************************************************/
+size_t lib_console_newline__translate(char *_dst, size_t _size, const char *_src, size_t _len, size_t *_consumed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LIB_CONSOLE_NEWLINE_H_ */
@@ -0,0 +1,165 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef _LIB_CONSOLE_RING_H_
+#define _LIB_CONSOLE_RING_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+/* c -runtime */
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/* ****************************************************************************
+ * defines
+ * ****************************************************************************/
+#define M_LIB_CONSOLE_RING__MIN_SIZE	256
+
+/* ****************************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ****************************************************************************/
+
+/* Multi-producer / single-consumer message ring.
+ * Producers reserve space with a CAS on "head", copy their record without any
+ * lock and publish it by advancing "commit" in reservation order. The consumer
+ * copies committed records out and releases them with a CAS on "tail", so
+ * producers may discard the oldest record with a CAS on "tail" as well. */
+struct console_ring {
+	uint8_t *buffer;
+	size_t size;
+	/* storage allocated by lib_console_ring__init, freed by cleanup */
+	bool owned;
+	atomic_size_t head;
+	atomic_size_t commit;
+	atomic_size_t tail;
+};
+
+/* ****************************************************************************
+ * function declarations
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Allocates the ring storage, the size is rounded up to a power of two
+ * \param	_ring [IN|OUT]	:	ring to initialize
+ * \param	_size [IN]		:	requested storage size in bytes
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_ring__init(struct console_ring *_ring, size_t _size);
+
+/* ************************************************************************//**
+ * \brief	Initializes the ring on storage of the caller, cleanup leaves it
+ * \param	_ring [IN|OUT]	:	ring to initialize
+ * \param	_buffer [IN]		:	storage of the ring
+ * \param	_size [IN]		:	storage size, see lib_console_ring__storage_size
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_ring__init_static(struct console_ring *_ring, uint8_t *_buffer, size_t _size);
+
+/* ************************************************************************//**
+ * \brief	Storage size of a ring, the requested size rounded up to a power of two
+ * \param	_size [IN]	:	requested storage size in bytes
+ * \return	storage size in bytes
+ * ****************************************************************************/
+size_t lib_console_ring__storage_size(size_t _size);
+
+/* ************************************************************************//**
+ * \brief	Frees the ring storage, it is the counter-part of lib_console_ring__init
+ * \param	_ring [IN|OUT]	:	ring to cleanup
+ * \return	void
+ * ****************************************************************************/
+void lib_console_ring__cleanup(struct console_ring *_ring);
+
+/* ************************************************************************//**
+ * \brief	Largest payload a single record can carry
+ * \param	_ring [IN]	:	ring to query
+ * \return	maximum payload length in bytes
+ * ****************************************************************************/
+size_t lib_console_ring__max_payload(const struct console_ring *_ring);
+
+/* ************************************************************************//**
+ * \brief	Reserves a record of _len payload bytes
+ * \param	_ring [IN]	:	ring to reserve space in
+ * \param	_len [IN]	:	payload length
+ * \param	_pos [OUT]	:	record position, to be passed to lib_console_ring__commit
+ * \return	pointer to the payload area, NULL if the ring is full
+ * ****************************************************************************/
+uint8_t* lib_console_ring__reserve(struct console_ring *_ring, size_t _len, size_t *_pos);
+
+/* ************************************************************************//**
+ * \brief	Publishes a record reserved by lib_console_ring__reserve
+ * \param	_ring [IN]	:	ring the record was reserved in
+ * \param	_pos [IN]	:	record position returned by the reservation
+ * \return	void
+ * ****************************************************************************/
+void lib_console_ring__commit(struct console_ring *_ring, size_t _pos);
+
+/* ************************************************************************//**
+ * \brief	Copies a message into the ring as one record
+ * \param	_ring [IN]	:	ring to push to
+ * \param	_data [IN]	:	message
+ * \param	_len [IN]	:	message length
+ * \return	EOK, -ESTD_AGAIN if the ring is full, -ESTD_MSGSIZE if the message
+ * 			can never fit
+ * ****************************************************************************/
+int lib_console_ring__push(struct console_ring *_ring, const uint8_t *_data, size_t _len);
+
+/* ************************************************************************//**
+ * \brief	Copies as many committed records as fit into _dst and releases them
+ * \param	_ring [IN]	:	ring to pop from (single consumer only)
+ * \param	_dst [OUT]	:	destination buffer
+ * \param	_size [IN]	:	destination size, at least lib_console_ring__max_payload
+ * \return	number of bytes copied, 0 if no committed record is pending
+ * ****************************************************************************/
+size_t lib_console_ring__pop(struct console_ring *_ring, uint8_t *_dst, size_t _size);
+
+/* ************************************************************************//**
+ * \brief	Discards the oldest committed record, may be called by producers
+ * 			concurrently to the consumer
+ * \param	_ring [IN]	:	ring to discard from
+ * \param	_len [OUT]	:	payload length of the discarded record
+ * \return	EOK, -ESTD_AGAIN if no committed record is pending
+ * ****************************************************************************/
+int lib_console_ring__drop(struct console_ring *_ring, size_t *_len);
+
+/* ************************************************************************//**
+ * \brief	Checks if committed records are pending
+ * \param	_ring [IN]	:	ring to query
+ * \return	true if no committed record is pending
+ * ****************************************************************************/
+bool lib_console_ring__empty(struct console_ring *_ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LIB_CONSOLE_RING_H_ */
@@ -0,0 +1,143 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef _LIB_CONSOLE_STATS_H_
+#define _LIB_CONSOLE_STATS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+/* c -runtime */
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <time.h>
+
+/* project */
+#include <lib_console_types.h>
+
+/* ****************************************************************************
+ * Configuration
+ * ****************************************************************************/
+#ifndef M_LIB_CONSOLE__STATS
+#define M_LIB_CONSOLE__STATS	1
+#endif
+
+/* ****************************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ****************************************************************************/
+
+/* Writers only use relaxed increments, a snapshot may mix concurrent updates */
+struct console_histogram_data {
+	atomic_uint_least64_t count;
+	atomic_uint_least64_t sumNs;
+	atomic_uint_least64_t maxNs;
+	atomic_uint_least64_t bucket[M_LIB_CONSOLE__HIST_BUCKETS];
+};
+
+struct console_stats_data {
+	atomic_uint_least64_t messages;
+	atomic_uint_least64_t bytes;
+	atomic_uint_least64_t streamed;
+	atomic_uint_least64_t truncations;
+	atomic_uint_least64_t serialErrors;
+	struct console_histogram_data lockWait;
+	struct console_histogram_data format;
+	struct console_histogram_data write;
+};
+
+/* ****************************************************************************
+ * function declarations
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Copies the histogram counters into the public representation
+ * \param	_data [IN]	:	histogram to read
+ * \param	_hist [OUT]	:	snapshot
+ * \return	void
+ * ****************************************************************************/
+void lib_console_stats__snapshot(struct console_histogram_data *_data, struct console_histogram *_hist);
+
+/* ****************************************************************************
+ * inline functions
+ * ****************************************************************************/
+static inline uint64_t lib_console_stats__now(void)
+{
+#if M_LIB_CONSOLE__STATS && defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#else
+	return 0;
+#endif
+}
+
+static inline unsigned int lib_console_stats__bucket(uint64_t _ns)
+{
+	unsigned int exponent, idx;
+
+	if (_ns < (1u << M_LIB_CONSOLE__HIST_SUB_BITS)) {
+		return (unsigned int)_ns;
+	}
+
+	/* position of the highest bit selects the range, the next bits the sub-bucket */
+	exponent = 63u - (unsigned int)__builtin_clzll(_ns);
+	idx = ((exponent - M_LIB_CONSOLE__HIST_SUB_BITS + 1) << M_LIB_CONSOLE__HIST_SUB_BITS) +
+		  (unsigned int)((_ns >> (exponent - M_LIB_CONSOLE__HIST_SUB_BITS)) & ((1u << M_LIB_CONSOLE__HIST_SUB_BITS) - 1));
+	return (idx < M_LIB_CONSOLE__HIST_BUCKETS) ? idx : M_LIB_CONSOLE__HIST_BUCKETS - 1;
+}
+
+static inline void lib_console_stats__record(struct console_histogram_data *_hist, uint64_t _start)
+{
+#if M_LIB_CONSOLE__STATS && defined(CLOCK_MONOTONIC)
+	uint64_t ns = lib_console_stats__now() - _start;
+	uint64_t max = atomic_load_explicit(&_hist->maxNs, memory_order_relaxed);
+
+	atomic_fetch_add_explicit(&_hist->count, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&_hist->sumNs, ns, memory_order_relaxed);
+	atomic_fetch_add_explicit(&_hist->bucket[lib_console_stats__bucket(ns)], 1, memory_order_relaxed);
+	while ((ns > max) && !atomic_compare_exchange_weak_explicit(&_hist->maxNs, &max, ns,
+																 memory_order_relaxed, memory_order_relaxed)) {
+	}
+#endif
+}
+
+static inline void lib_console_stats__add(atomic_uint_least64_t *_counter, uint64_t _value)
+{
+#if M_LIB_CONSOLE__STATS
+	atomic_fetch_add_explicit(_counter, _value, memory_order_relaxed);
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LIB_CONSOLE_STATS_H_ */
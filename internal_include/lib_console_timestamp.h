@@ -0,0 +1,96 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+
+#ifndef _LIB_CONSOLE_TIMESTAMP_H_
+#define _LIB_CONSOLE_TIMESTAMP_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+/* c -runtime */
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+
+/* project */
+#include <lib_console_types.h>
+
+/* ****************************************************************************
+ * defines
+ * ****************************************************************************/
+/* "[" seconds "." fraction "] ", seconds take at least 5 digits */
+#define M_LIB_CONSOLE_TIMESTAMP__SIZE		32
+#define M_LIB_CONSOLE_TIMESTAMP__SECONDS	5
+
+/* ****************************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ****************************************************************************/
+
+/* Last rendered prefix, a new value only rewrites the digits that changed */
+struct console_timestamp_cache {
+	enum console_timestamp mode;
+	uint64_t value;		/* rendered value in ms or us */
+	uint64_t limit;		/* first value needing a wider field */
+	size_t dot;
+	size_t last;		/* index of the last fraction digit */
+	size_t len;
+	char text[M_LIB_CONSOLE_TIMESTAMP__SIZE];
+};
+
+/* ****************************************************************************
+ * function declarations
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Updates the cached prefix to a new time
+ * \param	_cache [IN|OUT]	:	prefix of the previous call, zero initialized
+ * 								before the first one
+ * \param	_mode [IN]		:	resolution of the prefix, not CONSOLE_TIMESTAMP_OFF
+ * \param	_ns [IN]		:	monotonic time in ns
+ * \return	length of the prefix in _cache->text
+ * ****************************************************************************/
+size_t lib_console_timestamp__render(struct console_timestamp_cache *_cache, enum console_timestamp _mode, uint64_t _ns);
+
+/* ****************************************************************************
+ * inline functions
+ * ****************************************************************************/
+static inline uint64_t lib_console_timestamp__now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LIB_CONSOLE_TIMESTAMP_H_ */
@@ -36,37 +36,264 @@ extern "C" {
  * ****************************************************************************/
 /* c -runtime */
 #include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
 /* frame */
+#include <lib_convention__errno.h>
 #include <lib_thread.h>
-#include <lib_list_types.h>
 /* project */
 #include <lib_console_types.h>
+#include <lib_console_transport.h>
+#include <lib_console_ring.h>
+#include <lib_console_editor.h>
+#include <lib_console_stats.h>
 
 
 /* ****************************************************************************
  * defines
  * ****************************************************************************/
 #define M_LIB_CONSOLE__TX_BUFFER_SIZE 	200
+/* default receive chunk, lib_console_factory__create sizes it per console */
 #define M_LIB_CONSOLE__RX_BUFFER_SIZE	50
+/* translation buffer of multi line text, "\n" becomes "\n\r" */
+#define M_LIB_CONSOLE__TEXT_CHUNK_SIZE	512
 #define M_LIB_CONSOLE__OPENED			0xAAAAFFFF
+/* mirror files are mapped, see lib_console_mirror.h */
+#if defined(__unix__) || defined(__APPLE__)
+#define M_LIB_CONSOLE__MIRROR			1
+#else
+#define M_LIB_CONSOLE__MIRROR			0
+#endif
 
 /* ****************************************************************************
  * Configuration
  * ****************************************************************************/
 #define M_LIB_CONSOLE__INTER_FRAME_TIMEOUT		100
+#define M_LIB_CONSOLE__TX_RING_SIZE				4096
+#define M_LIB_CONSOLE__RX_RING_SIZE				1024
+/* received chunks processed per console and reactor round */
+#define M_LIB_CONSOLE__REACTOR_BURST			8
+#ifndef M_LIB_CONSOLE__MAX_INSTANCES
+#define M_LIB_CONSOLE__MAX_INSTANCES			64
+#endif
+/* stack buffer of lib_console__panic, the message is truncated to it */
+#ifndef M_LIB_CONSOLE__PANIC_BUFFER_SIZE
+#define M_LIB_CONSOLE__PANIC_BUFFER_SIZE		256
+#endif
+/* time in ms lib_console__panic waits for txMtx before the transport is taken over */
+#ifndef M_LIB_CONSOLE__PANIC_WAIT
+#define M_LIB_CONSOLE__PANIC_WAIT				10
+#endif
+/* memory of lib_console_factory__create without arena, 0 takes the heap instead */
+#ifndef M_LIB_CONSOLE__STATIC_POOL_SIZE
+#define M_LIB_CONSOLE__STATIC_POOL_SIZE			0
+#endif
 
 /* ****************************************************************************
  * custom data types (e.g. enumerations, structures, unions)
  * ****************************************************************************/
+
+/* Receives a completed line of lib_console__rx_poll, false if the console
+ * was closed meanwhile and must not be touched anymore */
+typedef bool (*console_rx_line_t)(void *_arg, console_hdl_t _hdl, const char *_line, size_t _len);
+
 struct console_hdl_handle {
+	/* has to stay the first member, see lib_console__level_enabled */
+	struct console_hdl_head head;
 	thread_hdl_t rxThd;
-	lib_serial_hdl serialDev;
-	char txBuffer[M_LIB_CONSOLE__TX_BUFFER_SIZE];
+	const struct lib_console_transport *transport;
+	void *transportCtx;
 	mutex_hdl_t	txMtx;
 	uint32_t initialized;
-	struct list_node node;
+	unsigned int registryIdx;
+	/* references of the registry and of lib_console_factory__acquire callers */
+	atomic_uint refs;
+	/* line storage of the editor for the receive engine and the reactor */
+	char *rxLine;
+	size_t rxLineSize;
+	/* sequence number of the deferred records */
+	atomic_uint logSeq;
+	/* asynchronous transmission */
+	thread_hdl_t txThd;
+	struct console_ring txRing;
+	uint8_t *txStage;
+	sem_hdl_t txSem;
+	sem_hdl_t txSpaceSem;
+	atomic_uint txSleeping;
+	atomic_uint txWaiters;
+	atomic_bool txStop;
+	bool txAsync;
+	/* overflow handling, txDropPending is reported once output resumes */
+	enum console_overflow txPolicy;
+	unsigned int txTimeout;
+	/* prints of CONSOLE_OVERFLOW_BLOCK_TIMEOUT waiting for txMtx, every release posts txLockSem */
+	atomic_uint txLockWaiters;
+	sem_hdl_t txLockSem;
+	atomic_uint_least64_t txDropMsgs;
+	atomic_uint_least64_t txDropBytes;
+	atomic_uint txDropPending;
+	/* emergency prints in flight, normal output yields the transport to them */
+	atomic_uint txPanic;
+	/* write coalescing under txMtx, the flush thread empties it after txFlushDelay */
+	uint8_t *txCoalesce;
+	size_t txCoalesceSize;
+	size_t txCoalesceLen;
+	enum console_flush txFlushPolicy;
+	unsigned int txFlushDelay;
+	cond_hdl_t txFlushCond;
+	thread_hdl_t txFlushThd;
+	bool txFlushStop;
+	/* ring position written out by the writer thread, lib_console__flush
+	   waits on txDrainCond under txMtx until it passes its target */
+	size_t txSent;
+	cond_hdl_t txDrainCond;
+	atomic_uint txDrainWaiters;
+	/* mapped file receiving a copy of the output, see lib_console__set_mirror */
+	struct console_mirror_handle *mirror;
+	/* counters and latency histograms, see lib_console__get_stats */
+	struct console_stats_data stats;
+	/* line timestamps, a prefix is only put in front of a new line */
+	enum console_timestamp tsMode;
+	atomic_bool tsLineStart;
+	/* line editing, bytes behind a line are kept in rxPending */
+	enum console_rx_mode rxMode;
+	struct console_editor editor;
+	uint8_t *rxPending;
+	size_t rxPendingSize;
+	size_t rxPendingLen;
+	size_t rxPendingPos;
+	/* receive engine, queue of complete lines */
+	mutex_hdl_t rxMtx;
+	cond_hdl_t rxCond;
+	uint8_t *rxBuffer;
+	size_t rxSize;
+	size_t rxCommit;
+	size_t rxTail;
+	atomic_bool rxStop;
+	bool rxActive;
+	/* reactor serving the received lines, see lib_console_reactor__run */
+	struct console_reactor_handle *reactor;
+	/* memory reserved by lib_console_factory__create, a pooled handle is not freed */
+	uint8_t *txReserved;
+	size_t txReservedSize;
+	uint8_t *rxReserved;
+	size_t rxReservedSize;
+	uint8_t *coalesceReserved;
+	size_t coalesceReservedSize;
+	bool pooled;
 };
 
+_Static_assert(offsetof(struct console_hdl_handle, head) == 0, "public head must start the handle");
+
+/* ****************************************************************************
+ * function declarations
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Sends an already formatted message as one unit, no new line
+ * 			translation is applied
+ * \param	_hdl [IN]		:	console handle used for communication
+ * \param	_data [IN]		:	message to send, it is not modified
+ * \param	_length [IN]	:	number of bytes
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__write_message(console_hdl_t _hdl, const uint8_t *_data, unsigned int _length);
+
+/* ************************************************************************//**
+ * \brief	Appends to the coalescing buffer, called with txMtx held
+ * \param	_hdl [IN]		:	console handle used for communication
+ * \param	_data [IN]		:	data to send
+ * \param	_length [IN]	:	number of bytes
+ * \return	number of accepted bytes, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__coalesce_write(console_hdl_t _hdl, const void *_data, unsigned int _length);
+
+/* ************************************************************************//**
+ * \brief	Copies written bytes into the mirror file, called with txMtx held
+ * 			or by an emergency print
+ * \param	_hdl [IN]		:	mirror handle
+ * \param	_data [IN]		:	written bytes
+ * \param	_length [IN]	:	number of bytes
+ * \return	void
+ * ****************************************************************************/
+void lib_console_mirror__append(struct console_mirror_handle *_hdl, const void *_data, size_t _length);
+
+/* ************************************************************************//**
+ * \brief	Processes the received data without waiting, every completed line
+ * 			is handed to the callback. A line may span several calls.
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param	_cb [IN]	:	called with every completed line
+ * \param	_arg [IN]	:	argument passed to the callback
+ * \return	EOK, if successful, ret< EOK if the transport failed
+ * ****************************************************************************/
+int lib_console__rx_poll(console_hdl_t _hdl, console_rx_line_t _cb, void *_arg);
+
+/* ************************************************************************//**
+ * \brief	Removes a closing console from its reactor
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \return	void
+ * ****************************************************************************/
+void lib_console_reactor__detach(console_hdl_t _hdl);
+
+/* ****************************************************************************
+ * inline functions
+ * ****************************************************************************/
+static inline void lib_console__tx_wake(console_hdl_t _hdl)
+{
+	if (atomic_load(&_hdl->txLockWaiters) != 0) {
+		lib_thread__sem_post(_hdl->txLockSem);
+	}
+}
+
+/* every release of txMtx goes through here, a timed waiter sleeps until it */
+static inline void lib_console__tx_unlock(console_hdl_t _hdl)
+{
+	lib_thread__mutex_unlock(_hdl->txMtx);
+	lib_console__tx_wake(_hdl);
+}
+
+static inline int lib_console__transport_send(console_hdl_t _hdl, const void *_data, unsigned int _length)
+{
+	uint64_t start = lib_console_stats__now();
+	int ret;
+
+	ret = _hdl->transport->write(_hdl->transportCtx, (const uint8_t*)_data, _length);
+	lib_console_stats__record(&_hdl->stats.write, start);
+	if (ret < EOK) {
+		lib_console_stats__add(&_hdl->stats.serialErrors, 1);
+	}
+	else {
+		lib_console_stats__add(&_hdl->stats.bytes, _length);
+	}
+	return ret;
+}
+
+static inline int lib_console__transport_write(console_hdl_t _hdl, const void *_data, unsigned int _length)
+{
+	/* an emergency print owns the transport, the normal output is given up,
+	   the caller counts its message once as dropped */
+	if (atomic_load_explicit(&_hdl->txPanic, memory_order_relaxed) != 0) {
+		return -ESTD_BUSY;
+	}
+
+#if M_LIB_CONSOLE__MIRROR
+	if (_hdl->mirror != NULL) {
+		lib_console_mirror__append(_hdl->mirror, _data, _length);
+	}
+#endif
+
+	if (_hdl->txCoalesce != NULL) {
+		return lib_console__coalesce_write(_hdl, _data, _length);
+	}
+	return lib_console__transport_send(_hdl, _data, _length);
+}
+
+static inline int lib_console__transport_read(console_hdl_t _hdl, uint8_t *_data, unsigned int _length, int _timeout)
+{
+	return _hdl->transport->read(_hdl->transportCtx, _data, _length, _timeout);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,304 +1,2051 @@
-/*
- * This file is part of the EMBTOM project
- * Copyright (c) 2018-2019 Thomas Willetal 
- * (https://github.com/tom3333)
- *
- * Permission is hereby granted, free of charge, to any person obtaining
- * a copy of this software and associated documentation files (the
- * "Software"), to deal in the Software without restriction, including
- * without limitation the rights to use, copy, modify, merge, publish,
- * distribute, sublicense, and/or sell copies of the Software, and to
- * permit persons to whom the Software is furnished to do so, subject to
- * the following conditions:
- *
- * The above copyright notice and this permission notice shall be
- * included in all copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
- * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
- * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
- * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
- * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
- * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
- * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- */
-
-
-/* ****************************************************************************
- * includes
- * ****************************************************************************/
-
-/* c-runtime */
-#include <stdint.h>
-#include <stdarg.h>
-#include <stdbool.h>
-#include <string.h>
-#include <stdlib.h>
-
-/* frame */
-#include <lib_convention__errno.h>
-#include <lib_convention__macro.h>
-#include <lib_convention__mem.h>
-#include <lib_thread.h>
-#include <mini-printf.h>
-#include <lib_serial.h>
-
-/* project */
-#include <lib_console_types_internal.h>
-#include "lib_console.h"
-
-
-/* ****************************************************************************
- * static function declarations
- * ***************************************************************************/
-static void lib_console__send (console_hdl_t _hdl, uint8_t *_data_send, unsigned int _length);
-
-/* ****************************************************************************
- * Global Functions
- * ****************************************************************************/
-
-/* ************************************************************************//**
- * \brief	Opens the console port with a specific baud rate and format 
- * \param	_hdl [IN]	:	console handle used for communication
- * \parm    _baudrate	:	baudrate to be used
- * \parm    _format		:   serial message format
- * \return	EOK, if successful, ret< EOK if not successful
- * ****************************************************************************/
-int lib_console__open(console_hdl_t _hdl, enum baudrate _baudrate, enum data_format _format)
-{
-	int ret;
-	if (_hdl == NULL) {
-		return -ESTD_INVAL;
-	}	
-
-	ret = lib_serial_open(_hdl->serialDev, _baudrate, _format);
-	if (ret < EOK) {
-		goto ERR_SERIAL_OPEN;
-		return -ESTD_IO;
-	}
-
-	memset(&_hdl->txBuffer[0],0, sizeof(_hdl->txBuffer));
-
-	ret = lib_thread__mutex_init(&_hdl->txMtx);
- 	if (ret < EOK) {
- 		goto ERR_TX_MTX;
- 	}
-	_hdl->initialized = M_LIB_CONSOLE__OPENED;
-	return EOK;
-
-	ERR_TX_MTX:
-	lib_serial_close(_hdl->serialDev);
-
-	ERR_SERIAL_OPEN:
-	return ret;
-}
-
-/* ************************************************************************//**
- * \brief	Close of the console, it is the counter-part function of lib_console__open
- * \param	_hdl [IN]	:	console handle used for communication
- * \return	EOK, if successful, ret< EOK if not successful
- * ****************************************************************************/
-int lib_console__close(console_hdl_t _hdl)
-{
-	int ret;
-	if (_hdl == NULL) {
-		return -ESTD_INVAL;
-	}
-
-	if (_hdl->initialized != M_LIB_CONSOLE__OPENED) {
-		return -EEXEC_NOINIT;	
-	}
-
-	lib_thread__mutex_destroy(&_hdl->txMtx);
-	ret = lib_serial_close(_hdl->serialDev);
-	_hdl->initialized = 0;
-	return ret;
-}
-
-/* ************************************************************************//**
- * \brief Printout a message on the serial console
- * \param	_hdl [IN]	:	console handle used for communication
- * \param   _format 	:	"printf" style formatted string argument
- * \return	EOK, if successful, ret< EOK if not successful
- * ****************************************************************************/
-int lib_console__print_debug_message(console_hdl_t _hdl, const char * const _format, ...)
-{
-	int ret;
-	va_list ap;
-
-	if (_hdl == NULL) {
-		return -ESTD_INVAL;
-	}
-
-	if (_hdl->initialized != M_LIB_CONSOLE__OPENED) {
-		return -EEXEC_NOINIT;
-	}
-
-	va_start(ap,_format);
-	ret = lib_console__vprint_debug_message(_hdl, _format, ap);
-	va_end(ap);
-
-	return ret;
-}
-
-/* ************************************************************************//**
- * \brief	Printout a variable argument list message on the serial console
- * \param	_hdl [IN]	:	console handle used for communication
- * \param   _format 	:	"printf" style formatted string argument
- * \param	_ap		    :	variable argument list
- * \return	EOK, if successful, ret< EOK if not successful
- * ****************************************************************************/
-int lib_console__vprint_debug_message(console_hdl_t _hdl, const char * const _format, va_list _ap)
-{
-	int len, ret;
-
-	if (_hdl == NULL) {
-		return -ESTD_INVAL;
-	}
-
-	if (_hdl->initialized != M_LIB_CONSOLE__OPENED) {
-		return -EEXEC_NOINIT;
-	}
-
-	lib_thread__mutex_lock(_hdl->txMtx);
-	memset(&_hdl->txBuffer[0],0,M_LIB_CONSOLE__TX_BUFFER_SIZE);
-
-	len = mini_vsnprintf(&_hdl->txBuffer[0],M_LIB_CONSOLE__TX_BUFFER_SIZE, (const char*) _format,_ap);
-	if(len > M_LIB_CONSOLE__TX_BUFFER_SIZE - 1) {
-	 	lib_thread__mutex_unlock(_hdl->txMtx);
-	 	return -ESTD_NOMEM;
-	}
-
-	// append "\r" in case of new line
-	if(_hdl->txBuffer[len - 1] == '\n'){
-	 	_hdl->txBuffer[len] = '\r';
-	 	len++;
-	}
-
-	ret = lib_serial_write(_hdl->serialDev, &_hdl->txBuffer[0], len);
-	if (ret < EOK) {
-		lib_thread__mutex_unlock(_hdl->txMtx);
-		return ret;
-	}
-	lib_thread__mutex_unlock(_hdl->txMtx);
-	return ret;
-}
-
-/* ************************************************************************//**
- * \brief Printout a character on the serial console
- * \param	_hdl [IN]	:	console handle used for communication
- * \param   _c 		    : 	Character to print
- * \return	EOK, if successful, ret< EOK if not successful
- * ****************************************************************************/
-int lib_console__putchar(console_hdl_t _hdl, char _c)
-{
-	int ret;
-
-	if (_hdl == NULL) {
-		return -ESTD_INVAL;
-	}
-	
-	if (_hdl->initialized != M_LIB_CONSOLE__OPENED) {
-		return -EEXEC_NOINIT;
-	}
-
-	lib_thread__mutex_lock(_hdl->txMtx);
-	ret = lib_serial_write(_hdl->serialDev, &_c, 1);
-	lib_thread__mutex_unlock(_hdl->txMtx);
-	return ret;
-}
-
-/* ************************************************************************//**
- * \brief	Read of a full console log until the newline is reached
- * \param	_hdl [IN]	 :	console handle used for communication
- * \param   _lineptr[OUT]:	pointer to storage location
- * \param	_n[IN|OU]	 :	pointer to buffer length
- * \return	EOK, if successful, ret< EOK if not successful
- * ****************************************************************************/
-int lib_console__getline(console_hdl_t _hdl, char *_lineptr, size_t *_n)
-{
-	return lib_console__getdelim(_hdl, _lineptr,_n,'\n');
-}
-
-/* ************************************************************************//**
- * \brief	 Read string until the delimitaion character is found
- * \param	_hdl [IN]	 :	console handle used for communication
- * \param   _lineptr[OUT]:	pointer to storage location
- * \param	_n[IN|OU]	 :	pointer to buffer length
- * \param	_delimiter	 :	delimiter character to read line
- * \return	EOK, if successful, ret< EOK if not successful
- * ****************************************************************************/
-int lib_console__getdelim(console_hdl_t _hdl, char *_lineptr, size_t *_n, char _delimiter)
-{
-	int ret, i;
-	unsigned int loopExit = 0;
-	size_t max_lineptr_size, readSize = 0;
-	char *readPos;
-
-	if ((_hdl == NULL) || (_lineptr == NULL) || (_n == NULL)) {
-		return -ESTD_INVAL;
-	}
-
-	if (_hdl->initialized != M_LIB_CONSOLE__OPENED) {
-		return -EEXEC_NOINIT;
-	}
-
-	max_lineptr_size = *_n;
-	readPos = _lineptr;
-	while ((readSize < max_lineptr_size) && (!loopExit))
-	{
-		ret = lib_serial_read(_hdl->serialDev, (uint8_t*)readPos, max_lineptr_size - readSize, M_LIB_CONSOLE__INTER_FRAME_TIMEOUT);
-		if (ret < EOK) {
-			return ret;
-		}
-
-		for(i = 0; i < ret; i++) {
-			if (readPos[i] == '\r') {
-				readPos[i] = '\n';
-			}
-
-			if (readPos[i] == 0x7f) {
-				lib_console__putchar(_hdl, '\b');
-				lib_console__putchar(_hdl, ' ');
-				lib_console__putchar(_hdl, '\b');
-				readPos[i] = 0;
-				readPos[i-1] = 0;
-				readPos -=1;
-				readSize -=1;
-				ret=0;
-			}
-
-			else if (readPos[i] == _delimiter) {
-				loopExit = 1;	
-			}
-		}
-		lib_console__send(_hdl, (uint8_t*)readPos, ret);
-		readPos += ret;
-		readSize += ret;
-	}
-	*_n = readSize;
-	return EOK;
-}
-
-/* *******************************************************************
- * static function definitions
- * ******************************************************************/
-static void lib_console__send (console_hdl_t _hdl, uint8_t *_data_send, unsigned int _length)
-{
-	int ret;
-	char characterReturn = '\r';
-
-	if (_length == 0) {
-		return;
-	}
-
-	lib_thread__mutex_lock(_hdl->txMtx);
-	lib_serial_write(_hdl->serialDev, (uint8_t*)_data_send, _length);
-	// append "\r" in case of new line
-	if(_data_send[_length - 1] == '\n'){
-		lib_serial_write(_hdl->serialDev, (uint8_t*)&characterReturn, 1);
-	}
-	lib_thread__mutex_unlock(_hdl->txMtx);
-}
-
-
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+
+/* c-runtime */
+#include <stdint.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+#include <lib_convention__macro.h>
+#include <lib_convention__mem.h>
+#include <lib_thread.h>
+#include <mini-printf.h>
+
+/* project */
+#include <lib_console_types_internal.h>
+#include <lib_console_format.h>
+#include <lib_console_editor.h>
+#include <lib_console_timestamp.h>
+#include <lib_console_newline.h>
+#include "lib_console.h"
+#if M_LIB_CONSOLE__MIRROR
+#include "lib_console_mirror.h"
+#endif
+
+
+/* ****************************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ****************************************************************************/
+
+/* formatted print, it turns into a stream when the format buffer is full */
+struct console_print_stream {
+	console_hdl_t hdl;
+	size_t prefix;
+	bool streamed;
+	int lockRet;
+	size_t newlines;
+};
+
+/* ****************************************************************************
+ * static function declarations
+ * ***************************************************************************/
+static uint8_t* lib_console__async_reserve(console_hdl_t _hdl, size_t _len, size_t *_pos);
+static void lib_console__async_commit(console_hdl_t _hdl, size_t _pos);
+static int lib_console__async_submit(console_hdl_t _hdl, const uint8_t *_data, unsigned int _length, bool _text);
+static void* lib_console__tx_worker(void *_arg);
+static int lib_console__tx_lock(console_hdl_t _hdl);
+static int lib_console__tx_lock_timed(console_hdl_t _hdl);
+static void lib_console__tx_drain(console_hdl_t _hdl);
+static void lib_console__tx_drop(console_hdl_t _hdl, size_t _len);
+static void lib_console__tx_drop_note(console_hdl_t _hdl);
+static int lib_console__tx_count(console_hdl_t _hdl, int _ret);
+static int lib_console__tx_done(console_hdl_t _hdl, int _ret, size_t _len);
+static size_t lib_console__ts_prefix(console_hdl_t _hdl);
+static int lib_console__tx_buffer(console_hdl_t _hdl, size_t _len);
+static int lib_console__print_typed(console_hdl_t _hdl, const char *_label, const char *_value, size_t _len);
+static int lib_console__stream_flush(void *_arg, const char *_data, size_t _len);
+static int lib_console__stream_end(struct console_print_stream *_print, struct console_format_stream *_stream, int _ret);
+static void lib_console__write_raw(console_hdl_t _hdl, const uint8_t *_data, unsigned int _length);
+static int lib_console__write_text(console_hdl_t _hdl, const char *_data, size_t _len);
+static int lib_console__write_long(console_hdl_t _hdl, const char *_data, size_t _len);
+static void lib_console__echo(console_hdl_t _hdl);
+static void lib_console__echo_long(void *_arg, const char *_data, size_t _len);
+static int lib_console__getdelim_raw(console_hdl_t _hdl, char *_lineptr, size_t *_n, char _delimiter);
+static void lib_console__rx_enqueue(console_hdl_t _hdl, const char *_line, size_t _len);
+static int lib_console__rx_dequeue(console_hdl_t _hdl, char *_lineptr, size_t *_n, char _delimiter);
+static void* lib_console__rx_worker(void *_arg);
+static int lib_console__coalesce_flush(console_hdl_t _hdl);
+static void lib_console__coalesce_stop(console_hdl_t _hdl);
+static void* lib_console__flush_worker(void *_arg);
+
+/* *******************************************************************
+ * (static) variables declarations
+ * ******************************************************************/
+
+/* per thread format buffer, one byte spare for the "\r" of a new line */
+static _Thread_local char s_txBuffer[M_LIB_CONSOLE__TX_BUFFER_SIZE + 1];
+
+/* per thread timestamp prefix of the last print */
+static _Thread_local struct console_timestamp_cache s_tsCache;
+
+/* ****************************************************************************
+ * Global Functions
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Opens the console port with a specific baud rate and format 
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \parm    _baudrate	:	baudrate to be used
+ * \parm    _format		:   serial message format
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__open(console_hdl_t _hdl, enum baudrate _baudrate, enum data_format _format)
+{
+	int ret;
+	if (_hdl == NULL) {
+		return -ESTD_INVAL;
+	}	
+
+	ret = _hdl->transport->open(_hdl->transportCtx, _baudrate, _format);
+	if (ret < EOK) {
+		goto ERR_SERIAL_OPEN;
+		return -ESTD_IO;
+	}
+
+	ret = lib_thread__mutex_init(&_hdl->txMtx);
+ 	if (ret < EOK) {
+ 		goto ERR_TX_MTX;
+ 	}
+
+	ret = lib_thread__sem_init(&_hdl->txLockSem, 0);
+	if (ret < EOK) {
+		goto ERR_LOCK_SEM;
+	}
+	atomic_store(&_hdl->txLockWaiters, 0);
+	lib_console_editor__init(&_hdl->editor, _hdl->rxLine, _hdl->rxLineSize, &lib_console__echo_long, _hdl);
+	_hdl->rxPendingLen = 0;
+	_hdl->rxPendingPos = 0;
+	_hdl->txAsync = false;
+	_hdl->rxActive = false;
+	atomic_store(&_hdl->tsLineStart, true);
+	_hdl->initialized = M_LIB_CONSOLE__OPENED;
+	return EOK;
+
+	ERR_LOCK_SEM:
+	lib_thread__mutex_destroy(&_hdl->txMtx);
+
+	ERR_TX_MTX:
+	_hdl->transport->close(_hdl->transportCtx);
+
+	ERR_SERIAL_OPEN:
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Close of the console, it is the counter-part function of lib_console__open
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__close(console_hdl_t _hdl)
+{
+	int ret;
+	if (_hdl == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	if (_hdl->initialized != M_LIB_CONSOLE__OPENED) {
+		return -EEXEC_NOINIT;	
+	}
+
+	if (_hdl->rxActive) {
+		lib_console__rx_stop(_hdl);
+	}
+
+#if defined(__linux__)
+	if (_hdl->reactor != NULL) {
+		lib_console_reactor__detach(_hdl);
+	}
+#endif
+
+	if (_hdl->txAsync) {
+		lib_console__async_stop(_hdl);
+	}
+
+	if (_hdl->txCoalesce != NULL) {
+		lib_console__coalesce_stop(_hdl);
+	}
+
+#if M_LIB_CONSOLE__MIRROR
+	if (_hdl->mirror != NULL) {
+		lib_console__set_mirror(_hdl, NULL);
+	}
+#endif
+
+	lib_thread__sem_destroy(&_hdl->txLockSem);
+	lib_thread__mutex_destroy(&_hdl->txMtx);
+	ret = _hdl->transport->close(_hdl->transportCtx);
+	_hdl->initialized = 0;
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief Printout a message on the serial console
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param   _format 	:	"printf" style formatted string argument
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__print_debug_message(console_hdl_t _hdl, const char * const _format, ...)
+{
+	int ret;
+	va_list ap;
+
+	if (_hdl == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	if (_hdl->initialized != M_LIB_CONSOLE__OPENED) {
+		return -EEXEC_NOINIT;
+	}
+
+	va_start(ap,_format);
+	ret = lib_console__vprint_debug_message(_hdl, _format, ap);
+	va_end(ap);
+
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Printout a variable argument list message on the serial console
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param   _format 	:	"printf" style formatted string argument
+ * \param	_ap		    :	variable argument list
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__vprint_debug_message(console_hdl_t _hdl, const char * const _format, va_list _ap)
+{
+	struct console_print_stream print = { _hdl, 0, false, EOK, 0 };
+	struct console_format_stream stream;
+	uint64_t start;
+	int ret;
+
+	if (_hdl == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	if (_hdl->initialized != M_LIB_CONSOLE__OPENED) {
+		return -EEXEC_NOINIT;
+	}
+
+	/* format outside of the lock, every thread owns its buffer. A message
+	   beyond the buffer is sent chunk by chunk from its first full chunk on,
+	   it is formatted only once. */
+	start = lib_console_stats__now();
+	print.prefix = lib_console__ts_prefix(_hdl);
+	stream.buffer = &s_txBuffer[0];
+	stream.size = M_LIB_CONSOLE__TX_BUFFER_SIZE;
+	stream.pos = print.prefix;
+	stream.flush = &lib_console__stream_flush;
+	stream.arg = &print;
+	stream.total = 0;
+	stream.last = 0;
+	ret = lib_console_format__vstream(&stream, _format, _ap);
+	if (print.streamed) {
+		return lib_console__tx_count(_hdl, lib_console__stream_end(&print, &stream, ret));
+	}
+	lib_console_stats__record(&_hdl->stats.format, start);
+
+	if (stream.total == 0) {
+		return EOK;
+	}
+	atomic_store_explicit(&_hdl->tsLineStart, (stream.last == '\n'), memory_order_relaxed);
+
+	return lib_console__tx_buffer(_hdl, stream.pos);
+}
+
+/* ************************************************************************//**
+ * \brief	Emergency print for fault handlers and threads. The message is
+ * 			formatted on the stack and written to the transport without
+ * 			heap, blocking txMtx wait or asynchronous ring. Normal output in
+ * 			flight yields, a lock holder which does not release it within
+ * 			M_LIB_CONSOLE__PANIC_WAIT ms is overtaken and the message then
+ * 			bypasses the mirror and the coalescing buffer.
+ * 			From a signal handler the call is best effort: formatting, the
+ * 			clock and the fd transport are async-signal-safe, txMtx is only
+ * 			polled with lib_thread__mutex_trylock, which POSIX does not list
+ * 			as async-signal-safe. A handler interrupting the lock holder
+ * 			waits the full M_LIB_CONSOLE__PANIC_WAIT ms.
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param   _format 	:	"printf" style formatted string argument
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__panic(console_hdl_t _hdl, const char * const _format, ...)
+{
+	int ret;
+	va_list ap;
+
+	va_start(ap, _format);
+	ret = lib_console__vpanic(_hdl, _format, ap);
+	va_end(ap);
+
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Emergency print with a variable argument list, see lib_console__panic
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param   _format 	:	"printf" style formatted string argument
+ * \param	_ap		    :	variable argument list
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__vpanic(console_hdl_t _hdl, const char * const _format, va_list _ap)
+{
+	char buffer[M_LIB_CONSOLE__PANIC_BUFFER_SIZE];
+	/* every character may be a new line which becomes "\n\r" */
+	char text[2 * M_LIB_CONSOLE__PANIC_BUFFER_SIZE];
+	uint64_t deadline;
+	bool locked = false;
+	size_t used;
+	int len, ret;
+
+	if ((_hdl == NULL) || (_format == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	if (_hdl->initialized != M_LIB_CONSOLE__OPENED) {
+		return -EEXEC_NOINIT;
+	}
+
+	/* neither the thread local buffer nor the timestamp cache may be used here,
+	   the interrupted code could be in the middle of them */
+	len = mini_vsnprintf(&buffer[0], sizeof(buffer), (const char*)_format, _ap);
+	if (len <= 0) {
+		return EOK;
+	}
+	if (len >= (int)sizeof(buffer)) {
+		len = sizeof(buffer) - 1;
+	}
+	len = (int)lib_console_newline__translate(&text[0], sizeof(text), &buffer[0], (size_t)len, &used);
+
+	/* normal writers see the flag at their next transport write and release
+	   the lock, the interrupted thread itself never will */
+	atomic_fetch_add(&_hdl->txPanic, 1);
+	deadline = lib_console_timestamp__now() + (uint64_t)M_LIB_CONSOLE__PANIC_WAIT * 1000000ull;
+	for (;;) {
+		if (lib_thread__mutex_trylock(_hdl->txMtx) == EOK) {
+			locked = true;
+			break;
+		}
+		if (lib_console_timestamp__now() >= deadline) {
+			break;
+		}
+		/* the holder needs the CPU to reach its next transport write */
+		lib_thread__msleep(0);
+	}
+
+	/* output gathered before and the mirror are only consistent when the
+	   lock was taken, an overtaken holder may be in the middle of them */
+	if (locked) {
+		lib_console__coalesce_flush(_hdl);
+#if M_LIB_CONSOLE__MIRROR
+		/* the mirror comes first, a stuck transport must not cost the crash output */
+		if (_hdl->mirror != NULL) {
+			lib_console_mirror__append(_hdl->mirror, &text[0], (size_t)len);
+		}
+#endif
+	}
+	ret = _hdl->transport->write(_hdl->transportCtx, (const uint8_t*)&text[0], (unsigned int)len);
+	if (locked) {
+		lib_console__tx_unlock(_hdl);
+	}
+	atomic_fetch_sub(&_hdl->txPanic, 1);
+
+	if (ret < EOK) {
+		lib_console_stats__add(&_hdl->stats.serialErrors, 1);
+		return ret;
+	}
+	lib_console_stats__add(&_hdl->stats.bytes, (uint64_t)len);
+	return lib_console__tx_count(_hdl, EOK);
+}
+
+/* ************************************************************************//**
+ * \brief	Prints a label followed by an unsigned value and a new line
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param	_label [IN]	:	text in front of the value, may be NULL
+ * \param	_value [IN]	:	value to print in decimal
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__print_u32(console_hdl_t _hdl, const char *_label, uint32_t _value)
+{
+	char digits[M_LIB_CONSOLE_FORMAT__DEC_MAX];
+	char *start;
+
+	start = lib_console_format__dec(&digits[sizeof(digits)], _value);
+	return lib_console__print_typed(_hdl, _label, start, (size_t)(&digits[sizeof(digits)] - start));
+}
+
+/* ************************************************************************//**
+ * \brief	Prints a label followed by a signed value and a new line
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param	_label [IN]	:	text in front of the value, may be NULL
+ * \param	_value [IN]	:	value to print in decimal
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__print_i64(console_hdl_t _hdl, const char *_label, int64_t _value)
+{
+	char digits[M_LIB_CONSOLE_FORMAT__DEC_MAX + 1];
+	char *start;
+
+	if (_value < 0) {
+		start = lib_console_format__dec(&digits[sizeof(digits)], 0 - (uint64_t)_value);
+		*--start = '-';
+	}
+	else {
+		start = lib_console_format__dec(&digits[sizeof(digits)], (uint64_t)_value);
+	}
+	return lib_console__print_typed(_hdl, _label, start, (size_t)(&digits[sizeof(digits)] - start));
+}
+
+/* ************************************************************************//**
+ * \brief	Prints a label followed by a hex value and a new line, the value
+ * 			is printed in lower case without "0x"
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param	_label [IN]	:	text in front of the value, may be NULL
+ * \param	_value [IN]	:	value to print
+ * \param	_width [IN]	:	minimum number of digits, zero padded, up to 16
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__print_hex(console_hdl_t _hdl, const char *_label, uint64_t _value, unsigned int _width)
+{
+	char digits[16];
+	char *start;
+
+	start = lib_console_format__hex(&digits[sizeof(digits)], _value, _width);
+	return lib_console__print_typed(_hdl, _label, start, (size_t)(&digits[sizeof(digits)] - start));
+}
+
+/* ************************************************************************//**
+ * \brief	Prints a label followed by a fixed point value and a new line,
+ * 			e.g. 12345 with 3 decimals is printed as "12.345"
+ * \param	_hdl [IN]		:	console handle used for communication
+ * \param	_label [IN]		:	text in front of the value, may be NULL
+ * \param	_value [IN]		:	value in units of 10^-_decimals
+ * \param	_decimals [IN]	:	number of fraction digits, up to 18
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__print_fixed(console_hdl_t _hdl, const char *_label, int64_t _value, unsigned int _decimals)
+{
+	char digits[2 * M_LIB_CONSOLE_FORMAT__DEC_MAX + 2];
+	char *start, *end = &digits[sizeof(digits)];
+	uint64_t magnitude, scale = 1;
+	unsigned int idx;
+
+	if (_decimals > 18) {
+		return -ESTD_INVAL;
+	}
+
+	for (idx = 0; idx < _decimals; idx++) {
+		scale *= 10;
+	}
+
+	magnitude = (_value < 0) ? 0 - (uint64_t)_value : (uint64_t)_value;
+	start = end;
+	if (_decimals > 0) {
+		start = lib_console_format__dec(end, magnitude % scale);
+		while ((size_t)(end - start) < _decimals) {
+			*--start = '0';
+		}
+		*--start = '.';
+	}
+	start = lib_console_format__dec(start, magnitude / scale);
+	if (_value < 0) {
+		*--start = '-';
+	}
+	return lib_console__print_typed(_hdl, _label, start, (size_t)(end - start));
+}
+
+/* ************************************************************************//**
+ * \brief	Prints a label followed by a string and a new line
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param	_label [IN]	:	text in front of the string, may be NULL
+ * \param	_str [IN]	:	string to print
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__print_str(console_hdl_t _hdl, const char *_label, const char *_str)
+{
+	if (_str == NULL) {
+		_str = "(null)";
+	}
+	return lib_console__print_typed(_hdl, _label, _str, strlen(_str));
+}
+
+/* ************************************************************************//**
+ * \brief	Printout an already formatted message, it is handled like a
+ * 			message of lib_console__print_debug_message
+ * \param	_hdl [IN]		:	console handle used for communication
+ * \param	_data [IN]		:	message, no terminating zero required
+ * \param	_length [IN]	:	number of bytes
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__print_buffer(console_hdl_t _hdl, const char *_data, size_t _length)
+{
+	size_t pos;
+
+	if ((_hdl == NULL) || ((_data == NULL) && (_length > 0))) {
+		return -ESTD_INVAL;
+	}
+
+	if (_hdl->initialized != M_LIB_CONSOLE__OPENED) {
+		return -EEXEC_NOINIT;
+	}
+
+	if (_length == 0) {
+		return EOK;
+	}
+
+	if (_length + M_LIB_CONSOLE_TIMESTAMP__SIZE >= M_LIB_CONSOLE__TX_BUFFER_SIZE) {
+		/* long messages are written in place like a streamed print */
+		return lib_console__tx_count(_hdl, lib_console__write_long(_hdl, _data, _length));
+	}
+
+	pos = lib_console__ts_prefix(_hdl);
+	memcpy(&s_txBuffer[pos], _data, _length);
+	pos += _length;
+	atomic_store_explicit(&_hdl->tsLineStart, (s_txBuffer[pos - 1] == '\n'), memory_order_relaxed);
+
+	return lib_console__tx_buffer(_hdl, pos);
+}
+
+/* ************************************************************************//**
+ * \brief	Sets the runtime level of the console, less severe messages of the
+ * 			M_LIB_CONSOLE__PRINT_<LEVEL> macros are discarded
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param	_level [IN]	:	lowest printed level, CONSOLE_LEVEL_OFF disables them
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__set_level(console_hdl_t _hdl, enum console_level _level)
+{
+	if ((_hdl == NULL) || ((unsigned int)_level > CONSOLE_LEVEL_OFF)) {
+		return -ESTD_INVAL;
+	}
+
+	_hdl->head.level = (unsigned char)_level;
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Returns the runtime level of the console
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \return	level of the console, CONSOLE_LEVEL_OFF for an invalid handle
+ * ****************************************************************************/
+enum console_level lib_console__get_level(console_hdl_t _hdl)
+{
+	if (_hdl == NULL) {
+		return CONSOLE_LEVEL_OFF;
+	}
+	return (enum console_level)_hdl->head.level;
+}
+
+/* ************************************************************************//**
+ * \brief Printout a character on the serial console
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param   _c 		    : 	Character to print
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__putchar(console_hdl_t _hdl, char _c)
+{
+	int ret;
+
+	if (_hdl == NULL) {
+		return -ESTD_INVAL;
+	}
+	
+	if (_hdl->initialized != M_LIB_CONSOLE__OPENED) {
+		return -EEXEC_NOINIT;
+	}
+
+	if (_hdl->txAsync) {
+		ret = lib_console__async_submit(_hdl, (uint8_t*)&_c, 1, false);
+		return lib_console__tx_count(_hdl, ret);
+	}
+
+	ret = lib_console__tx_lock(_hdl);
+	if (ret < EOK) {
+		lib_console__tx_drop(_hdl, 1);
+		return ret;
+	}
+	ret = lib_console__transport_write(_hdl, &_c, 1);
+	lib_console__tx_unlock(_hdl);
+	return lib_console__tx_done(_hdl, ret, 1);
+}
+
+#if M_LIB_CONSOLE__WRITEV
+/* ************************************************************************//**
+ * \brief	Printout several buffers on the serial console as one unit, every
+ * 			new line is sent as "\n\r"
+ * \param	_hdl [IN]		:	console handle used for communication
+ * \param	_iov [IN]		:	buffers to print
+ * \param	_iovcnt [IN]	:	number of buffers
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__writev(console_hdl_t _hdl, const struct iovec *_iov, int _iovcnt)
+{
+	int i, ret = EOK;
+	size_t total = 0, newlines = 0, pos, written, used;
+	uint8_t *payload;
+
+	if ((_hdl == NULL) || ((_iov == NULL) && (_iovcnt > 0)) || (_iovcnt < 0)) {
+		return -ESTD_INVAL;
+	}
+
+	if (_hdl->initialized != M_LIB_CONSOLE__OPENED) {
+		return -EEXEC_NOINIT;
+	}
+
+	for (i = 0; i < _iovcnt; i++) {
+		total += _iov[i].iov_len;
+	}
+
+	if (total == 0) {
+		return EOK;
+	}
+
+	for (i = 0; i < _iovcnt; i++) {
+		newlines += lib_console_newline__count((const char*)_iov[i].iov_base, _iov[i].iov_len);
+	}
+
+	if ((_hdl->txAsync) && (total + newlines <= lib_console_ring__max_payload(&_hdl->txRing))) {
+		/* gather straight into the ring record, the size is exact */
+		payload = lib_console__async_reserve(_hdl, total + newlines, &pos);
+		if (payload == NULL) {
+			/* given up by the overflow policy, reported like a failed tx_lock */
+			ret = -ESTD_AGAIN;
+			goto ERR_DROP;
+		}
+		for (i = 0, written = 0; i < _iovcnt; i++) {
+			written += lib_console_newline__translate((char*)&payload[written], total + newlines - written,
+													  (const char*)_iov[i].iov_base, _iov[i].iov_len, &used);
+		}
+		lib_console__async_commit(_hdl, pos);
+		return lib_console__tx_count(_hdl, EOK);
+	}
+
+	ret = lib_console__tx_lock(_hdl);
+	if (ret < EOK) {
+		goto ERR_DROP;
+	}
+	for (i = 0; (i < _iovcnt) && (ret >= EOK); i++) {
+		ret = lib_console__write_text(_hdl, (const char*)_iov[i].iov_base, _iov[i].iov_len);
+	}
+	lib_console__tx_unlock(_hdl);
+	return lib_console__tx_done(_hdl, ret, total + newlines);
+
+	ERR_DROP:
+	lib_console__tx_drop(_hdl, total + newlines);
+	return ret;
+}
+#endif
+
+/* ************************************************************************//**
+ * \brief	Read of a full console log until the newline is reached
+ * \param	_hdl [IN]	 :	console handle used for communication
+ * \param   _lineptr[OUT]:	pointer to storage location
+ * \param	_n[IN|OU]	 :	pointer to buffer length
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__getline(console_hdl_t _hdl, char *_lineptr, size_t *_n)
+{
+	return lib_console__getdelim(_hdl, _lineptr,_n,'\n');
+}
+
+/* ************************************************************************//**
+ * \brief	 Read string until the delimitaion character is found
+ * \param	_hdl [IN]	 :	console handle used for communication
+ * \param   _lineptr[OUT]:	pointer to storage location
+ * \param	_n[IN|OU]	 :	pointer to buffer length
+ * \param	_delimiter	 :	delimiter character to read line
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__getdelim(console_hdl_t _hdl, char *_lineptr, size_t *_n, char _delimiter)
+{
+	int ret;
+	bool complete = false;
+	struct console_editor *editor;
+
+	if ((_hdl == NULL) || (_lineptr == NULL) || (_n == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	if (_hdl->initialized != M_LIB_CONSOLE__OPENED) {
+		return -EEXEC_NOINIT;
+	}
+
+	if (_hdl->reactor != NULL) {
+		return -ESTD_BUSY;
+	}
+
+	/* no room for a line, the receive engine would wait for one forever */
+	if (*_n == 0) {
+		return EOK;
+	}
+
+	if (_hdl->rxActive) {
+		return lib_console__rx_dequeue(_hdl, _lineptr, _n, _delimiter);
+	}
+
+	if (_hdl->rxMode == CONSOLE_RX_MODE_RAW) {
+		return lib_console__getdelim_raw(_hdl, _lineptr, _n, _delimiter);
+	}
+
+	/* the line is edited in place, it may be longer than the line storage */
+	editor = &_hdl->editor;
+	lib_console_editor__begin(editor, _lineptr, *_n);
+	while (!complete) {
+		/* bytes behind the previous line are kept for the next call */
+		if (_hdl->rxPendingPos == _hdl->rxPendingLen) {
+			ret = lib_console__transport_read(_hdl, &_hdl->rxPending[0], _hdl->rxPendingSize, M_LIB_CONSOLE__INTER_FRAME_TIMEOUT);
+			if (ret < EOK) {
+				return ret;
+			}
+			_hdl->rxPendingPos = 0;
+			_hdl->rxPendingLen = ret;
+		}
+
+		_hdl->rxPendingPos += lib_console_editor__feed(editor, &_hdl->rxPending[_hdl->rxPendingPos],
+													   _hdl->rxPendingLen - _hdl->rxPendingPos, _delimiter, &complete);
+		lib_console__echo(_hdl);
+	}
+
+	*_n = editor->len;
+	lib_console_editor__begin(editor, NULL, 0);
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Selects how received bytes are handled. In raw mode getline and
+ * 			getdelim return the bytes as received up to the delimiter, without
+ * 			echo, "\r" translation or editing keys.
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param	_mode [IN]	:	receive mode, CONSOLE_RX_MODE_EDIT by default
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__set_rx_mode(console_hdl_t _hdl, enum console_rx_mode _mode)
+{
+	if ((_hdl == NULL) || ((unsigned int)_mode > CONSOLE_RX_MODE_RAW)) {
+		return -ESTD_INVAL;
+	}
+
+	_hdl->rxMode = _mode;
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Returns the descriptor that polls readable when the console
+ * 			received data, e.g. to wait on many consoles with poll/epoll
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \return	descriptor, ret< EOK if the transport has none
+ * ****************************************************************************/
+int lib_console__fileno(console_hdl_t _hdl)
+{
+	if (_hdl == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	if (_hdl->transport->fileno == NULL) {
+		return -ESTD_NOTSUP;
+	}
+	return _hdl->transport->fileno(_hdl->transportCtx);
+}
+
+/* ************************************************************************//**
+ * \brief	Processes the received data without waiting, every completed line
+ * 			is handed to the callback. A line may span several calls.
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param	_cb [IN]	:	called with every completed line
+ * \param	_arg [IN]	:	argument passed to the callback
+ * \return	EOK, if successful, ret< EOK if the transport failed
+ * ****************************************************************************/
+int lib_console__rx_poll(console_hdl_t _hdl, console_rx_line_t _cb, void *_arg)
+{
+	struct console_editor *editor = &_hdl->editor;
+	unsigned int burst = 0;
+	size_t avail, len;
+	uint8_t *found;
+	bool complete;
+	int ret;
+
+	for (;;) {
+		/* the pending bytes are always used up, readiness only covers the transport */
+		while (_hdl->rxPendingPos < _hdl->rxPendingLen) {
+			if (_hdl->rxMode == CONSOLE_RX_MODE_RAW) {
+				avail = _hdl->rxPendingLen - _hdl->rxPendingPos;
+				if (avail > editor->capacity - editor->len) {
+					avail = editor->capacity - editor->len;
+				}
+				found = (uint8_t*)memchr(&_hdl->rxPending[_hdl->rxPendingPos], '\n', avail);
+				if (found != NULL) {
+					avail = (size_t)(found - &_hdl->rxPending[_hdl->rxPendingPos]) + 1;
+				}
+				memcpy(&editor->line[editor->len], &_hdl->rxPending[_hdl->rxPendingPos], avail);
+				_hdl->rxPendingPos += avail;
+				editor->len += avail;
+				complete = ((found != NULL) || (editor->len == editor->capacity));
+			}
+			else {
+				_hdl->rxPendingPos += lib_console_editor__feed(editor, &_hdl->rxPending[_hdl->rxPendingPos],
+															   _hdl->rxPendingLen - _hdl->rxPendingPos, '\n', &complete);
+				lib_console__echo(_hdl);
+			}
+
+			/* the line stays in place, the callback may close the console */
+			if (complete) {
+				len = editor->len;
+				lib_console_editor__begin(editor, NULL, 0);
+				if (!_cb(_arg, _hdl, &editor->line[0], len)) {
+					return EOK;
+				}
+			}
+		}
+
+		if (burst++ == M_LIB_CONSOLE__REACTOR_BURST) {
+			return EOK;
+		}
+
+		ret = lib_console__transport_read(_hdl, &_hdl->rxPending[0], _hdl->rxPendingSize, 0);
+		if (ret <= 0) {
+			return ret;
+		}
+		_hdl->rxPendingPos = 0;
+		_hdl->rxPendingLen = ret;
+	}
+}
+
+/* ************************************************************************//**
+ * \brief	Selects what a print does when the transmission can not keep up.
+ * 			In asynchronous mode the policy applies to a full ring, in
+ * 			synchronous mode to a busy transmission. Dropped messages are
+ * 			counted and announced by a "N messages dropped" line.
+ * 			CONSOLE_OVERFLOW_DROP_OLDEST needs asynchronous mode, stopping it
+ * 			falls back to CONSOLE_OVERFLOW_DROP_NEWEST.
+ * \param	_hdl [IN]		:	console handle used for communication
+ * \param	_policy [IN]		:	overflow policy
+ * \param	_timeoutMs [IN]	:	maximum wait of CONSOLE_OVERFLOW_BLOCK_TIMEOUT
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__set_overflow(console_hdl_t _hdl, enum console_overflow _policy, unsigned int _timeoutMs)
+{
+	if ((_hdl == NULL) || ((unsigned int)_policy > CONSOLE_OVERFLOW_DROP_OLDEST)) {
+		return -ESTD_INVAL;
+	}
+
+	/* without a queue there is no older message to drop */
+	if ((_policy == CONSOLE_OVERFLOW_DROP_OLDEST) && !_hdl->txAsync) {
+		return -ESTD_NOTSUP;
+	}
+
+	_hdl->txTimeout = _timeoutMs;
+	_hdl->txPolicy = _policy;
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Selects the timestamp put in front of every printed line
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param	_mode [IN]	:	resolution, CONSOLE_TIMESTAMP_OFF disables it
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__set_timestamp(console_hdl_t _hdl, enum console_timestamp _mode)
+{
+	if ((_hdl == NULL) || ((unsigned int)_mode > CONSOLE_TIMESTAMP_US)) {
+		return -ESTD_INVAL;
+	}
+
+	_hdl->tsMode = _mode;
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Returns the number of dropped messages and bytes
+ * \param	_hdl [IN]		:	console handle used for communication
+ * \param	_messages [OUT]	:	dropped messages, may be NULL
+ * \param	_bytes [OUT]		:	dropped bytes, may be NULL
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__get_drops(console_hdl_t _hdl, uint64_t *_messages, uint64_t *_bytes)
+{
+	if (_hdl == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	if (_messages != NULL) {
+		*_messages = atomic_load_explicit(&_hdl->txDropMsgs, memory_order_relaxed);
+	}
+	if (_bytes != NULL) {
+		*_bytes = atomic_load_explicit(&_hdl->txDropBytes, memory_order_relaxed);
+	}
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Switches the console into asynchronous transmission. Prints are
+ * 			copied into a ring buffer and sent by a writer thread of the handle.
+ * \param	_hdl [IN]		:	console handle used for communication
+ * \param	_ringSize [IN]	:	size of the transmit ring in bytes, 0 for default
+ * 							or for all of the ring reserved at creation
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__async_start(console_hdl_t _hdl, size_t _ringSize)
+{
+	size_t size;
+	int ret;
+
+	if (_hdl == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	if (_hdl->initialized != M_LIB_CONSOLE__OPENED) {
+		return -EEXEC_NOINIT;
+	}
+
+	if (_hdl->txAsync) {
+		return -ESTD_BUSY;
+	}
+
+	if (_hdl->txReserved != NULL) {
+		/* storage reserved at creation, a smaller ring takes its front part,
+		   the staging buffer follows the full reservation */
+		size = (_ringSize == 0) ? _hdl->txReservedSize : lib_console_ring__storage_size(_ringSize);
+		if (size > _hdl->txReservedSize) {
+			return -ESTD_NOSPC;
+		}
+		if (lib_console_ring__init_static(&_hdl->txRing, _hdl->txReserved, size) < EOK) {
+			return -ESTD_INVAL;
+		}
+		_hdl->txStage = &_hdl->txReserved[_hdl->txReservedSize];
+	}
+	else {
+		if (_ringSize == 0) {
+			_ringSize = M_LIB_CONSOLE__TX_RING_SIZE;
+		}
+
+		ret = lib_console_ring__init(&_hdl->txRing, _ringSize);
+		if (ret < EOK) {
+			goto ERR_RING;
+		}
+
+		_hdl->txStage = (uint8_t*)alloc_memory(1, lib_console_ring__max_payload(&_hdl->txRing));
+		if (_hdl->txStage == NULL) {
+			ret = -ESTD_NOMEM;
+			goto ERR_STAGE;
+		}
+	}
+
+	ret = lib_thread__sem_init(&_hdl->txSem, 0);
+	if (ret < EOK) {
+		goto ERR_TX_SEM;
+	}
+
+	ret = lib_thread__sem_init(&_hdl->txSpaceSem, 0);
+	if (ret < EOK) {
+		goto ERR_SPACE_SEM;
+	}
+
+	ret = lib_thread__cond_init(&_hdl->txDrainCond);
+	if (ret < EOK) {
+		goto ERR_DRAIN_COND;
+	}
+
+	_hdl->txSent = 0;
+	atomic_store(&_hdl->txDrainWaiters, 0);
+	atomic_store(&_hdl->txSleeping, 0);
+	atomic_store(&_hdl->txWaiters, 0);
+	atomic_store(&_hdl->txStop, false);
+
+	ret = lib_thread__create(&_hdl->txThd, &lib_console__tx_worker, _hdl, 0, "console_tx");
+	if (ret < EOK) {
+		goto ERR_THREAD;
+	}
+
+	_hdl->txAsync = true;
+	return EOK;
+
+	ERR_THREAD:
+	lib_thread__cond_destroy(&_hdl->txDrainCond);
+
+	ERR_DRAIN_COND:
+	lib_thread__sem_destroy(&_hdl->txSpaceSem);
+
+	ERR_SPACE_SEM:
+	lib_thread__sem_destroy(&_hdl->txSem);
+
+	ERR_TX_SEM:
+	if (_hdl->txReserved == NULL) {
+		free_memory(_hdl->txStage);
+	}
+	_hdl->txStage = NULL;
+
+	ERR_STAGE:
+	lib_console_ring__cleanup(&_hdl->txRing);
+
+	ERR_RING:
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Leaves the asynchronous transmission, pending messages are sent
+ * 			before the writer thread terminates. Must not race with prints.
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__async_stop(console_hdl_t _hdl)
+{
+	if (_hdl == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	if (!_hdl->txAsync) {
+		return -EEXEC_NOINIT;
+	}
+
+	_hdl->txAsync = false;
+	if (_hdl->txPolicy == CONSOLE_OVERFLOW_DROP_OLDEST) {
+		_hdl->txPolicy = CONSOLE_OVERFLOW_DROP_NEWEST;
+	}
+	atomic_store(&_hdl->txStop, true);
+	lib_thread__sem_post(_hdl->txSem);
+	lib_thread__join(&_hdl->txThd, NULL);
+
+	lib_thread__cond_destroy(&_hdl->txDrainCond);
+	lib_thread__sem_destroy(&_hdl->txSpaceSem);
+	lib_thread__sem_destroy(&_hdl->txSem);
+	if (_hdl->txReserved == NULL) {
+		free_memory(_hdl->txStage);
+	}
+	_hdl->txStage = NULL;
+	lib_console_ring__cleanup(&_hdl->txRing);
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Gathers the output of the console into a buffer which is written
+ * 			at once, when it is full, on the flush policy or after a delay
+ * 			measured from its first byte. A running configuration is
+ * 			flushed and replaced. A console of an arena or of the static
+ * 			pool only takes the buffer reserved at creation.
+ * \param	_hdl [IN]		:	console handle used for communication
+ * \param	_size [IN]		:	size of the buffer in bytes, 0 disables coalescing
+ * \param	_policy [IN]		:	additional flush point
+ * \param	_delayMs [IN]	:	maximum age of gathered output, 0 for none
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__set_coalesce(console_hdl_t _hdl, size_t _size, enum console_flush _policy, unsigned int _delayMs)
+{
+	uint8_t *buffer;
+	int ret;
+
+	if ((_hdl == NULL) || ((unsigned int)_policy > CONSOLE_FLUSH_LINE)) {
+		return -ESTD_INVAL;
+	}
+
+	if (_hdl->initialized != M_LIB_CONSOLE__OPENED) {
+		return -EEXEC_NOINIT;
+	}
+
+	if (_hdl->txCoalesce != NULL) {
+		lib_console__coalesce_stop(_hdl);
+	}
+
+	if (_size == 0) {
+		return EOK;
+	}
+
+	if ((_hdl->coalesceReserved != NULL) || (_hdl->pooled)) {
+		/* storage reserved at creation, a smaller buffer takes its front part */
+		if (_size > _hdl->coalesceReservedSize) {
+			return -ESTD_NOSPC;
+		}
+		buffer = _hdl->coalesceReserved;
+	}
+	else {
+		buffer = (uint8_t*)alloc_memory(1, _size);
+		if (buffer == NULL) {
+			return -ESTD_NOMEM;
+		}
+	}
+
+	ret = lib_thread__cond_init(&_hdl->txFlushCond);
+	if (ret < EOK) {
+		goto ERR_COND;
+	}
+
+	_hdl->txFlushPolicy = _policy;
+	_hdl->txFlushDelay = _delayMs;
+	_hdl->txFlushStop = false;
+	_hdl->txCoalesceSize = _size;
+	_hdl->txCoalesceLen = 0;
+	lib_thread__mutex_lock(_hdl->txMtx);
+	_hdl->txCoalesce = buffer;
+	lib_console__tx_unlock(_hdl);
+
+	if (_delayMs > 0) {
+		ret = lib_thread__create(&_hdl->txFlushThd, &lib_console__flush_worker, _hdl, 0, "console_flush");
+		if (ret < EOK) {
+			goto ERR_THREAD;
+		}
+	}
+	return EOK;
+
+	ERR_THREAD:
+	lib_thread__mutex_lock(_hdl->txMtx);
+	lib_console__coalesce_flush(_hdl);
+	_hdl->txCoalesce = NULL;
+	lib_console__tx_unlock(_hdl);
+	lib_thread__cond_destroy(&_hdl->txFlushCond);
+
+	ERR_COND:
+	if (buffer != _hdl->coalesceReserved) {
+		free_memory(buffer);
+	}
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Writes out the coalesced output. In asynchronous mode the messages
+ * 			queued before the call are sent first.
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__flush(console_hdl_t _hdl)
+{
+	int ret;
+
+	if (_hdl == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	if (_hdl->initialized != M_LIB_CONSOLE__OPENED) {
+		return -EEXEC_NOINIT;
+	}
+
+	lib_thread__mutex_lock(_hdl->txMtx);
+	if (_hdl->txAsync) {
+		lib_console__tx_drain(_hdl);
+	}
+
+	ret = lib_console__coalesce_flush(_hdl);
+	lib_console__tx_unlock(_hdl);
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Starts the receive engine of the console. A thread of the handle
+ * 			reads, edits and echoes the input and queues complete lines, the
+ * 			getline/getdelim calls only dequeue them afterwards.
+ * \param	_hdl [IN]			:	console handle used for communication
+ * \param	_bufferSize [IN]	:	size of the receive buffer in bytes, 0 for default
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__rx_start(console_hdl_t _hdl, size_t _bufferSize)
+{
+	int ret;
+
+	if (_hdl == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	if (_hdl->initialized != M_LIB_CONSOLE__OPENED) {
+		return -EEXEC_NOINIT;
+	}
+
+	if ((_hdl->rxActive) || (_hdl->reactor != NULL)) {
+		return -ESTD_BUSY;
+	}
+
+	if (_bufferSize == 0) {
+		_bufferSize = (_hdl->rxReserved != NULL) ? _hdl->rxReservedSize : M_LIB_CONSOLE__RX_RING_SIZE;
+	}
+	else if (_bufferSize < _hdl->rxLineSize) {
+		/* at least one full line has to fit */
+		_bufferSize = _hdl->rxLineSize;
+	}
+
+	/* a raw chunk is queued at once */
+	if (_bufferSize < _hdl->rxPendingSize) {
+		_bufferSize = _hdl->rxPendingSize;
+	}
+
+	if (_hdl->rxReserved != NULL) {
+		/* storage reserved at creation */
+		if (_bufferSize > _hdl->rxReservedSize) {
+			return -ESTD_NOSPC;
+		}
+		_hdl->rxBuffer = _hdl->rxReserved;
+	}
+	else {
+		_hdl->rxBuffer = (uint8_t*)alloc_memory(1, _bufferSize);
+	}
+	if (_hdl->rxBuffer == NULL) {
+		ret = -ESTD_NOMEM;
+		goto ERR_BUFFER;
+	}
+
+	ret = lib_thread__mutex_init(&_hdl->rxMtx);
+	if (ret < EOK) {
+		goto ERR_RX_MTX;
+	}
+
+	ret = lib_thread__cond_init(&_hdl->rxCond);
+	if (ret < EOK) {
+		goto ERR_RX_COND;
+	}
+
+	_hdl->rxSize = _bufferSize;
+	_hdl->rxCommit = 0;
+	_hdl->rxTail = 0;
+	_hdl->rxStop = false;
+	_hdl->rxActive = true;
+
+	ret = lib_thread__create(&_hdl->rxThd, &lib_console__rx_worker, _hdl, 0, "console_rx");
+	if (ret < EOK) {
+		goto ERR_THREAD;
+	}
+	return EOK;
+
+	ERR_THREAD:
+	_hdl->rxActive = false;
+	lib_thread__cond_destroy(&_hdl->rxCond);
+
+	ERR_RX_COND:
+	lib_thread__mutex_destroy(&_hdl->rxMtx);
+
+	ERR_RX_MTX:
+	if (_hdl->rxReserved == NULL) {
+		free_memory(_hdl->rxBuffer);
+	}
+	_hdl->rxBuffer = NULL;
+
+	ERR_BUFFER:
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Stops the receive engine, it is the counter-part of lib_console__rx_start.
+ * 			Must not race with getline/getdelim calls.
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__rx_stop(console_hdl_t _hdl)
+{
+	if (_hdl == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	if (!_hdl->rxActive) {
+		return -EEXEC_NOINIT;
+	}
+
+	lib_thread__mutex_lock(_hdl->rxMtx);
+	_hdl->rxStop = true;
+	lib_thread__cond_broadcast(_hdl->rxCond);
+	lib_thread__mutex_unlock(_hdl->rxMtx);
+
+	/* the worker notices the stop request latest after one read timeout */
+	lib_thread__join(&_hdl->rxThd, NULL);
+	_hdl->rxActive = false;
+
+	lib_thread__cond_destroy(&_hdl->rxCond);
+	lib_thread__mutex_destroy(&_hdl->rxMtx);
+	if (_hdl->rxReserved == NULL) {
+		free_memory(_hdl->rxBuffer);
+	}
+	_hdl->rxBuffer = NULL;
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Sends an already formatted message as one unit, no new line
+ * 			translation is applied
+ * \param	_hdl [IN]		:	console handle used for communication
+ * \param	_data [IN]		:	message to send, it is not modified
+ * \param	_length [IN]	:	number of bytes
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__write_message(console_hdl_t _hdl, const uint8_t *_data, unsigned int _length)
+{
+	int ret;
+
+	if ((_hdl == NULL) || ((_data == NULL) && (_length > 0))) {
+		return -ESTD_INVAL;
+	}
+
+	if (_hdl->initialized != M_LIB_CONSOLE__OPENED) {
+		return -EEXEC_NOINIT;
+	}
+
+	if (_length == 0) {
+		return EOK;
+	}
+
+	/* messages beyond the ring record size bypass the writer thread */
+	if ((_hdl->txAsync) && (_length <= lib_console_ring__max_payload(&_hdl->txRing))) {
+		ret = lib_console__async_submit(_hdl, _data, _length, false);
+		return lib_console__tx_count(_hdl, ret);
+	}
+
+	ret = lib_console__tx_lock(_hdl);
+	if (ret < EOK) {
+		lib_console__tx_drop(_hdl, _length);
+		return ret;
+	}
+	ret = lib_console__transport_write(_hdl, _data, _length);
+	lib_console__tx_unlock(_hdl);
+	return lib_console__tx_done(_hdl, ret, _length);
+}
+
+/* ************************************************************************//**
+ * \brief	Appends to the coalescing buffer, called with txMtx held
+ * \param	_hdl [IN]		:	console handle used for communication
+ * \param	_data [IN]		:	data to send
+ * \param	_length [IN]	:	number of bytes
+ * \return	number of accepted bytes, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__coalesce_write(console_hdl_t _hdl, const void *_data, unsigned int _length)
+{
+	bool empty = (_hdl->txCoalesceLen == 0);
+	int ret;
+
+	if (_length > _hdl->txCoalesceSize - _hdl->txCoalesceLen) {
+		ret = lib_console__coalesce_flush(_hdl);
+		if (ret < EOK) {
+			return ret;
+		}
+
+		/* nothing to gather for data filling the whole buffer */
+		if (_length >= _hdl->txCoalesceSize) {
+			return lib_console__transport_send(_hdl, _data, _length);
+		}
+		empty = true;
+	}
+
+	memcpy(&_hdl->txCoalesce[_hdl->txCoalesceLen], _data, _length);
+	_hdl->txCoalesceLen += _length;
+
+	if ((_hdl->txCoalesceLen == _hdl->txCoalesceSize) ||
+		((_hdl->txFlushPolicy == CONSOLE_FLUSH_LINE) &&
+		 (lib_console_newline__find((const char*)_data, _length) != _length))) {
+		ret = lib_console__coalesce_flush(_hdl);
+		return (ret < EOK) ? ret : (int)_length;
+	}
+
+	/* the delay starts with the first byte */
+	if (empty && (_hdl->txFlushDelay > 0)) {
+		lib_thread__cond_signal(_hdl->txFlushCond);
+	}
+	return (int)_length;
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+/* NULL once the overflow policy gives the message up, the caller counts the drop */
+static uint8_t* lib_console__async_reserve(console_hdl_t _hdl, size_t _len, size_t *_pos)
+{
+	uint8_t *payload;
+	size_t dropLen;
+	int ret;
+
+	while ((payload = lib_console_ring__reserve(&_hdl->txRing, _len, _pos)) == NULL) {
+		if (_hdl->txPolicy == CONSOLE_OVERFLOW_DROP_NEWEST) {
+			return NULL;
+		}
+
+		if (_hdl->txPolicy == CONSOLE_OVERFLOW_DROP_OLDEST) {
+			/* make room at the tail, only records still being copied cannot be discarded */
+			if (lib_console_ring__drop(&_hdl->txRing, &dropLen) < EOK) {
+				return NULL;
+			}
+			lib_console__tx_drop(_hdl, dropLen);
+			continue;
+		}
+
+		/* ring is full, sleep until the writer released space */
+		atomic_fetch_add(&_hdl->txWaiters, 1);
+		payload = lib_console_ring__reserve(&_hdl->txRing, _len, _pos);
+		ret = EOK;
+		if (payload == NULL) {
+			if (_hdl->txPolicy == CONSOLE_OVERFLOW_BLOCK_TIMEOUT) {
+				ret = lib_thread__sem_timedwait(_hdl->txSpaceSem, (int)_hdl->txTimeout);
+			}
+			else {
+				lib_thread__sem_wait(_hdl->txSpaceSem);
+			}
+		}
+		atomic_fetch_sub(&_hdl->txWaiters, 1);
+		if (payload != NULL) {
+			break;
+		}
+
+		if (ret < EOK) {
+			/* no space was released within the timeout */
+			return NULL;
+		}
+	}
+	return payload;
+}
+
+static void lib_console__async_commit(console_hdl_t _hdl, size_t _pos)
+{
+	lib_console_ring__commit(&_hdl->txRing, _pos);
+
+	atomic_thread_fence(memory_order_seq_cst);
+	if (atomic_exchange(&_hdl->txSleeping, 0)) {
+		lib_thread__sem_post(_hdl->txSem);
+	}
+}
+
+static int lib_console__async_submit(console_hdl_t _hdl, const uint8_t *_data, unsigned int _length, bool _text)
+{
+	uint8_t *payload;
+	size_t pos, used, len = _length;
+
+	/* text is translated into the record, its size is known up front */
+	if (_text) {
+		len += lib_console_newline__count((const char*)_data, _length);
+	}
+
+	if (len > lib_console_ring__max_payload(&_hdl->txRing)) {
+		return -ESTD_MSGSIZE;
+	}
+
+	payload = lib_console__async_reserve(_hdl, len, &pos);
+	if (payload == NULL) {
+		lib_console__tx_drop(_hdl, len);
+		return -ESTD_AGAIN;
+	}
+	if (len != _length) {
+		lib_console_newline__translate((char*)payload, len, (const char*)_data, _length, &used);
+	}
+	else {
+		memcpy(payload, _data, _length);
+	}
+	lib_console__async_commit(_hdl, pos);
+	return EOK;
+}
+
+static void* lib_console__tx_worker(void *_arg)
+{
+	console_hdl_t hdl = (console_hdl_t)_arg;
+	size_t stageSize = lib_console_ring__max_payload(&hdl->txRing);
+	unsigned int waiters;
+	size_t len, sent;
+
+	for (;;) {
+		len = lib_console_ring__pop(&hdl->txRing, hdl->txStage, stageSize);
+		sent = atomic_load(&hdl->txRing.tail);
+		if (len == 0) {
+			/* gathered output is left to the coalescing policy, the writer
+			   only catches up with records dropped while it was busy */
+			if (sent != hdl->txSent) {
+				lib_thread__mutex_lock(hdl->txMtx);
+				hdl->txSent = sent;
+				if (atomic_load(&hdl->txDrainWaiters) != 0) {
+					lib_thread__cond_broadcast(hdl->txDrainCond);
+				}
+				lib_console__tx_unlock(hdl);
+			}
+
+			if (atomic_load(&hdl->txStop)) {
+				break;
+			}
+			atomic_store(&hdl->txSleeping, 1);
+			atomic_thread_fence(memory_order_seq_cst);
+			if (lib_console_ring__empty(&hdl->txRing) && !atomic_load(&hdl->txStop)) {
+				lib_thread__sem_wait(hdl->txSem);
+			}
+			atomic_store(&hdl->txSleeping, 0);
+			continue;
+		}
+
+		for (waiters = atomic_load(&hdl->txWaiters); waiters > 0; waiters--) {
+			lib_thread__sem_post(hdl->txSpaceSem);
+		}
+
+		lib_thread__mutex_lock(hdl->txMtx);
+		if (lib_console__transport_write(hdl, hdl->txStage, len) == -ESTD_BUSY) {
+			lib_console__tx_drop(hdl, len);
+		}
+		lib_console__tx_drop_note(hdl);
+		hdl->txSent = sent;
+		if (atomic_load(&hdl->txDrainWaiters) != 0) {
+			lib_thread__cond_broadcast(hdl->txDrainCond);
+		}
+		lib_console__tx_unlock(hdl);
+	}
+	return NULL;
+}
+
+static int lib_console__tx_lock(console_hdl_t _hdl)
+{
+	uint64_t start = lib_console_stats__now();
+	int ret;
+
+	switch (_hdl->txPolicy) {
+		case CONSOLE_OVERFLOW_BLOCK:
+			lib_thread__mutex_lock(_hdl->txMtx);
+			break;
+
+		case CONSOLE_OVERFLOW_BLOCK_TIMEOUT:
+			if (lib_thread__mutex_trylock(_hdl->txMtx) < EOK) {
+				ret = lib_console__tx_lock_timed(_hdl);
+				if (ret < EOK) {
+					return ret;
+				}
+			}
+			break;
+
+		default:
+			/* without a queue the current message is the newest one */
+			if (lib_thread__mutex_trylock(_hdl->txMtx) < EOK) {
+				return -ESTD_AGAIN;
+			}
+			break;
+	}
+
+	/* in asynchronous mode only messages bypassing the writer thread get
+	   here, the records queued before them are written first */
+	if (_hdl->txAsync) {
+		lib_console__tx_drain(_hdl);
+	}
+
+	lib_console_stats__record(&_hdl->stats.lockWait, start);
+	lib_console__tx_drop_note(_hdl);
+	return EOK;
+}
+
+static void lib_console__tx_drain(console_hdl_t _hdl)
+{
+	size_t target;
+
+	/* called with txMtx held, waits for everything reserved up to now,
+	   records still being copied included */
+	target = atomic_load(&_hdl->txRing.head);
+	atomic_fetch_add(&_hdl->txDrainWaiters, 1);
+	while ((ptrdiff_t)(target - _hdl->txSent) > 0) {
+		if (atomic_exchange(&_hdl->txSleeping, 0)) {
+			lib_thread__sem_post(_hdl->txSem);
+		}
+		/* the wait releases txMtx, let a blocked writer take it */
+		lib_console__tx_wake(_hdl);
+		lib_thread__cond_wait(_hdl->txDrainCond, _hdl->txMtx);
+	}
+	atomic_fetch_sub(&_hdl->txDrainWaiters, 1);
+}
+
+static int lib_console__tx_lock_timed(console_hdl_t _hdl)
+{
+	uint64_t deadline, now;
+	int ret = -ESTD_AGAIN;
+
+	deadline = lib_console_timestamp__now() + (uint64_t)_hdl->txTimeout * 1000000ull;
+
+	/* registered before the next attempt, a release in between posts the semaphore */
+	atomic_fetch_add(&_hdl->txLockWaiters, 1);
+	for (;;) {
+		if (lib_thread__mutex_trylock(_hdl->txMtx) == EOK) {
+			ret = EOK;
+			break;
+		}
+
+		now = lib_console_timestamp__now();
+		if (now >= deadline) {
+			break;
+		}
+
+		/* another waiter may win the released lock, the rest of the time is waited again */
+		lib_thread__sem_timedwait(_hdl->txLockSem, (int)((deadline - now + 999999ull) / 1000000ull));
+	}
+	atomic_fetch_sub(&_hdl->txLockWaiters, 1);
+	return ret;
+}
+
+static int lib_console__tx_count(console_hdl_t _hdl, int _ret)
+{
+	if (_ret >= EOK) {
+		lib_console_stats__add(&_hdl->stats.messages, 1);
+	}
+	return _ret;
+}
+
+static int lib_console__tx_done(console_hdl_t _hdl, int _ret, size_t _len)
+{
+	/* an emergency print overtook the message, the rest of it was given up */
+	if (_ret == -ESTD_BUSY) {
+		lib_console__tx_drop(_hdl, _len);
+	}
+	return lib_console__tx_count(_hdl, _ret);
+}
+
+static size_t lib_console__ts_prefix(console_hdl_t _hdl)
+{
+	size_t len;
+
+	if ((_hdl->tsMode == CONSOLE_TIMESTAMP_OFF) || !atomic_load_explicit(&_hdl->tsLineStart, memory_order_relaxed)) {
+		return 0;
+	}
+
+	len = lib_console_timestamp__render(&s_tsCache, _hdl->tsMode, lib_console_timestamp__now());
+	memcpy(&s_txBuffer[0], &s_tsCache.text[0], len);
+	return len;
+}
+
+static int lib_console__tx_buffer(console_hdl_t _hdl, size_t _len)
+{
+	size_t lf;
+	int ret;
+
+	if (_hdl->txAsync) {
+		/* text growing past the ring record size by the new lines is written directly */
+		ret = lib_console__async_submit(_hdl, (uint8_t*)&s_txBuffer[0], _len, true);
+		if (ret != -ESTD_MSGSIZE) {
+			return lib_console__tx_count(_hdl, ret);
+		}
+	}
+
+	// append "\r" in case of new line, a single one at the end is translated in place
+	lf = lib_console_newline__find(&s_txBuffer[0], _len);
+	if (lf == _len - 1) {
+		s_txBuffer[_len] = '\r';
+		_len++;
+		lf = _len;
+	}
+
+	ret = lib_console__tx_lock(_hdl);
+	if (ret < EOK) {
+		lib_console__tx_drop(_hdl, _len + lib_console_newline__count(&s_txBuffer[lf], _len - lf));
+		return ret;
+	}
+	if (lf == _len) {
+		ret = lib_console__transport_write(_hdl, &s_txBuffer[0], _len);
+	}
+	else {
+		ret = lib_console__write_text(_hdl, &s_txBuffer[0], _len);
+	}
+	lib_console__tx_unlock(_hdl);
+	return lib_console__tx_done(_hdl, ret, _len + lib_console_newline__count(&s_txBuffer[lf], _len - lf));
+}
+
+static int lib_console__print_typed(console_hdl_t _hdl, const char *_label, const char *_value, size_t _len)
+{
+	size_t labelLen, pos;
+
+	if (_hdl == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	if (_hdl->initialized != M_LIB_CONSOLE__OPENED) {
+		return -EEXEC_NOINIT;
+	}
+
+	if (_label == NULL) {
+		_label = "";
+	}
+
+	labelLen = strlen(_label);
+	if (labelLen + _len + M_LIB_CONSOLE_TIMESTAMP__SIZE + 1 >= M_LIB_CONSOLE__TX_BUFFER_SIZE) {
+		/* long lines take the chunked path of the formatted print */
+		return lib_console__print_debug_message(_hdl, "%s%.*s\n", _label, (int)_len, _value);
+	}
+
+	/* nothing to parse, the line is copied together in the format buffer */
+	pos = lib_console__ts_prefix(_hdl);
+	memcpy(&s_txBuffer[pos], _label, labelLen);
+	pos += labelLen;
+	memcpy(&s_txBuffer[pos], _value, _len);
+	pos += _len;
+	s_txBuffer[pos++] = '\n';
+	atomic_store_explicit(&_hdl->tsLineStart, true, memory_order_relaxed);
+
+	return lib_console__tx_buffer(_hdl, pos);
+}
+
+static void lib_console__tx_drop(console_hdl_t _hdl, size_t _len)
+{
+	atomic_fetch_add_explicit(&_hdl->txDropMsgs, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&_hdl->txDropBytes, _len, memory_order_relaxed);
+	atomic_fetch_add_explicit(&_hdl->txDropPending, 1, memory_order_relaxed);
+}
+
+static void lib_console__tx_drop_note(console_hdl_t _hdl)
+{
+	char note[48];
+	unsigned int pending;
+	int len;
+
+	/* called with txMtx held, the output is flowing again */
+	if (atomic_load_explicit(&_hdl->txDropPending, memory_order_relaxed) == 0) {
+		return;
+	}
+
+	pending = atomic_exchange_explicit(&_hdl->txDropPending, 0, memory_order_relaxed);
+	len = mini_snprintf(&note[0], sizeof(note), "%u messages dropped\n\r", pending);
+	if ((len > 0) && (lib_console__transport_write(_hdl, &note[0], len) < EOK)) {
+		/* reported with the next message instead */
+		atomic_fetch_add_explicit(&_hdl->txDropPending, pending, memory_order_relaxed);
+	}
+}
+
+static int lib_console__stream_flush(void *_arg, const char *_data, size_t _len)
+{
+	struct console_print_stream *print = (struct console_print_stream*)_arg;
+
+	/* the lock is held for all chunks to keep the message in one piece,
+	   this also holds off the asynchronous writer thread */
+	if (!print->streamed) {
+		print->streamed = true;
+		lib_console_stats__add(&print->hdl->stats.streamed, 1);
+		print->lockRet = lib_console__tx_lock(print->hdl);
+	}
+
+	if (print->lockRet < EOK) {
+		/* the dropped bytes are only known after formatting */
+		print->newlines += lib_console_newline__count(_data, _len);
+		return EOK;
+	}
+	return lib_console__write_text(print->hdl, _data, _len);
+}
+
+static int lib_console__stream_end(struct console_print_stream *_print, struct console_format_stream *_stream, int _ret)
+{
+	console_hdl_t hdl = _print->hdl;
+
+	if (_print->lockRet < EOK) {
+		_print->newlines += lib_console_newline__count(_stream->buffer, _stream->pos);
+		lib_console__tx_drop(hdl, _print->prefix + _stream->total + _print->newlines);
+		return _print->lockRet;
+	}
+
+	/* the last chunk is still in the buffer */
+	if ((_ret >= EOK) && (_stream->pos > 0)) {
+		_ret = lib_console__write_text(hdl, _stream->buffer, _stream->pos);
+	}
+	atomic_store_explicit(&hdl->tsLineStart, (_stream->last == '\n'), memory_order_relaxed);
+	lib_console__tx_unlock(hdl);
+	if (_ret == -ESTD_BUSY) {
+		/* formatting stopped at the emergency print, the bytes up to it are counted */
+		lib_console__tx_drop(hdl, _print->prefix + _stream->total);
+	}
+	return _ret;
+}
+
+static int lib_console__write_text(console_hdl_t _hdl, const char *_data, size_t _len)
+{
+	char chunk[M_LIB_CONSOLE__TEXT_CHUNK_SIZE];
+	size_t len, used;
+	int ret = EOK;
+
+	/* called with txMtx held, text behind the last new line is written in place */
+	while ((_len > 0) && (ret >= EOK)) {
+		if (lib_console_newline__find(_data, _len) == _len) {
+			return lib_console__transport_write(_hdl, _data, _len);
+		}
+
+		len = lib_console_newline__translate(&chunk[0], sizeof(chunk), _data, _len, &used);
+		ret = lib_console__transport_write(_hdl, &chunk[0], len);
+		_data += used;
+		_len -= used;
+	}
+	return ret;
+}
+
+static int lib_console__write_long(console_hdl_t _hdl, const char *_data, size_t _len)
+{
+	size_t prefix = lib_console__ts_prefix(_hdl);
+	int ret;
+
+	lib_console_stats__add(&_hdl->stats.streamed, 1);
+	ret = lib_console__tx_lock(_hdl);
+	if (ret < EOK) {
+		lib_console__tx_drop(_hdl, prefix + _len + lib_console_newline__count(_data, _len));
+		return ret;
+	}
+
+	/* the timestamp prefix is in the format buffer, the text is translated chunk by chunk */
+	if (prefix > 0) {
+		ret = lib_console__transport_write(_hdl, &s_txBuffer[0], prefix);
+	}
+	if (ret >= EOK) {
+		ret = lib_console__write_text(_hdl, _data, _len);
+	}
+	atomic_store_explicit(&_hdl->tsLineStart, (_data[_len - 1] == '\n'), memory_order_relaxed);
+	lib_console__tx_unlock(_hdl);
+	if (ret == -ESTD_BUSY) {
+		lib_console__tx_drop(_hdl, prefix + _len + lib_console_newline__count(_data, _len));
+	}
+	return ret;
+}
+
+static void lib_console__write_raw(console_hdl_t _hdl, const uint8_t *_data, unsigned int _length)
+{
+	if (_length == 0) {
+		return;
+	}
+
+	if ((_hdl->txAsync) && (lib_console__async_submit(_hdl, _data, _length, false) != -ESTD_MSGSIZE)) {
+		return;
+	}
+
+	/* an echo is not held back by the coalescing */
+	lib_thread__mutex_lock(_hdl->txMtx);
+	if (_hdl->txAsync) {
+		lib_console__tx_drain(_hdl);
+	}
+	lib_console__transport_write(_hdl, (uint8_t*)_data, _length);
+	lib_console__coalesce_flush(_hdl);
+	lib_console__tx_unlock(_hdl);
+}
+
+static int lib_console__rx_dequeue(console_hdl_t _hdl, char *_lineptr, size_t *_n, char _delimiter)
+{
+	size_t avail, len, idx, part;
+	uint8_t *found;
+
+	lib_thread__mutex_lock(_hdl->rxMtx);
+	for (;;) {
+		avail = _hdl->rxCommit - _hdl->rxTail;
+
+		/* search the completed lines for the delimiter, in up to two pieces */
+		len = 0;
+		idx = _hdl->rxTail % _hdl->rxSize;
+		part = (avail < _hdl->rxSize - idx) ? avail : _hdl->rxSize - idx;
+		found = (uint8_t*)memchr(&_hdl->rxBuffer[idx], _delimiter, part);
+		if (found != NULL) {
+			len = (size_t)(found - &_hdl->rxBuffer[idx]) + 1;
+		}
+		else if (avail > part) {
+			found = (uint8_t*)memchr(&_hdl->rxBuffer[0], _delimiter, avail - part);
+			if (found != NULL) {
+				len = part + (size_t)(found - &_hdl->rxBuffer[0]) + 1;
+			}
+		}
+
+		/* without delimiter hand out what fills the caller buffer or our own */
+		if ((len == 0) && ((avail >= *_n) || (avail == _hdl->rxSize))) {
+			len = avail;
+		}
+
+		if (len > *_n) {
+			len = *_n;
+		}
+
+		if (len > 0) {
+			break;
+		}
+
+		if (_hdl->rxStop) {
+			lib_thread__mutex_unlock(_hdl->rxMtx);
+			return -EEXEC_NOINIT;
+		}
+		lib_thread__cond_wait(_hdl->rxCond, _hdl->rxMtx);
+	}
+
+	idx = _hdl->rxTail % _hdl->rxSize;
+	part = (len < _hdl->rxSize - idx) ? len : _hdl->rxSize - idx;
+	memcpy(_lineptr, &_hdl->rxBuffer[idx], part);
+	memcpy(&_lineptr[part], &_hdl->rxBuffer[0], len - part);
+	_hdl->rxTail += len;
+
+	/* space was released, the worker might wait for it */
+	lib_thread__cond_broadcast(_hdl->rxCond);
+	lib_thread__mutex_unlock(_hdl->rxMtx);
+
+	*_n = len;
+	return EOK;
+}
+
+static void lib_console__echo(console_hdl_t _hdl)
+{
+	lib_console__write_raw(_hdl, (uint8_t*)&_hdl->editor.echo[0], _hdl->editor.echoLen);
+	_hdl->editor.echoLen = 0;
+}
+
+static void lib_console__echo_long(void *_arg, const char *_data, size_t _len)
+{
+	lib_console__write_raw((console_hdl_t)_arg, (const uint8_t*)_data, (unsigned int)_len);
+}
+
+static int lib_console__getdelim_raw(console_hdl_t _hdl, char *_lineptr, size_t *_n, char _delimiter)
+{
+	size_t len = 0, avail;
+	uint8_t *found = NULL;
+	int ret;
+
+	/* the pending bytes are searched and copied as blocks up to the delimiter */
+	while ((len < *_n) && (found == NULL)) {
+		if (_hdl->rxPendingPos == _hdl->rxPendingLen) {
+			ret = lib_console__transport_read(_hdl, &_hdl->rxPending[0], _hdl->rxPendingSize, M_LIB_CONSOLE__INTER_FRAME_TIMEOUT);
+			if (ret < EOK) {
+				return ret;
+			}
+			_hdl->rxPendingPos = 0;
+			_hdl->rxPendingLen = ret;
+		}
+
+		avail = _hdl->rxPendingLen - _hdl->rxPendingPos;
+		if (avail > *_n - len) {
+			avail = *_n - len;
+		}
+		found = (uint8_t*)memchr(&_hdl->rxPending[_hdl->rxPendingPos], _delimiter, avail);
+		if (found != NULL) {
+			avail = (size_t)(found - &_hdl->rxPending[_hdl->rxPendingPos]) + 1;
+		}
+
+		memcpy(&_lineptr[len], &_hdl->rxPending[_hdl->rxPendingPos], avail);
+		_hdl->rxPendingPos += avail;
+		len += avail;
+	}
+
+	*_n = len;
+	return EOK;
+}
+
+static void lib_console__rx_enqueue(console_hdl_t _hdl, const char *_line, size_t _len)
+{
+	size_t idx, part;
+
+	lib_thread__mutex_lock(_hdl->rxMtx);
+	while ((_hdl->rxSize - (_hdl->rxCommit - _hdl->rxTail) < _len) && (!_hdl->rxStop)) {
+		/* buffer full, wait for the reader instead of dropping input */
+		lib_thread__cond_wait(_hdl->rxCond, _hdl->rxMtx);
+	}
+
+	if (!_hdl->rxStop) {
+		idx = _hdl->rxCommit % _hdl->rxSize;
+		part = (_len < _hdl->rxSize - idx) ? _len : _hdl->rxSize - idx;
+		memcpy(&_hdl->rxBuffer[idx], _line, part);
+		memcpy(&_hdl->rxBuffer[0], &_line[part], _len - part);
+		_hdl->rxCommit += _len;
+		lib_thread__cond_broadcast(_hdl->rxCond);
+	}
+	lib_thread__mutex_unlock(_hdl->rxMtx);
+}
+
+static void* lib_console__rx_worker(void *_arg)
+{
+	console_hdl_t hdl = (console_hdl_t)_arg;
+	struct console_editor *editor = &hdl->editor;
+	bool complete;
+	size_t len;
+	int ret;
+
+	lib_console_editor__begin(editor, NULL, 0);
+	while (!hdl->rxStop) {
+		/* getdelim only dequeues meanwhile, the worker owns the pending bytes */
+		if (hdl->rxPendingPos == hdl->rxPendingLen) {
+			ret = lib_console__transport_read(hdl, &hdl->rxPending[0], hdl->rxPendingSize, M_LIB_CONSOLE__INTER_FRAME_TIMEOUT);
+			if (ret < EOK) {
+				/* failed transport, e.g. closed peer, do not spin on it */
+				lib_thread__msleep(M_LIB_CONSOLE__INTER_FRAME_TIMEOUT);
+				continue;
+			}
+			hdl->rxPendingPos = 0;
+			hdl->rxPendingLen = ret;
+			continue;
+		}
+
+		/* raw bytes are queued as received, getdelim splits them */
+		if (hdl->rxMode == CONSOLE_RX_MODE_RAW) {
+			if (editor->len > 0) {
+				lib_console__rx_enqueue(hdl, &editor->line[0], editor->len);
+				lib_console_editor__begin(editor, NULL, 0);
+			}
+			len = hdl->rxPendingLen - hdl->rxPendingPos;
+			lib_console__rx_enqueue(hdl, (const char*)&hdl->rxPending[hdl->rxPendingPos], len);
+			hdl->rxPendingPos += len;
+			continue;
+		}
+
+		hdl->rxPendingPos += lib_console_editor__feed(editor, &hdl->rxPending[hdl->rxPendingPos],
+													  hdl->rxPendingLen - hdl->rxPendingPos, '\n', &complete);
+		lib_console__echo(hdl);
+		if (complete) {
+			lib_console__rx_enqueue(hdl, &editor->line[0], editor->len);
+			lib_console_editor__begin(editor, NULL, 0);
+		}
+	}
+	return NULL;
+}
+
+static int lib_console__coalesce_flush(console_hdl_t _hdl)
+{
+	size_t len = _hdl->txCoalesceLen;
+
+	/* called with txMtx held */
+	if ((_hdl->txCoalesce == NULL) || (len == 0)) {
+		return EOK;
+	}
+
+	_hdl->txCoalesceLen = 0;
+	return lib_console__transport_send(_hdl, _hdl->txCoalesce, (unsigned int)len);
+}
+
+static void lib_console__coalesce_stop(console_hdl_t _hdl)
+{
+	uint8_t *buffer;
+
+	lib_thread__mutex_lock(_hdl->txMtx);
+	lib_console__coalesce_flush(_hdl);
+	buffer = _hdl->txCoalesce;
+	_hdl->txCoalesce = NULL;
+	_hdl->txFlushStop = true;
+	lib_thread__cond_signal(_hdl->txFlushCond);
+	lib_console__tx_unlock(_hdl);
+
+	if (_hdl->txFlushDelay > 0) {
+		lib_thread__join(&_hdl->txFlushThd, NULL);
+	}
+	lib_thread__cond_destroy(&_hdl->txFlushCond);
+	if (buffer != _hdl->coalesceReserved) {
+		free_memory(buffer);
+	}
+}
+
+static void* lib_console__flush_worker(void *_arg)
+{
+	console_hdl_t hdl = (console_hdl_t)_arg;
+
+	lib_thread__mutex_lock(hdl->txMtx);
+	while (!hdl->txFlushStop) {
+		/* the waits release txMtx as well */
+		lib_console__tx_wake(hdl);
+		if (hdl->txCoalesceLen == 0) {
+			lib_thread__cond_wait(hdl->txFlushCond, hdl->txMtx);
+			continue;
+		}
+
+		/* further output does not extend the delay of the first byte */
+		lib_thread__cond_timedwait(hdl->txFlushCond, hdl->txMtx, (int)hdl->txFlushDelay);
+		lib_console__coalesce_flush(hdl);
+	}
+	lib_console__tx_unlock(hdl);
+	return NULL;
+}
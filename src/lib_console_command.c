@@ -0,0 +1,490 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+
+/* c-runtime */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+#include <lib_convention__mem.h>
+
+/* project */
+#include "lib_console_command.h"
+
+/* ****************************************************************************
+ * defines
+ * ****************************************************************************/
+/* average number of commands sharing one displacement seed */
+#define M_LIB_CONSOLE_COMMAND__BUCKET_LOAD	4
+/* seeds tried per bucket before the slot table is doubled */
+#define M_LIB_CONSOLE_COMMAND__SEED_TRIES	4096
+#define M_LIB_CONSOLE_COMMAND__MAX_SLOTS	(1u << 20)
+
+#define M_LIB_CONSOLE_COMMAND__FNV_OFFSET	0xcbf29ce484222325ull
+#define M_LIB_CONSOLE_COMMAND__FNV_PRIME	0x100000001b3ull
+
+/* ****************************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ****************************************************************************/
+
+/* Perfect hash of the command names (hash and displace). The name is hashed
+ * once, its bucket selects a seed that remixes the hash into a slot no other
+ * command uses. A lookup costs one pass over the name and one compare. */
+struct console_command_table_handle {
+	const struct console_command **commands;
+	size_t count;
+	size_t capacity;
+	const struct console_command **slots;
+	uint32_t *seeds;
+	uint32_t slotMask;
+	uint32_t bucketMask;
+};
+
+/* ****************************************************************************
+ * static function declarations
+ * ***************************************************************************/
+static int lib_console_command__add(console_command_table_hdl_t _hdl, const struct console_command *_command);
+static int lib_console_command__build(console_command_table_hdl_t _hdl);
+static int lib_console_command__place(console_command_table_hdl_t _hdl, const struct console_command **_slots,
+									  uint32_t *_seeds, uint32_t _slotMask, uint32_t _bucketMask);
+static inline uint64_t lib_console_command__hash(const char *_name, size_t _len);
+static inline uint32_t lib_console_command__slot(uint64_t _hash, uint32_t _seed, uint32_t _slotMask);
+static int lib_console_command__tokenize(char *_line, size_t _len, char *_argv[]);
+
+/* *******************************************************************
+ * (static) variables declarations
+ * ******************************************************************/
+
+/* statically registered commands, provided by the linker */
+extern const struct console_command __start_lib_console_cmd[] __attribute__((weak));
+extern const struct console_command __stop_lib_console_cmd[] __attribute__((weak));
+
+/* ****************************************************************************
+ * Global Functions
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Creation of a command table holding the statically registered
+ * 			commands and the given ones
+ * \param	_commands [IN]	:	commands to register, may be NULL
+ * \param	_count [IN]		:	number of commands
+ * \return	console_command_table_hdl_t if successfully, NULL if not successful
+ * ****************************************************************************/
+console_command_table_hdl_t lib_console_command__create(const struct console_command *_commands, size_t _count)
+{
+	console_command_table_hdl_t hdl;
+	const struct console_command *command;
+	size_t idx;
+
+	if ((_commands == NULL) && (_count > 0)) {
+		return NULL;
+	}
+
+	hdl = (console_command_table_hdl_t)alloc_memory(1, sizeof(struct console_command_table_handle));
+	if (hdl == NULL) {
+		return NULL;
+	}
+
+	for (command = __start_lib_console_cmd; (command != NULL) && (command < __stop_lib_console_cmd); command++) {
+		if (lib_console_command__add(hdl, command) < EOK) {
+			goto ERR_TABLE;
+		}
+	}
+
+	for (idx = 0; idx < _count; idx++) {
+		if (lib_console_command__add(hdl, &_commands[idx]) < EOK) {
+			goto ERR_TABLE;
+		}
+	}
+
+	if (lib_console_command__build(hdl) < EOK) {
+		goto ERR_TABLE;
+	}
+	return hdl;
+
+	ERR_TABLE:
+	lib_console_command__destroy(&hdl);
+	return NULL;
+}
+
+/* ************************************************************************//**
+ * \brief	Destroys the command table, it is the counter-part of
+ * 			"lib_console_command__create"
+ * \param	_hdl [IN|OUT]	:	command table handle
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_command__destroy(console_command_table_hdl_t *_hdl)
+{
+	if ((_hdl == NULL) || (*_hdl == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	if ((*_hdl)->commands != NULL) {
+		free_memory((*_hdl)->commands);
+	}
+	if ((*_hdl)->slots != NULL) {
+		free_memory((*_hdl)->slots);
+	}
+	if ((*_hdl)->seeds != NULL) {
+		free_memory((*_hdl)->seeds);
+	}
+	free_memory(*_hdl);
+	*_hdl = NULL;
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Adds a command at runtime, the lookup table is rebuilt. Must not
+ * 			race with lib_console_command__dispatch.
+ * \param	_hdl [IN]		:	command table handle
+ * \param	_command [IN]	:	command to register
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_command__register(console_command_table_hdl_t _hdl, const struct console_command *_command)
+{
+	int ret;
+
+	if (_hdl == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	ret = lib_console_command__add(_hdl, _command);
+	if (ret < EOK) {
+		return ret;
+	}
+
+	ret = lib_console_command__build(_hdl);
+	if (ret < EOK) {
+		_hdl->count--;
+	}
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Searches a command by name
+ * \param	_hdl [IN]	:	command table handle
+ * \param	_name [IN]	:	command name
+ * \param	_len [IN]	:	length of the name
+ * \return	command, NULL if it is not registered
+ * ****************************************************************************/
+const struct console_command* lib_console_command__find(console_command_table_hdl_t _hdl, const char *_name, size_t _len)
+{
+	const struct console_command *command;
+	uint64_t hash;
+
+	if ((_hdl == NULL) || (_name == NULL) || (_hdl->slots == NULL)) {
+		return NULL;
+	}
+
+	hash = lib_console_command__hash(_name, _len);
+	command = _hdl->slots[lib_console_command__slot(hash, _hdl->seeds[(hash >> 32) & _hdl->bucketMask], _hdl->slotMask)];
+	if ((command == NULL) || (strncmp(command->name, _name, _len) != 0) || (command->name[_len] != '\0')) {
+		return NULL;
+	}
+	return command;
+}
+
+/* ************************************************************************//**
+ * \brief	Splits a received line into arguments and calls the command.
+ * 			Blanks separate the arguments, double quotes group them, the
+ * 			trailing new line is ignored. Empty lines are skipped. The line is
+ * 			not modified, e.g. the line of a console_line_cb_t can be passed.
+ * \param	_hdl [IN]		:	command table handle
+ * \param	_consoleHdl [IN]:	console passed to the command
+ * \param	_line [IN]		:	received line, it needs no terminator
+ * \param	_len [IN]		:	length of the line
+ * \param	_buffer [OUT]	:	storage of the arguments passed to the command,
+ * 							valid during the call only
+ * \param	_size [IN]		:	size of the buffer, at least _len + 1 bytes
+ * \return	return value of the command, -ESTD_NOENT for an unknown command,
+ * 			ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_command__dispatch(console_command_table_hdl_t _hdl, console_hdl_t _consoleHdl, const char *_line, size_t _len,
+								  char *_buffer, size_t _size)
+{
+	char *argv[M_LIB_CONSOLE_COMMAND__MAX_ARGS + 1];
+	const struct console_command *command;
+	int argc;
+
+	if ((_hdl == NULL) || ((_line == NULL) && (_len > 0)) || (_buffer == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	if (_size <= _len) {
+		return -ESTD_NOSPC;
+	}
+
+	/* the arguments are terminated in the copy, the received line stays as is */
+	if (_len > 0) {
+		memcpy(_buffer, _line, _len);
+	}
+	argc = lib_console_command__tokenize(_buffer, _len, argv);
+	if (argc <= 0) {
+		return argc;
+	}
+
+	command = lib_console_command__find(_hdl, argv[0], strlen(argv[0]));
+	if (command == NULL) {
+		return -ESTD_NOENT;
+	}
+	return command->fn(_consoleHdl, argc, argv, command->arg);
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+static int lib_console_command__add(console_command_table_hdl_t _hdl, const struct console_command *_command)
+{
+	const struct console_command **commands;
+	size_t idx, capacity;
+
+	if ((_command == NULL) || (_command->name == NULL) || (_command->name[0] == '\0') || (_command->fn == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	for (idx = 0; idx < _hdl->count; idx++) {
+		if (strcmp(_hdl->commands[idx]->name, _command->name) == 0) {
+			return -ESTD_EXIST;
+		}
+	}
+
+	if (_hdl->count == _hdl->capacity) {
+		capacity = (_hdl->capacity == 0) ? 16 : (2 * _hdl->capacity);
+		commands = (const struct console_command**)alloc_memory(capacity, sizeof(*commands));
+		if (commands == NULL) {
+			return -ESTD_NOMEM;
+		}
+		if (_hdl->commands != NULL) {
+			memcpy(commands, _hdl->commands, _hdl->count * sizeof(*commands));
+			free_memory(_hdl->commands);
+		}
+		_hdl->commands = commands;
+		_hdl->capacity = capacity;
+	}
+
+	_hdl->commands[_hdl->count++] = _command;
+	return EOK;
+}
+
+static int lib_console_command__build(console_command_table_hdl_t _hdl)
+{
+	const struct console_command **slots;
+	uint32_t *seeds;
+	uint32_t slotCount, bucketCount;
+	int ret;
+
+	for (bucketCount = 1; bucketCount * M_LIB_CONSOLE_COMMAND__BUCKET_LOAD < _hdl->count; bucketCount <<= 1) {
+	}
+
+	/* the slot table starts with a load above one half and grows on failure */
+	for (slotCount = 1; slotCount < _hdl->count; slotCount <<= 1) {
+	}
+
+	for (; slotCount <= M_LIB_CONSOLE_COMMAND__MAX_SLOTS; slotCount <<= 1) {
+		slots = (const struct console_command**)alloc_memory(slotCount, sizeof(*slots));
+		seeds = (uint32_t*)alloc_memory(bucketCount, sizeof(*seeds));
+		if ((slots == NULL) || (seeds == NULL)) {
+			ret = -ESTD_NOMEM;
+			goto ERR_ALLOC;
+		}
+
+		ret = lib_console_command__place(_hdl, slots, seeds, slotCount - 1, bucketCount - 1);
+		if (ret == EOK) {
+			if (_hdl->slots != NULL) {
+				free_memory(_hdl->slots);
+				free_memory(_hdl->seeds);
+			}
+			_hdl->slots = slots;
+			_hdl->seeds = seeds;
+			_hdl->slotMask = slotCount - 1;
+			_hdl->bucketMask = bucketCount - 1;
+			return EOK;
+		}
+
+		free_memory(slots);
+		free_memory(seeds);
+		if (ret != -ESTD_AGAIN) {
+			return ret;
+		}
+	}
+	return -ESTD_NOSPC;
+
+	ERR_ALLOC:
+	if (slots != NULL) {
+		free_memory(slots);
+	}
+	if (seeds != NULL) {
+		free_memory(seeds);
+	}
+	return ret;
+}
+
+static int lib_console_command__place(console_command_table_hdl_t _hdl, const struct console_command **_slots,
+									  uint32_t *_seeds, uint32_t _slotMask, uint32_t _bucketMask)
+{
+	size_t idx, start, end, size, maxSize = 0;
+	uint32_t bucket, seed, slot;
+	uint64_t *hashes = NULL;
+	size_t *first = NULL, *order = NULL;
+	int ret = -ESTD_NOMEM;
+
+	hashes = (uint64_t*)alloc_memory(_hdl->count, sizeof(*hashes));
+	first = (size_t*)alloc_memory(_bucketMask + 2, sizeof(*first));
+	order = (size_t*)alloc_memory(_hdl->count, sizeof(*order));
+	if ((hashes == NULL) || (first == NULL) || (order == NULL)) {
+		goto EXIT;
+	}
+
+	/* commands sorted by bucket, bucket b holds order[first[b] .. first[b + 1]) */
+	for (idx = 0; idx < _hdl->count; idx++) {
+		hashes[idx] = lib_console_command__hash(_hdl->commands[idx]->name, strlen(_hdl->commands[idx]->name));
+		first[((uint32_t)(hashes[idx] >> 32) & _bucketMask) + 1]++;
+	}
+	for (bucket = 0; bucket <= _bucketMask; bucket++) {
+		if (first[bucket + 1] > maxSize) {
+			maxSize = first[bucket + 1];
+		}
+		first[bucket + 1] += first[bucket];
+	}
+	for (idx = 0; idx < _hdl->count; idx++) {
+		order[first[(uint32_t)(hashes[idx] >> 32) & _bucketMask]++] = idx;
+	}
+	for (bucket = _bucketMask + 1; bucket > 0; bucket--) {
+		first[bucket] = first[bucket - 1];
+	}
+	first[0] = 0;
+
+	/* the crowded buckets pick their seeds first, while most slots are free */
+	ret = -ESTD_AGAIN;
+	for (size = maxSize; size > 0; size--) {
+		for (bucket = 0; bucket <= _bucketMask; bucket++) {
+			start = first[bucket];
+			end = first[bucket + 1];
+			if (end - start != size) {
+				continue;
+			}
+
+			for (seed = 0; seed < M_LIB_CONSOLE_COMMAND__SEED_TRIES; seed++) {
+				/* place the bucket members, a collision takes them out again */
+				for (idx = start; idx < end; idx++) {
+					slot = lib_console_command__slot(hashes[order[idx]], seed, _slotMask);
+					if (_slots[slot] != NULL) {
+						break;
+					}
+					_slots[slot] = _hdl->commands[order[idx]];
+				}
+
+				if (idx == end) {
+					break;
+				}
+
+				while (idx-- > start) {
+					_slots[lib_console_command__slot(hashes[order[idx]], seed, _slotMask)] = NULL;
+				}
+			}
+
+			if (seed == M_LIB_CONSOLE_COMMAND__SEED_TRIES) {
+				goto EXIT;
+			}
+			_seeds[bucket] = seed;
+		}
+	}
+	ret = EOK;
+
+	EXIT:
+	if (hashes != NULL) {
+		free_memory(hashes);
+	}
+	if (first != NULL) {
+		free_memory(first);
+	}
+	if (order != NULL) {
+		free_memory(order);
+	}
+	return ret;
+}
+
+static inline uint64_t lib_console_command__hash(const char *_name, size_t _len)
+{
+	uint64_t hash = M_LIB_CONSOLE_COMMAND__FNV_OFFSET;
+	size_t idx;
+
+	for (idx = 0; idx < _len; idx++) {
+		hash = (hash ^ (uint8_t)_name[idx]) * M_LIB_CONSOLE_COMMAND__FNV_PRIME;
+	}
+	return hash;
+}
+
+static inline uint32_t lib_console_command__slot(uint64_t _hash, uint32_t _seed, uint32_t _slotMask)
+{
+	/* the seed remixes the name hash, the name is not read again */
+	_hash ^= (uint64_t)_seed * 0x9e3779b97f4a7c15ull;
+	_hash ^= _hash >> 33;
+	_hash *= 0xff51afd7ed558ccdull;
+	_hash ^= _hash >> 33;
+	return (uint32_t)_hash & _slotMask;
+}
+
+static int lib_console_command__tokenize(char *_line, size_t _len, char *_argv[])
+{
+	size_t pos = 0;
+	int argc = 0;
+	char end;
+
+	while (pos < _len) {
+		if ((_line[pos] == ' ') || (_line[pos] == '\t') || (_line[pos] == '\r') || (_line[pos] == '\n')) {
+			pos++;
+			continue;
+		}
+
+		if (argc == M_LIB_CONSOLE_COMMAND__MAX_ARGS) {
+			return -ESTD_NOSPC;
+		}
+
+		/* a quoted argument ends at the closing quote only */
+		end = '\0';
+		if (_line[pos] == '"') {
+			end = '"';
+			pos++;
+		}
+		_argv[argc++] = &_line[pos];
+
+		while ((pos < _len) && ((end == '"') ? (_line[pos] != '"') :
+				((_line[pos] != ' ') && (_line[pos] != '\t') && (_line[pos] != '\r') && (_line[pos] != '\n')))) {
+			pos++;
+		}
+		_line[pos++] = '\0';
+	}
+
+	_argv[argc] = NULL;
+	return argc;
+}
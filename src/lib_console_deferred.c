@@ -0,0 +1,343 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+
+/* c-runtime */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+
+/* project */
+#include <lib_console_types_internal.h>
+#include "lib_console.h"
+
+/* ****************************************************************************
+ * defines
+ * ****************************************************************************/
+/* magic byte and up to two bytes of record length in front of the body */
+#define M_LIB_CONSOLE_DEFERRED__HEADER_SIZE		3
+#define M_LIB_CONSOLE_DEFERRED__BODY_SIZE		(M_LIB_CONSOLE__TX_BUFFER_SIZE - M_LIB_CONSOLE_DEFERRED__HEADER_SIZE)
+
+/* ****************************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ****************************************************************************/
+struct console_deferred_record {
+	uint8_t *pos;
+	uint8_t *end;
+	bool truncated;
+};
+
+/* ****************************************************************************
+ * static function declarations
+ * ***************************************************************************/
+static int lib_console_deferred__varint(struct console_deferred_record *_record, unsigned long long _value);
+static int lib_console_deferred__zigzag(struct console_deferred_record *_record, long long _value);
+static int lib_console_deferred__string(struct console_deferred_record *_record, const char *_str, int _precision);
+static int lib_console_deferred__encode(struct console_deferred_record *_record, const char *_format, va_list _ap);
+
+/* *******************************************************************
+ * (static) variables declarations
+ * ******************************************************************/
+
+/* start of the format string table, provided by the linker */
+extern const char __start_lib_console_fmt[] __attribute__((weak));
+
+/* ****************************************************************************
+ * Global Functions
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Sends a deferred message, the format string is replaced by its
+ * 			offset in the format table and the arguments are sent raw
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param   _format 	:	format string located in the "lib_console_fmt" section
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__log_deferred(console_hdl_t _hdl, const char * const _format, ...)
+{
+	int ret;
+	va_list ap;
+
+	va_start(ap, _format);
+	ret = lib_console__vlog_deferred(_hdl, _format, ap);
+	va_end(ap);
+
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Sends a deferred message with a variable argument list
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \param   _format 	:	format string located in the "lib_console_fmt" section
+ * \param	_ap		    :	variable argument list
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__vlog_deferred(console_hdl_t _hdl, const char * const _format, va_list _ap)
+{
+	uint8_t buffer[M_LIB_CONSOLE__TX_BUFFER_SIZE];
+	struct console_deferred_record record;
+	uint8_t *start;
+	uint64_t begin;
+	size_t len;
+	int ret;
+
+	if ((_hdl == NULL) || (_format == NULL) || (__start_lib_console_fmt == NULL) ||
+		(_format < __start_lib_console_fmt)) {
+		return -ESTD_INVAL;
+	}
+
+	if (_hdl->initialized != M_LIB_CONSOLE__OPENED) {
+		return -EEXEC_NOINIT;
+	}
+
+	/* the body is encoded first, the header is prepended once its length is known */
+	record.pos = &buffer[M_LIB_CONSOLE_DEFERRED__HEADER_SIZE];
+	record.end = &buffer[M_LIB_CONSOLE__TX_BUFFER_SIZE];
+	record.truncated = false;
+	begin = lib_console_stats__now();
+	lib_console_deferred__varint(&record, atomic_fetch_add_explicit(&_hdl->logSeq, 1, memory_order_relaxed));
+	lib_console_deferred__varint(&record, (unsigned long long)(_format - __start_lib_console_fmt));
+	ret = lib_console_deferred__encode(&record, _format, _ap);
+	lib_console_stats__record(&_hdl->stats.format, begin);
+	if (ret < EOK) {
+		return ret;
+	}
+
+	if (record.truncated) {
+		lib_console_stats__add(&_hdl->stats.truncations, 1);
+	}
+
+	len = (size_t)(record.pos - &buffer[M_LIB_CONSOLE_DEFERRED__HEADER_SIZE]);
+	if (len < 0x80) {
+		start = &buffer[1];
+		start[1] = (uint8_t)len;
+	}
+	else {
+		start = &buffer[0];
+		start[1] = (uint8_t)(len | 0x80);
+		start[2] = (uint8_t)(len >> 7);
+	}
+	start[0] = M_LIB_CONSOLE__DEFERRED_MAGIC;
+
+	return lib_console__write_message(_hdl, start, (unsigned int)(record.pos - start));
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+static int lib_console_deferred__varint(struct console_deferred_record *_record, unsigned long long _value)
+{
+	do {
+		if (_record->pos == _record->end) {
+			return -ESTD_MSGSIZE;
+		}
+		*_record->pos++ = (uint8_t)((_value & 0x7F) | ((_value > 0x7F) ? 0x80 : 0));
+		_value >>= 7;
+	} while (_value != 0);
+	return EOK;
+}
+
+static int lib_console_deferred__zigzag(struct console_deferred_record *_record, long long _value)
+{
+	/* small negative numbers stay small on the wire */
+	return lib_console_deferred__varint(_record, ((unsigned long long)_value << 1) ^ (unsigned long long)(_value >> 63));
+}
+
+static int lib_console_deferred__string(struct console_deferred_record *_record, const char *_str, int _precision)
+{
+	size_t len, room;
+	int ret;
+
+	if (_str == NULL) {
+		_str = "(null)";
+	}
+
+	if (_precision >= 0) {
+		for (len = 0; (len < (size_t)_precision) && (_str[len] != '\0'); len++);
+	}
+	else {
+		len = strlen(_str);
+	}
+
+	/* strings are cut to the room left in the record, one byte is kept for the length */
+	room = (size_t)(_record->end - _record->pos);
+	if (room <= 2) {
+		return -ESTD_MSGSIZE;
+	}
+	if (len > room - 2) {
+		len = room - 2;
+		_record->truncated = true;
+	}
+
+	ret = lib_console_deferred__varint(_record, len);
+	if (ret < EOK) {
+		return ret;
+	}
+
+	if (len > (size_t)(_record->end - _record->pos)) {
+		len = (size_t)(_record->end - _record->pos);
+		_record->truncated = true;
+	}
+	memcpy(_record->pos, _str, len);
+	_record->pos += len;
+	return EOK;
+}
+
+static int lib_console_deferred__encode(struct console_deferred_record *_record, const char *_format, va_list _ap)
+{
+	unsigned long long uvalue;
+	long long svalue;
+	int ret, length, precision;
+
+	/* only the argument types are taken from the format, the host formats */
+	while (*_format != '\0') {
+		if (*_format++ != '%') {
+			continue;
+		}
+
+		while ((*_format == '-') || (*_format == '0') || (*_format == '+') || (*_format == ' ') || (*_format == '#')) {
+			_format++;
+		}
+
+		if (*_format == '*') {
+			ret = lib_console_deferred__zigzag(_record, va_arg(_ap, int));
+			if (ret < EOK) {
+				return ret;
+			}
+			_format++;
+		}
+		else {
+			while ((*_format >= '0') && (*_format <= '9')) {
+				_format++;
+			}
+		}
+
+		precision = -1;
+		if (*_format == '.') {
+			_format++;
+			precision = 0;
+			if (*_format == '*') {
+				precision = va_arg(_ap, int);
+				ret = lib_console_deferred__zigzag(_record, precision);
+				if (ret < EOK) {
+					return ret;
+				}
+				_format++;
+			}
+			else {
+				while ((*_format >= '0') && (*_format <= '9')) {
+					precision = precision * 10 + (*_format++ - '0');
+				}
+			}
+		}
+
+		/* length modifier: 0 int, 1 long, 2 long long, 3 size_t, -1 short, -2 char */
+		length = 0;
+		if (*_format == 'h') {
+			length = -1;
+			if (*++_format == 'h') {
+				length = -2;
+				_format++;
+			}
+		}
+		else if (*_format == 'l') {
+			length = 1;
+			if (*++_format == 'l') {
+				length = 2;
+				_format++;
+			}
+		}
+		else if (*_format == 'z') {
+			length = 3;
+			_format++;
+		}
+
+		switch (*_format++) {
+			case 'd':
+			case 'i':
+				switch (length) {
+					case 1:	 svalue = va_arg(_ap, long); break;
+					case 2:	 svalue = va_arg(_ap, long long); break;
+					case 3:	 svalue = (long long)va_arg(_ap, size_t); break;
+					case -1: svalue = (short)va_arg(_ap, int); break;
+					case -2: svalue = (signed char)va_arg(_ap, int); break;
+					default: svalue = va_arg(_ap, int); break;
+				}
+				ret = lib_console_deferred__zigzag(_record, svalue);
+				break;
+
+			case 'u':
+			case 'x':
+			case 'X':
+			case 'o':
+				switch (length) {
+					case 1:	 uvalue = va_arg(_ap, unsigned long); break;
+					case 2:	 uvalue = va_arg(_ap, unsigned long long); break;
+					case 3:	 uvalue = va_arg(_ap, size_t); break;
+					case -1: uvalue = (unsigned short)va_arg(_ap, unsigned int); break;
+					case -2: uvalue = (unsigned char)va_arg(_ap, unsigned int); break;
+					default: uvalue = va_arg(_ap, unsigned int); break;
+				}
+				ret = lib_console_deferred__varint(_record, uvalue);
+				break;
+
+			case 'p':
+				ret = lib_console_deferred__varint(_record, (uintptr_t)va_arg(_ap, void*));
+				break;
+
+			case 'c':
+				ret = lib_console_deferred__varint(_record, (unsigned char)va_arg(_ap, int));
+				break;
+
+			case 's':
+				ret = lib_console_deferred__string(_record, va_arg(_ap, const char*), precision);
+				break;
+
+			case '\0':
+				_format--;
+				ret = EOK;
+				break;
+
+			default:
+				/* "%%" and unknown conversions carry no argument */
+				ret = EOK;
+				break;
+		}
+
+		if (ret < EOK) {
+			return ret;
+		}
+	}
+	return EOK;
+}
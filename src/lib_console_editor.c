@@ -0,0 +1,597 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+
+/* c-runtime */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* system */
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* project */
+#include <lib_console_editor.h>
+
+/* ****************************************************************************
+ * defines
+ * ****************************************************************************/
+#define M_LIB_CONSOLE_EDITOR__ESC			0x1b
+#define M_LIB_CONSOLE_EDITOR__DEL			0x7f
+#define M_LIB_CONSOLE_EDITOR__CTRL(c)		((c) & 0x1f)
+/* up to this distance plain characters are shorter than "ESC [ n C/D" */
+#define M_LIB_CONSOLE_EDITOR__SHORT_MOVE	3
+/* every byte of a word set to the same value */
+#define M_LIB_CONSOLE_EDITOR__BYTES(_b)		((uint64_t)(_b) * 0x0101010101010101ull)
+
+/* ****************************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ****************************************************************************/
+enum console_editor_esc {
+	CONSOLE_EDITOR_ESC__NONE = 0,
+	CONSOLE_EDITOR_ESC__START,
+	CONSOLE_EDITOR_ESC__CSI,
+	CONSOLE_EDITOR_ESC__SS3
+};
+
+/* ****************************************************************************
+ * static function declarations
+ * ***************************************************************************/
+static void lib_console_editor__out(struct console_editor *_editor, const char *_data, size_t _len);
+static void lib_console_editor__out_csi(struct console_editor *_editor, size_t _count, char _final);
+static void lib_console_editor__move_to(struct console_editor *_editor, size_t _target);
+static bool lib_console_editor__insert(struct console_editor *_editor, char _c);
+static void lib_console_editor__backspace(struct console_editor *_editor);
+static void lib_console_editor__delete(struct console_editor *_editor);
+static void lib_console_editor__replace(struct console_editor *_editor, const char *_line, size_t _len);
+static void lib_console_editor__history_push(struct console_editor *_editor);
+static void lib_console_editor__history_browse(struct console_editor *_editor, bool _older);
+static void lib_console_editor__escape(struct console_editor *_editor, char _final);
+static void lib_console_editor__complete(struct console_editor *_editor, bool _enter);
+static size_t lib_console_editor__plain(const uint8_t *_data, size_t _len, char _delimiter);
+static size_t lib_console_editor__append(struct console_editor *_editor, const uint8_t *_data, size_t _len,
+										 char _delimiter);
+
+/* ****************************************************************************
+ * Global Functions
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Initializes the editor with an empty history
+ * \param	_editor [OUT]	:	editor to initialize
+ * \param	_storage [IN]	:	line storage used without a caller buffer
+ * \param	_size [IN]		:	size of _storage
+ * \param	_echoCb [IN]	:	sends echo exceeding the echo buffer
+ * \param	_echoArg [IN]	:	argument passed to the echo callback
+ * \return	void
+ * ****************************************************************************/
+void lib_console_editor__init(struct console_editor *_editor, char *_storage, size_t _size,
+							  console_editor_echo_t _echoCb, void *_echoArg)
+{
+	memset(_editor, 0, sizeof(*_editor));
+	_editor->storage = _storage;
+	_editor->storageSize = _size;
+	_editor->line = _storage;
+	_editor->capacity = _size;
+	_editor->echoCb = _echoCb;
+	_editor->echoArg = _echoArg;
+}
+
+/* ************************************************************************//**
+ * \brief	Starts a new line
+ * \param	_editor [IN|OUT]	:	editor to use
+ * \param	_line [OUT]			:	buffer the line is edited in, NULL takes
+ * 								the line storage of the editor
+ * \param	_capacity [IN]		:	maximum line length including the delimiter,
+ * 								0 takes the full line storage
+ * \return	void
+ * ****************************************************************************/
+void lib_console_editor__begin(struct console_editor *_editor, char *_line, size_t _capacity)
+{
+	if (_line == NULL) {
+		_line = _editor->storage;
+		if ((_capacity == 0) || (_capacity > _editor->storageSize)) {
+			_capacity = _editor->storageSize;
+		}
+	}
+	_editor->line = _line;
+	_editor->capacity = _capacity;
+	_editor->len = 0;
+	_editor->cursor = 0;
+	_editor->histBrowse = 0;
+}
+
+/* ************************************************************************//**
+ * \brief	Feeds received bytes into the editor. Processing stops as soon as a
+ * 			line is complete or the echo buffer has to be flushed.
+ * \param	_editor [IN|OUT]	:	editor to use
+ * \param	_data [IN]			:	received bytes
+ * \param	_len [IN]			:	number of received bytes
+ * \param	_delimiter [IN]		:	character terminating the line, enter ends
+ * 								the line only for '\n' and is a new line
+ * 								character of the line otherwise
+ * \param	_complete [OUT]		:	true if the line is complete
+ * \return	number of consumed bytes
+ * ****************************************************************************/
+size_t lib_console_editor__feed(struct console_editor *_editor, const uint8_t *_data, size_t _len,
+								char _delimiter, bool *_complete)
+{
+	size_t i, run;
+	char c;
+
+	*_complete = false;
+	for (i = 0; i < _len; i++) {
+		if (_editor->echoLen + M_LIB_CONSOLE_EDITOR__KEY_ECHO_MAX > M_LIB_CONSOLE_EDITOR__ECHO_SIZE) {
+			break;
+		}
+
+		run = lib_console_editor__append(_editor, &_data[i], _len - i, _delimiter);
+		if (run > 0) {
+			i += run - 1;
+			continue;
+		}
+		c = (char)_data[i];
+
+		if (_editor->escState != CONSOLE_EDITOR_ESC__NONE) {
+			lib_console_editor__escape(_editor, c);
+			continue;
+		}
+
+		/* "\r\n" is one enter key */
+		if (_editor->lastCr && (c == '\n')) {
+			_editor->lastCr = false;
+			continue;
+		}
+		_editor->lastCr = (c == '\r');
+
+		if (((c == '\r') || (c == '\n')) && (_delimiter == '\n')) {
+			lib_console_editor__complete(_editor, true);
+			*_complete = true;
+			return i + 1;
+		}
+
+		if ((c == '\r') || (c == '\n')) {
+			/* the new line is part of the line, editing goes on in the next row */
+			lib_console_editor__move_to(_editor, _editor->len);
+			_editor->line[_editor->len++] = '\n';
+			_editor->cursor = _editor->len;
+			lib_console_editor__out(_editor, "\r\n", 2);
+			if (_editor->len >= _editor->capacity) {
+				*_complete = true;
+				return i + 1;
+			}
+			continue;
+		}
+
+		if (c == _delimiter) {
+			lib_console_editor__move_to(_editor, _editor->len);
+			lib_console_editor__insert(_editor, c);
+			lib_console_editor__complete(_editor, false);
+			*_complete = true;
+			return i + 1;
+		}
+
+		switch (c) {
+			case M_LIB_CONSOLE_EDITOR__DEL:
+			case '\b':
+				lib_console_editor__backspace(_editor);
+				break;
+			case M_LIB_CONSOLE_EDITOR__ESC:
+				_editor->escState = CONSOLE_EDITOR_ESC__START;
+				break;
+			case M_LIB_CONSOLE_EDITOR__CTRL('A'):
+				lib_console_editor__move_to(_editor, 0);
+				break;
+			case M_LIB_CONSOLE_EDITOR__CTRL('E'):
+				lib_console_editor__move_to(_editor, _editor->len);
+				break;
+			case M_LIB_CONSOLE_EDITOR__CTRL('K'):
+				if (_editor->cursor < _editor->len) {
+					lib_console_editor__out(_editor, "\x1b[K", 3);
+					_editor->len = _editor->cursor;
+				}
+				break;
+			case M_LIB_CONSOLE_EDITOR__CTRL('U'):
+				lib_console_editor__replace(_editor, "", 0);
+				break;
+			default:
+				if ((uint8_t)c < 0x20) {
+					/* other control characters are ignored */
+					break;
+				}
+				if (lib_console_editor__insert(_editor, c)) {
+					/* line is full, hand it out as is */
+					lib_console_editor__complete(_editor, false);
+					*_complete = true;
+					return i + 1;
+				}
+				break;
+		}
+	}
+	return i;
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+static void lib_console_editor__out(struct console_editor *_editor, const char *_data, size_t _len)
+{
+	/* only redraws of lines longer than a history entry get here */
+	if (_editor->echoLen + _len > M_LIB_CONSOLE_EDITOR__ECHO_SIZE) {
+		_editor->echoCb(_editor->echoArg, &_editor->echo[0], _editor->echoLen);
+		_editor->echoLen = 0;
+		if (_len > M_LIB_CONSOLE_EDITOR__ECHO_SIZE) {
+			_editor->echoCb(_editor->echoArg, _data, _len);
+			return;
+		}
+	}
+
+	memcpy(&_editor->echo[_editor->echoLen], _data, _len);
+	_editor->echoLen += _len;
+}
+
+static void lib_console_editor__out_csi(struct console_editor *_editor, size_t _count, char _final)
+{
+	char seq[24];
+	size_t len = sizeof(seq);
+
+	/* the digits are written backwards in front of the final character */
+	seq[--len] = _final;
+	do {
+		seq[--len] = (char)('0' + (_count % 10));
+		_count /= 10;
+	} while (_count > 0);
+	seq[--len] = '[';
+	seq[--len] = M_LIB_CONSOLE_EDITOR__ESC;
+	lib_console_editor__out(_editor, &seq[len], sizeof(seq) - len);
+}
+
+static void lib_console_editor__move_to(struct console_editor *_editor, size_t _target)
+{
+	size_t count;
+
+	if (_target < _editor->cursor) {
+		count = _editor->cursor - _target;
+		if (count <= M_LIB_CONSOLE_EDITOR__SHORT_MOVE) {
+			lib_console_editor__out(_editor, "\b\b\b", count);
+		}
+		else {
+			lib_console_editor__out_csi(_editor, count, 'D');
+		}
+	}
+	else if (_target > _editor->cursor) {
+		/* moving right by reprinting the characters is often the shortest */
+		count = _target - _editor->cursor;
+		if (count <= M_LIB_CONSOLE_EDITOR__SHORT_MOVE + 1) {
+			lib_console_editor__out(_editor, &_editor->line[_editor->cursor], count);
+		}
+		else {
+			lib_console_editor__out_csi(_editor, count, 'C');
+		}
+	}
+	_editor->cursor = _target;
+}
+
+static bool lib_console_editor__insert(struct console_editor *_editor, char _c)
+{
+	size_t tail = _editor->len - _editor->cursor;
+
+	memmove(&_editor->line[_editor->cursor + 1], &_editor->line[_editor->cursor], tail);
+	_editor->line[_editor->cursor] = _c;
+	_editor->len++;
+
+	/* print the new character and redraw the tail behind it */
+	lib_console_editor__out(_editor, &_editor->line[_editor->cursor], tail + 1);
+	_editor->cursor = _editor->len;
+	lib_console_editor__move_to(_editor, _editor->len - tail);
+
+	return (_editor->len >= _editor->capacity);
+}
+
+static void lib_console_editor__backspace(struct console_editor *_editor)
+{
+	if (_editor->cursor == 0) {
+		return;
+	}
+
+	lib_console_editor__move_to(_editor, _editor->cursor - 1);
+	lib_console_editor__delete(_editor);
+}
+
+static void lib_console_editor__delete(struct console_editor *_editor)
+{
+	size_t tail;
+
+	if (_editor->cursor >= _editor->len) {
+		return;
+	}
+
+	tail = _editor->len - _editor->cursor - 1;
+	memmove(&_editor->line[_editor->cursor], &_editor->line[_editor->cursor + 1], tail);
+	_editor->len--;
+
+	/* redraw the tail, blank the last column and go back */
+	lib_console_editor__out(_editor, &_editor->line[_editor->cursor], tail);
+	lib_console_editor__out(_editor, " ", 1);
+	_editor->cursor = _editor->len + 1;
+	lib_console_editor__move_to(_editor, _editor->len - tail);
+}
+
+static void lib_console_editor__replace(struct console_editor *_editor, const char *_line, size_t _len)
+{
+	size_t same = 0;
+	size_t oldLen = _editor->len;
+
+	if (_len >= _editor->capacity) {
+		_len = _editor->capacity - 1;
+	}
+
+	/* only the part behind the common prefix has to be redrawn */
+	while ((same < _len) && (same < oldLen) && (_editor->line[same] == _line[same])) {
+		same++;
+	}
+	lib_console_editor__move_to(_editor, same);
+
+	memcpy(&_editor->line[same], &_line[same], _len - same);
+	lib_console_editor__out(_editor, &_editor->line[same], _len - same);
+	if (oldLen > _len) {
+		lib_console_editor__out(_editor, "\x1b[K", 3);
+	}
+	_editor->len = _len;
+	_editor->cursor = _len;
+}
+
+static void lib_console_editor__history_push(struct console_editor *_editor)
+{
+	struct console_editor_entry *entry;
+	unsigned int idx;
+
+	/* lines longer than an entry are not kept, a cut one would be recalled */
+	if ((_editor->len == 0) || (_editor->len > M_LIB_CONSOLE_EDITOR__LINE_SIZE)) {
+		return;
+	}
+
+	entry = &_editor->history[_editor->histNewest];
+	if ((_editor->histCount > 0) && (entry->len == _editor->len) &&
+		(memcmp(entry->line, _editor->line, _editor->len) == 0)) {
+		return;
+	}
+
+	idx = (_editor->histCount == 0) ? 0 : (_editor->histNewest + 1) % M_LIB_CONSOLE_EDITOR__HISTORY_DEPTH;
+	memcpy(_editor->history[idx].line, _editor->line, _editor->len);
+	_editor->history[idx].len = _editor->len;
+	_editor->histNewest = idx;
+	if (_editor->histCount < M_LIB_CONSOLE_EDITOR__HISTORY_DEPTH) {
+		_editor->histCount++;
+	}
+}
+
+static void lib_console_editor__history_browse(struct console_editor *_editor, bool _older)
+{
+	const struct console_editor_entry *entry;
+	unsigned int idx;
+
+	if (_older) {
+		/* the draft could not keep the line under edit */
+		if ((_editor->histBrowse >= _editor->histCount) || (_editor->len > M_LIB_CONSOLE_EDITOR__LINE_SIZE)) {
+			return;
+		}
+		if (_editor->histBrowse == 0) {
+			memcpy(_editor->draft.line, _editor->line, _editor->len);
+			_editor->draft.len = _editor->len;
+		}
+		_editor->histBrowse++;
+	}
+	else {
+		if (_editor->histBrowse == 0) {
+			return;
+		}
+		_editor->histBrowse--;
+	}
+
+	if (_editor->histBrowse == 0) {
+		entry = &_editor->draft;
+	}
+	else {
+		idx = (_editor->histNewest + M_LIB_CONSOLE_EDITOR__HISTORY_DEPTH - (_editor->histBrowse - 1)) %
+			  M_LIB_CONSOLE_EDITOR__HISTORY_DEPTH;
+		entry = &_editor->history[idx];
+	}
+	lib_console_editor__replace(_editor, entry->line, entry->len);
+}
+
+static void lib_console_editor__escape(struct console_editor *_editor, char _final)
+{
+	switch (_editor->escState) {
+		case CONSOLE_EDITOR_ESC__START:
+			_editor->escParam = 0;
+			if (_final == '[') {
+				_editor->escState = CONSOLE_EDITOR_ESC__CSI;
+			}
+			else if (_final == 'O') {
+				_editor->escState = CONSOLE_EDITOR_ESC__SS3;
+			}
+			else {
+				_editor->escState = CONSOLE_EDITOR_ESC__NONE;
+			}
+			return;
+
+		case CONSOLE_EDITOR_ESC__CSI:
+			if ((_final >= '0') && (_final <= '9')) {
+				if (_editor->escParam < 1000) {
+					_editor->escParam = _editor->escParam * 10 + (unsigned int)(_final - '0');
+				}
+				return;
+			}
+			if (_final == ';') {
+				return;
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	_editor->escState = CONSOLE_EDITOR_ESC__NONE;
+	switch (_final) {
+		case 'A':
+			lib_console_editor__history_browse(_editor, true);
+			break;
+		case 'B':
+			lib_console_editor__history_browse(_editor, false);
+			break;
+		case 'C':
+			if (_editor->cursor < _editor->len) {
+				lib_console_editor__move_to(_editor, _editor->cursor + 1);
+			}
+			break;
+		case 'D':
+			if (_editor->cursor > 0) {
+				lib_console_editor__move_to(_editor, _editor->cursor - 1);
+			}
+			break;
+		case 'H':
+			lib_console_editor__move_to(_editor, 0);
+			break;
+		case 'F':
+			lib_console_editor__move_to(_editor, _editor->len);
+			break;
+		case '~':
+			if ((_editor->escParam == 1) || (_editor->escParam == 7)) {
+				lib_console_editor__move_to(_editor, 0);
+			}
+			else if ((_editor->escParam == 4) || (_editor->escParam == 8)) {
+				lib_console_editor__move_to(_editor, _editor->len);
+			}
+			else if (_editor->escParam == 3) {
+				lib_console_editor__delete(_editor);
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+static void lib_console_editor__complete(struct console_editor *_editor, bool _enter)
+{
+	lib_console_editor__move_to(_editor, _editor->len);
+	if (!_enter) {
+		return;
+	}
+
+	lib_console_editor__history_push(_editor);
+	if (_editor->len < _editor->capacity) {
+		_editor->line[_editor->len++] = '\n';
+	}
+	_editor->cursor = _editor->len;
+	_editor->histBrowse = 0;
+	lib_console_editor__out(_editor, "\r\n", 2);
+}
+
+/* length of the plain text in front, it ends at a control character, DEL or the delimiter */
+static size_t lib_console_editor__plain(const uint8_t *_data, size_t _len, char _delimiter)
+{
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	const __m128i ctrl = _mm_set1_epi8(0x1f);
+	const __m128i del = _mm_set1_epi8(M_LIB_CONSOLE_EDITOR__DEL);
+	const __m128i delim = _mm_set1_epi8(_delimiter);
+	__m128i block, special;
+	unsigned int mask;
+
+	for (; i + 16 <= _len; i += 16) {
+		block = _mm_loadu_si128((const __m128i*)&_data[i]);
+		/* unsigned "<= 0x1f" is "min(x, 0x1f) == x" */
+		special = _mm_cmpeq_epi8(_mm_min_epu8(block, ctrl), block);
+		special = _mm_or_si128(special, _mm_cmpeq_epi8(block, del));
+		special = _mm_or_si128(special, _mm_cmpeq_epi8(block, delim));
+		mask = (unsigned int)_mm_movemask_epi8(special);
+		if (mask != 0) {
+			return i + (size_t)__builtin_ctz(mask);
+		}
+	}
+#else
+	const uint64_t high = M_LIB_CONSOLE_EDITOR__BYTES(0x80);
+	uint64_t word, del, delim;
+
+	/* eight bytes per step, a word with any special byte is located byte wise */
+	for (; i + 8 <= _len; i += 8) {
+		memcpy(&word, &_data[i], sizeof(word));
+		del = word ^ M_LIB_CONSOLE_EDITOR__BYTES(M_LIB_CONSOLE_EDITOR__DEL);
+		delim = word ^ M_LIB_CONSOLE_EDITOR__BYTES((uint8_t)_delimiter);
+		if ((((word - M_LIB_CONSOLE_EDITOR__BYTES(0x20)) & ~word) |
+			 ((del - M_LIB_CONSOLE_EDITOR__BYTES(0x01)) & ~del) |
+			 ((delim - M_LIB_CONSOLE_EDITOR__BYTES(0x01)) & ~delim)) & high) {
+			break;
+		}
+	}
+#endif
+
+	for (; i < _len; i++) {
+		if ((_data[i] < 0x20) || (_data[i] == M_LIB_CONSOLE_EDITOR__DEL) || (_data[i] == (uint8_t)_delimiter)) {
+			break;
+		}
+	}
+	return i;
+}
+
+/* plain text at the end of the line is taken and echoed as one block, 0 leaves the byte to the key handling */
+static size_t lib_console_editor__append(struct console_editor *_editor, const uint8_t *_data, size_t _len,
+										 char _delimiter)
+{
+	size_t run, room;
+
+	if ((_editor->escState != CONSOLE_EDITOR_ESC__NONE) || (_editor->cursor != _editor->len)) {
+		return 0;
+	}
+
+	/* the last column is left to the key handling, it completes a full line */
+	room = _editor->capacity - 1 - _editor->len;
+	if (room > M_LIB_CONSOLE_EDITOR__ECHO_SIZE - M_LIB_CONSOLE_EDITOR__KEY_ECHO_MAX - _editor->echoLen) {
+		room = M_LIB_CONSOLE_EDITOR__ECHO_SIZE - M_LIB_CONSOLE_EDITOR__KEY_ECHO_MAX - _editor->echoLen;
+	}
+	if (_len > room) {
+		_len = room;
+	}
+
+	run = lib_console_editor__plain(_data, _len, _delimiter);
+	if (run == 0) {
+		return 0;
+	}
+
+	memcpy(&_editor->line[_editor->len], _data, run);
+	lib_console_editor__out(_editor, (const char*)_data, run);
+	_editor->len += run;
+	_editor->cursor = _editor->len;
+	_editor->lastCr = false;
+	return run;
+}
@@ -26,27 +26,95 @@
 /* *******************************************************************
  * includes
  * ******************************************************************/
+/* c-runtime */
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+
 /* frame */
-#include <lib_list.h>
 #include <lib_convention__mem.h>
 #include <lib_convention__errno.h>
 #include <lib_convention__macro.h>
+#include <lib_thread.h>
 
 /* project */
 #include <lib_console_types_internal.h>
 #include <lib_console.h>
+#include <lib_console_factory.h>
+#include <lib_console_transport.h>
+#include <lib_console_format.h>
+#include <lib_console_newline.h>
+#include <lib_console_ring.h>
+
+/* ****************************************************************************
+ * defines
+ * ****************************************************************************/
+#define M_LIB_CONSOLE_FACTORY__ALIGNMENT	_Alignof(max_align_t)
+/* largest single size of struct console_attr, the layout cannot overflow below it */
+#define M_LIB_CONSOLE_FACTORY__SIZE_MAX	(SIZE_MAX / 16)
+/* attempts on the registry lock before the holder gets the processor */
+#define M_LIB_CONSOLE_FACTORY__LOCK_SPINS	64
+#define M_LIB_CONSOLE_FACTORY__ALIGN(x)		(((x) + M_LIB_CONSOLE_FACTORY__ALIGNMENT - 1) & ~(M_LIB_CONSOLE_FACTORY__ALIGNMENT - 1))
+
+/* ****************************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ****************************************************************************/
+
+/* offsets of the handle block, the handle itself starts it */
+struct console_layout {
+	size_t pending;
+	size_t pendingSize;
+	size_t line;
+	size_t lineSize;
+	size_t tx;
+	size_t txSize;
+	size_t rx;
+	size_t rxSize;
+	size_t coalesce;
+	size_t coalesceSize;
+	size_t total;
+};
+
+/* growing heap buffer of a broadcast message exceeding the format buffer */
+struct console_broadcast_message {
+	char *data;
+	size_t size;
+	size_t len;
+};
 
 /* ****************************************************************************
  * static function declarations
  * ***************************************************************************/
-static inline void lib_console_factory__register(const console_hdl_t _consoleHdl);
+static int lib_console_factory__fanout(const uint8_t *_data, unsigned int _length);
+static int lib_console_factory__collect(void *_arg, const char *_data, size_t _len);
+static inline int lib_console_factory__register(const console_hdl_t _consoleHdl);
 static inline int lib_console_factory__unregister(const console_hdl_t _consoleHdl);
+static void lib_console_factory__lock(void);
+static void lib_console_factory__unlock(void);
+static void lib_console_factory__synchronize(void);
+static int lib_console_factory__layout(const struct console_attr *_attr, struct console_layout *_layout);
+static uint8_t* lib_console_factory__take(struct console_arena *_arena, size_t _size);
 
 /* *******************************************************************
  * (static) variables declarations
   ******************************************************************/
-static unsigned int s_initializedList = 0;
-static struct queue_attr s_consoleList;
+/* table of the registered consoles, a released index stays NULL until it is
+ * reused. Readers access it without a lock, inside a read section of the
+ * current epoch parity. Create/destroy serialize on the registry lock. */
+static _Atomic(console_hdl_t) s_registry[M_LIB_CONSOLE__MAX_INSTANCES];
+static atomic_uint s_registryCount = 0;
+static atomic_uint s_registrySlots = 0;
+static atomic_flag s_registryLock = ATOMIC_FLAG_INIT;
+static atomic_uint s_registryEpoch = 0;
+static atomic_uint s_registryReaders[2];
+
+#if M_LIB_CONSOLE__STATIC_POOL_SIZE > 0
+/* handles of lib_console_factory__create without arena, carved under the registry lock */
+static _Alignas(max_align_t) uint8_t s_poolMemory[M_LIB_CONSOLE__STATIC_POOL_SIZE];
+static struct console_arena s_pool = { &s_poolMemory[0], M_LIB_CONSOLE__STATIC_POOL_SIZE, 0 };
+#endif
 
 /* ************************************************************************//**
  * \brief	Creation of a new console handle
@@ -55,28 +123,146 @@ static struct queue_attr s_consoleList;
  * ****************************************************************************/
 console_hdl_t lib_console_factory__getInstance(const lib_serial_hdl _serialDev)
 {
+	return lib_console_factory__getTransportInstance(&lib_console_transport__serial, _serialDev);
+}
+
+/* ************************************************************************//**
+ * \brief	Creation of a new console handle on top of an arbitrary transport
+ * \param	_transport [IN]	:	transport operations
+ * \param	_ctx [IN]		:	transport specific handle passed to the operations
+ * \return	console_hdl_t if successfully, NULL if not successful
+ * ****************************************************************************/
+console_hdl_t lib_console_factory__getTransportInstance(const struct lib_console_transport *_transport, void *_ctx)
+{
+	return lib_console_factory__create(NULL, _transport, _ctx);
+}
+
+/* ************************************************************************//**
+ * \brief	Creation of a new console handle sized by attributes. The handle
+ * 			and its buffers are one block of the arena or of the static pool
+ * 			(M_LIB_CONSOLE__STATIC_POOL_SIZE), no heap memory is used.
+ * \param	_attr [IN]		:	sizes and memory source, NULL allocates the
+ * 							defaults on the heap
+ * \param	_transport [IN]	:	transport operations
+ * \param	_ctx [IN]		:	transport specific handle passed to the operations
+ * \return	console_hdl_t if successfully, NULL if not successful
+ * ****************************************************************************/
+console_hdl_t lib_console_factory__create(const struct console_attr *_attr, const struct lib_console_transport *_transport,
+										  void *_ctx)
+{
+	const struct console_attr defaults = { 0, 0, 0, NULL, 0, 0 };
+	struct console_layout layout;
 	console_hdl_t consoleHdl;
-	if(_serialDev == NULL) {
+	uint8_t *memory = NULL;
+	bool pooled = false;
+
+	if((_transport == NULL) || (_ctx == NULL)) {
+		return NULL;
+	}
+
+	if (lib_console_factory__layout((_attr != NULL) ? _attr : &defaults, &layout) < EOK) {
 		return NULL;
 	}
 
-	consoleHdl = (console_hdl_t)alloc_memory(1, sizeof(struct console_hdl_handle));
-	if (consoleHdl == NULL ) {
+	if ((_attr != NULL) && (_attr->arena != NULL)) {
+		memory = lib_console_factory__take(_attr->arena, layout.total);
+		pooled = true;
+	}
+#if M_LIB_CONSOLE__STATIC_POOL_SIZE > 0
+	else if (_attr != NULL) {
+		/* an exhausted pool fails, a pool is configured to stay off the heap */
+		lib_console_factory__lock();
+		memory = lib_console_factory__take(&s_pool, layout.total);
+		lib_console_factory__unlock();
+		pooled = true;
+	}
+#endif
+	else {
+		memory = (uint8_t*)alloc_memory(1, layout.total);
+	}
+
+	if (memory == NULL ) {
 		return NULL;
 	}
 
-	consoleHdl->serialDev = _serialDev;
-    lib_console_factory__register(consoleHdl);
+	consoleHdl = (console_hdl_t)memory;
+	consoleHdl->pooled = pooled;
+	consoleHdl->rxPending = &memory[layout.pending];
+	consoleHdl->rxPendingSize = layout.pendingSize;
+	consoleHdl->rxLine = (char*)&memory[layout.line];
+	consoleHdl->rxLineSize = layout.lineSize;
+	if (layout.txSize > 0) {
+		consoleHdl->txReserved = &memory[layout.tx];
+		consoleHdl->txReservedSize = layout.txSize;
+	}
+	if (layout.rxSize > 0) {
+		consoleHdl->rxReserved = &memory[layout.rx];
+		consoleHdl->rxReservedSize = layout.rxSize;
+	}
+	if (layout.coalesceSize > 0) {
+		consoleHdl->coalesceReserved = &memory[layout.coalesce];
+		consoleHdl->coalesceReservedSize = layout.coalesceSize;
+	}
+
+	consoleHdl->head.level = CONSOLE_LEVEL_TRACE;
+	consoleHdl->txPolicy = CONSOLE_OVERFLOW_BLOCK;
+	consoleHdl->transport = _transport;
+	consoleHdl->transportCtx = _ctx;
+	if (lib_console_factory__register(consoleHdl) < EOK) {
+		/* pooled memory is not given back, the registry limit is a configuration error */
+		if (!consoleHdl->pooled) {
+			free_memory(consoleHdl);
+		}
+		return NULL;
+	}
 	return consoleHdl;
 }
 
+/* ************************************************************************//**
+ * \brief	Memory a console with these attributes takes from an arena
+ * \param	_attr [IN]	:	sizes of the console
+ * \return	number of bytes including the alignment
+ * ****************************************************************************/
+size_t lib_console_factory__memory_size(const struct console_attr *_attr)
+{
+	struct console_layout layout;
+
+	if ((_attr == NULL) || (lib_console_factory__layout(_attr, &layout) < EOK)) {
+		return 0;
+	}
+
+	/* the arena may have to align the start of the block */
+	return layout.total + M_LIB_CONSOLE_FACTORY__ALIGNMENT - 1;
+}
+
+/* ************************************************************************//**
+ * \brief	Initializes an arena on memory of the caller
+ * \param	_arena [OUT]	:	arena to initialize
+ * \param	_buffer [IN]	:	memory handed out by the arena
+ * \param	_size [IN]		:	size of _buffer
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_arena__init(struct console_arena *_arena, void *_buffer, size_t _size)
+{
+	if ((_arena == NULL) || (_buffer == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	_arena->base = (uint8_t*)_buffer;
+	_arena->size = _size;
+	_arena->used = 0;
+	return EOK;
+}
+
 /* ************************************************************************//**
  * \brief	Destroys the console handle, it is the counter-part of 
- * 			"lib_console_factory__getInstance"
+ * 			"lib_console_factory__getInstance". The handle is closed and
+ * 			freed once the references of lib_console_factory__acquire
+ * 			are released.
  * \param	_hdl [IN|OUT]	:	console handle
  * \return	EOK, if successful, ret< EOK if not successful
  * ****************************************************************************/
-int ib_console_factory__destroy(console_hdl_t *_hdl)
+int lib_console_factory__destroy(console_hdl_t *_hdl)
 {	
     int ret;
 	/* hdl param check */
@@ -89,52 +275,181 @@ int ib_console_factory__destroy(console_hdl_t *_hdl)
         return ret;
     }
 
+	/* no reader finds the console anymore, wait for those still using it */
+	while (atomic_load(&(*_hdl)->refs) > 1) {
+		lib_thread__msleep(1);
+	}
+
 	if((*_hdl)->initialized == M_LIB_CONSOLE__OPENED) {
 		lib_console__close(*_hdl);
 	}
 
 	/* free allocated space and declare handle as invalid */
-	free_memory(*_hdl);
+	if (!(*_hdl)->pooled) {
+		free_memory(*_hdl);
+	}
 	*_hdl = NULL;
 	return EOK;
 }
 
 /* ************************************************************************//**
  * \brief	Returns the number of registered consoles 
- * \return	void
+ * \return	number of registered consoles
  * ****************************************************************************/
 unsigned int lib_console_factory__instances(void)
 {
-    int ret;
-    ret = lib_list__count(&s_consoleList,0,NULL);
-    if (ret < 0) {
-        ret = 0;
-    }
-    return ret;
+	return atomic_load_explicit(&s_registryCount, memory_order_acquire);
 }
 
 /* ************************************************************************//**
- * \brief Request idx corresponding console 
- * \return	console_hdl_t
+ * \brief Request idx corresponding console, the consoles are counted in
+ * 		  registration order. The console is not referenced, the caller
+ * 		  has to keep it from being destroyed meanwhile.
+ * \param	_idx [IN]	:	index below lib_console_factory__instances
+ * \return	console_hdl_t, NULL if there is no such console
  * ****************************************************************************/
 console_hdl_t lib_console_factory__instance(unsigned int _idx)
 {
-    struct list_node *itr;
-    console_hdl_t consoleHdl;
+	console_hdl_t consoleHdl;
+	unsigned int slot, slots;
 
-    unsigned int iter;
-    int ret;
+	/* released slots are skipped, the index counts the used ones only */
+	slots = lib_console_factory__slots();
+	for (slot = 0; slot < slots; slot++) {
+		consoleHdl = atomic_load_explicit(&s_registry[slot], memory_order_acquire);
+		if ((consoleHdl != NULL) && (_idx-- == 0)) {
+			return consoleHdl;
+		}
+	}
+	return NULL;
+}
 
-    ret = lib_list__get_begin(&s_consoleList, &itr, 0, NULL);
-    if (ret < EOK) {
-        return NULL;
-    }
+/* ************************************************************************//**
+ * \brief	Returns the upper bound of the registry slots. A console keeps
+ * 			its slot until it is destroyed, released slots are reused.
+ * \return	number of slots to pass to lib_console_factory__acquire
+ * ****************************************************************************/
+unsigned int lib_console_factory__slots(void)
+{
+	return atomic_load_explicit(&s_registrySlots, memory_order_acquire);
+}
 
-    for (iter = 0; iter < _idx; iter++) {
-        lib_list__get_next(&s_consoleList, &itr, 0, NULL);
-    }
-    consoleHdl = (console_hdl_t)GET_CONTAINER_OF(itr, struct console_hdl_handle, node);
-    return consoleHdl;
+/* ************************************************************************//**
+ * \brief	Takes a reference of the console of a registry slot without a
+ * 			lock. The console stays valid until lib_console_factory__release,
+ * 			a destroy waits for it.
+ * \param	_slot [IN]	:	slot below lib_console_factory__slots
+ * \return	console_hdl_t, NULL if no console uses the slot
+ * ****************************************************************************/
+console_hdl_t lib_console_factory__acquire(unsigned int _slot)
+{
+	console_hdl_t consoleHdl;
+	unsigned int epoch;
+
+	if (_slot >= M_LIB_CONSOLE__MAX_INSTANCES) {
+		return NULL;
+	}
+
+	/* A destroy waits for the read sections of the epoch it retired. The
+	   section only counts once the epoch is unchanged after entering it,
+	   otherwise a destroy may already wait for the other parity. The
+	   reference keeps the console alive once the section is left. */
+	for (;;) {
+		epoch = atomic_load(&s_registryEpoch);
+		atomic_fetch_add(&s_registryReaders[epoch & 1], 1);
+		if (atomic_load(&s_registryEpoch) == epoch) {
+			break;
+		}
+		atomic_fetch_sub(&s_registryReaders[epoch & 1], 1);
+	}
+
+	consoleHdl = atomic_load(&s_registry[_slot]);
+	if (consoleHdl != NULL) {
+		atomic_fetch_add(&consoleHdl->refs, 1);
+	}
+	atomic_fetch_sub(&s_registryReaders[epoch & 1], 1);
+	return consoleHdl;
+}
+
+/* ************************************************************************//**
+ * \brief	Releases a console of lib_console_factory__acquire
+ * \param	_hdl [IN]	:	console handle
+ * \return	void
+ * ****************************************************************************/
+void lib_console_factory__release(console_hdl_t _hdl)
+{
+	if (_hdl != NULL) {
+		atomic_fetch_sub(&_hdl->refs, 1);
+	}
+}
+
+/* ************************************************************************//**
+ * \brief	Printout a message on all registered consoles. The message is
+ * 			formatted once and the same buffer is sent to every console.
+ * \param   _format 	:	"printf" style formatted string argument
+ * \return	EOK, if successful, ret< EOK if not successful on any console
+ * ****************************************************************************/
+int lib_console_factory__broadcast(const char * const _format, ...)
+{
+	int ret;
+	va_list ap;
+
+	va_start(ap, _format);
+	ret = lib_console_factory__vbroadcast(_format, ap);
+	va_end(ap);
+
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Printout a variable argument list message on all registered consoles
+ * \param   _format 	:	"printf" style formatted string argument
+ * \param	_ap		    :	variable argument list
+ * \return	EOK, if successful, ret< EOK if not successful on any console
+ * ****************************************************************************/
+int lib_console_factory__vbroadcast(const char * const _format, va_list _ap)
+{
+	char buffer[M_LIB_CONSOLE__TX_BUFFER_SIZE];
+	char text[2 * M_LIB_CONSOLE__TX_BUFFER_SIZE];
+	struct console_broadcast_message message = { NULL, 0, 0 };
+	struct console_format_stream stream;
+	size_t used;
+	int len, ret;
+
+	if (_format == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	/* a message beyond the buffer is collected on the heap chunk by chunk */
+	stream.buffer = &buffer[0];
+	stream.size = M_LIB_CONSOLE__TX_BUFFER_SIZE;
+	stream.pos = 0;
+	stream.flush = &lib_console_factory__collect;
+	stream.arg = &message;
+	stream.total = 0;
+	stream.last = 0;
+	ret = lib_console_format__vstream(&stream, _format, _ap);
+	if (message.data == NULL) {
+		if ((ret < EOK) || (stream.pos == 0)) {
+			return ret;
+		}
+
+		// every new line is sent as "\n\r", translated once for all consoles
+		len = (int)lib_console_newline__translate(&text[0], sizeof(text), &buffer[0], stream.pos, &used);
+		return lib_console_factory__fanout((uint8_t*)&text[0], len);
+	}
+
+	if (ret >= EOK) {
+		ret = lib_console_factory__collect(&message, &buffer[0], stream.pos);
+	}
+	if (ret >= EOK) {
+		ret = lib_console_factory__fanout((uint8_t*)message.data, message.len);
+	}
+
+	if (message.data != NULL) {
+		free_memory(message.data);
+	}
+	return ret;
 }
 
 /* *******************************************************************
@@ -142,38 +457,259 @@ console_hdl_t lib_console_factory__instance(unsigned int _idx)
  * ******************************************************************/
 
 /* ************************************************************************//**
- * \brief	Register a the console device list 
- * \param	_consoleHdl[IN]	    :	serial device handle used 
+ * \brief	Register at the console device table
+ * \param	_consoleHdl[IN]	    :	console handle to register
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+static int lib_console_factory__register(const console_hdl_t _consoleHdl)
+{
+	unsigned int idx, slots;
+	int ret = EOK;
+
+	/* the registry holds the first reference */
+	atomic_store(&_consoleHdl->refs, 1);
+
+	lib_console_factory__lock();
+	slots = atomic_load_explicit(&s_registrySlots, memory_order_relaxed);
+	for (idx = 0; (idx < slots) && (atomic_load_explicit(&s_registry[idx], memory_order_relaxed) != NULL); idx++) {
+	}
+
+	if (idx < M_LIB_CONSOLE__MAX_INSTANCES) {
+		_consoleHdl->registryIdx = idx;
+		/* the slot is published before the bound covers it */
+		atomic_store_explicit(&s_registry[idx], _consoleHdl, memory_order_release);
+		if (idx == slots) {
+			atomic_store_explicit(&s_registrySlots, slots + 1, memory_order_release);
+		}
+		atomic_fetch_add_explicit(&s_registryCount, 1, memory_order_release);
+	}
+	else {
+		ret = -ESTD_NOMEM;
+	}
+
+	lib_console_factory__unlock();
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Unregister from the console device table, the index stays empty
+ * 			until a new console takes it. Returns after all readers which
+ * 			could still find the console took their reference.
+ * \param	_consoleHdl[IN]	    :	console handle to unregister
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+static int lib_console_factory__unregister(const console_hdl_t _consoleHdl)
+{
+	unsigned int idx, slots;
+	int ret = EOK;
+
+	lib_console_factory__lock();
+
+	idx = _consoleHdl->registryIdx;
+	slots = atomic_load_explicit(&s_registrySlots, memory_order_relaxed);
+	if ((idx >= slots) || (atomic_load_explicit(&s_registry[idx], memory_order_relaxed) != _consoleHdl)) {
+		ret = -ESTD_NOENT;
+		goto UNLOCK;
+	}
+
+	atomic_store(&s_registry[idx], NULL);
+	atomic_fetch_sub_explicit(&s_registryCount, 1, memory_order_release);
+
+	/* empty indices at the end are given up, iterations get shorter */
+	while ((slots > 0) && (atomic_load_explicit(&s_registry[slots - 1], memory_order_relaxed) == NULL)) {
+		slots--;
+	}
+	atomic_store_explicit(&s_registrySlots, slots, memory_order_release);
+
+	lib_console_factory__synchronize();
+
+	UNLOCK:
+	lib_console_factory__unlock();
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Takes the registry lock. The holder only runs for a few
+ * 			instructions, a waiter gives the processor away after a short
+ * 			spin so a preempted holder of lower priority can finish.
  * \return	void
  * ****************************************************************************/
-static void lib_console_factory__register(const console_hdl_t _consoleHdl)
+static void lib_console_factory__lock(void)
 {
-    struct consoleNode *newConsole;
+	unsigned int spins = 0;
 
-    if (!s_initializedList) {
-        lib_list__init(&s_consoleList,NULL);
-        s_initializedList = 1;
-    }
-    lib_list__enqueue(&s_consoleList, &_consoleHdl->node, 0, NULL);
+	while (atomic_flag_test_and_set_explicit(&s_registryLock, memory_order_acquire)) {
+		if (++spins >= M_LIB_CONSOLE_FACTORY__LOCK_SPINS) {
+			lib_thread__msleep(1);
+			spins = 0;
+		}
+	}
 }
 
 /* ************************************************************************//**
- * \brief	Unregister a the console device list 
- * \param	_consoleHdl[IN]	    :	serial device handle used 
+ * \brief	Releases the registry lock
  * \return	void
  * ****************************************************************************/
-static int lib_console_factory__unregister(const console_hdl_t _consoleHdl)
+static void lib_console_factory__unlock(void)
 {
-    int ret;
+	atomic_flag_clear_explicit(&s_registryLock, memory_order_release);
+}
 
-    ret = lib_list__contains(&s_consoleList, &_consoleHdl->node, 0, NULL);
-    if (ret < 0) {
-        return -ESTD_FAULT;
-    }
-    else if (ret == 0) {
-        return -ESTD_NOENT;
-    }
+/* ************************************************************************//**
+ * \brief	Waits until the read sections of lib_console_factory__acquire
+ * 			which started before the call are left. New readers use the
+ * 			other parity, they cannot hold the grace period up.
+ * \return	void
+ * ****************************************************************************/
+static void lib_console_factory__synchronize(void)
+{
+	unsigned int parity;
+	unsigned int spins = 0;
+
+	parity = atomic_fetch_add(&s_registryEpoch, 1) & 1;
+	while (atomic_load(&s_registryReaders[parity]) != 0) {
+		if (++spins >= M_LIB_CONSOLE_FACTORY__LOCK_SPINS) {
+			lib_thread__msleep(1);
+			spins = 0;
+		}
+	}
+}
+
+/* ************************************************************************//**
+ * \brief	Hands the formatted message to every opened console. Consoles in
+ * 			asynchronous mode only copy it, their writer threads send in parallel.
+ * \param	_data [IN]		:	formatted message
+ * \param	_length [IN]	:	number of bytes
+ * \return	EOK, if successful, ret< EOK if not successful on any console
+ * ****************************************************************************/
+static int lib_console_factory__fanout(const uint8_t *_data, unsigned int _length)
+{
+	console_hdl_t consoleHdl;
+	unsigned int idx, count;
+	int ret, result = EOK;
+
+	count = lib_console_factory__slots();
+	for (idx = 0; idx < count; idx++) {
+		consoleHdl = lib_console_factory__acquire(idx);
+		if (consoleHdl == NULL) {
+			continue;
+		}
+
+		if (consoleHdl->initialized == M_LIB_CONSOLE__OPENED) {
+			ret = lib_console__write_message(consoleHdl, _data, _length);
+			if (ret < EOK) {
+				result = ret;
+			}
+		}
+		lib_console_factory__release(consoleHdl);
+	}
+	return result;
+}
+
+/* ************************************************************************//**
+ * \brief	Format stream callback, appends a chunk to the heap message with
+ * 			every new line translated to "\n\r"
+ * \param	_arg [IN|OUT]	:	struct console_broadcast_message
+ * \param	_data [IN]		:	formatted chunk
+ * \param	_len [IN]		:	chunk length
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+static int lib_console_factory__collect(void *_arg, const char *_data, size_t _len)
+{
+	struct console_broadcast_message *message = (struct console_broadcast_message*)_arg;
+	size_t size, used, len;
+	char *data;
+
+	len = _len + lib_console_newline__count(_data, _len);
+	if (message->len + len > message->size) {
+		size = (message->size == 0) ? (2 * M_LIB_CONSOLE__TX_BUFFER_SIZE) : (2 * message->size);
+		while (size < message->len + len) {
+			size *= 2;
+		}
+
+		data = (char*)alloc_memory(1, size);
+		if (data == NULL) {
+			return -ESTD_NOMEM;
+		}
+
+		if (message->data != NULL) {
+			memcpy(data, message->data, message->len);
+			free_memory(message->data);
+		}
+		message->data = data;
+		message->size = size;
+	}
+
+	message->len += lib_console_newline__translate(&message->data[message->len], len, _data, _len, &used);
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Places the buffers of a console behind its handle
+ * \param	_attr [IN]		:	sizes of the console
+ * \param	_layout [OUT]	:	offsets in the handle block
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+static int lib_console_factory__layout(const struct console_attr *_attr, struct console_layout *_layout)
+{
+	struct console_ring ring;
+	size_t stage = 0;
+
+	/* the ring is rounded up to a power of two, the sum of all parts must not wrap */
+	if ((_attr->rxChunkSize > M_LIB_CONSOLE_FACTORY__SIZE_MAX) || (_attr->txRingSize > M_LIB_CONSOLE_FACTORY__SIZE_MAX) ||
+		(_attr->rxRingSize > M_LIB_CONSOLE_FACTORY__SIZE_MAX) || (_attr->lineSize > M_LIB_CONSOLE_FACTORY__SIZE_MAX) ||
+		(_attr->coalesceSize > M_LIB_CONSOLE_FACTORY__SIZE_MAX)) {
+		return -ESTD_INVAL;
+	}
+
+	_layout->pendingSize = (_attr->rxChunkSize > 0) ? _attr->rxChunkSize : M_LIB_CONSOLE__RX_BUFFER_SIZE;
+	_layout->lineSize = (_attr->lineSize > 0) ? _attr->lineSize : M_LIB_CONSOLE_EDITOR__LINE_SIZE;
+
+	/* the staging buffer of the writer thread follows the ring storage */
+	_layout->txSize = 0;
+	if (_attr->txRingSize > 0) {
+		ring.size = lib_console_ring__storage_size(_attr->txRingSize);
+		_layout->txSize = ring.size;
+		stage = lib_console_ring__max_payload(&ring);
+	}
+
+	/* a full line and a raw chunk have to fit into the line queue */
+	_layout->rxSize = _attr->rxRingSize;
+	if (_layout->rxSize > 0) {
+		if (_layout->rxSize < _layout->lineSize) {
+			_layout->rxSize = _layout->lineSize;
+		}
+		if (_layout->rxSize < _layout->pendingSize) {
+			_layout->rxSize = _layout->pendingSize;
+		}
+	}
+
+	_layout->pending = M_LIB_CONSOLE_FACTORY__ALIGN(sizeof(struct console_hdl_handle));
+	_layout->line = _layout->pending + _layout->pendingSize;
+	_layout->tx = M_LIB_CONSOLE_FACTORY__ALIGN(_layout->line + _layout->lineSize);
+	_layout->rx = M_LIB_CONSOLE_FACTORY__ALIGN(_layout->tx + _layout->txSize + stage);
+	_layout->coalesce = _layout->rx + _layout->rxSize;
+	_layout->coalesceSize = _attr->coalesceSize;
+	_layout->total = _layout->coalesce + _layout->coalesceSize;
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Takes a zeroed block from an arena
+ * \param	_arena [IN|OUT]	:	arena to take from
+ * \param	_size [IN]		:	size of the block
+ * \return	block, NULL if the arena is exhausted
+ * ****************************************************************************/
+static uint8_t* lib_console_factory__take(struct console_arena *_arena, size_t _size)
+{
+	uintptr_t base = (uintptr_t)_arena->base;
+	uintptr_t start = M_LIB_CONSOLE_FACTORY__ALIGN(base + _arena->used);
+
+	if ((start < base + _arena->used) || (start - base > _arena->size) || (_size > _arena->size - (start - base))) {
+		return NULL;
+	}
 
-    lib_list__delete(&s_consoleList,  &_consoleHdl->node, 0, NULL);
-    return EOK;
+	_arena->used = (size_t)(start - base) + _size;
+	memset((void*)start, 0, _size);
+	return (uint8_t*)start;
 }
@@ -0,0 +1,522 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+
+/* c-runtime */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+
+/* project */
+#include <lib_console_format.h>
+
+/* ****************************************************************************
+ * defines
+ * ****************************************************************************/
+#define M_LIB_CONSOLE_FORMAT__FLAG_LEFT		0x01
+#define M_LIB_CONSOLE_FORMAT__FLAG_ZERO		0x02
+#define M_LIB_CONSOLE_FORMAT__FLAG_PLUS		0x04
+#define M_LIB_CONSOLE_FORMAT__FLAG_SPACE	0x08
+#define M_LIB_CONSOLE_FORMAT__FLAG_ALT		0x10
+#define M_LIB_CONSOLE_FORMAT__FLAG_UPPER	0x20
+
+/* ****************************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ****************************************************************************/
+struct console_format_spec {
+	unsigned int flags;
+	int width;
+	int precision;
+};
+
+/* ****************************************************************************
+ * static function declarations
+ * ***************************************************************************/
+static int lib_console_format__write(struct console_format_stream *_stream, const char *_data, size_t _len);
+static int lib_console_format__fill(struct console_format_stream *_stream, char _c, int _count);
+static int lib_console_format__field(struct console_format_stream *_stream, const struct console_format_spec *_spec,
+									 const char *_prefix, size_t _prefixLen, int _zeros, const char *_body, size_t _bodyLen);
+static int lib_console_format__integer(struct console_format_stream *_stream, struct console_format_spec *_spec,
+									   unsigned long long _value, bool _negative, unsigned int _base);
+static char* lib_console_format__dec32(char *_end, uint32_t _value);
+
+/* *******************************************************************
+ * (static) variables declarations
+ * ******************************************************************/
+
+/* "00" to "99", two decimal digits per division */
+static const char s_decPairs[200] = {
+	'0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+	'1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+	'2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+	'3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+	'4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+	'5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+	'6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+	'7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+	'8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+	'9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9'
+};
+
+static const char s_hexDigits[16] = {
+	'0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f'
+};
+
+/* ****************************************************************************
+ * Global Functions
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Formats a "printf" style message chunk by chunk. Supported are the
+ * 			conversions d i u x X o c s p % with the flags - 0 + space #,
+ * 			width, precision and the length modifiers hh h l ll z. Only full
+ * 			chunks are flushed, the last one stays in the buffer (pos bytes),
+ * 			so a message fitting the buffer is formatted without any flush.
+ * \param	_stream [IN|OUT]	:	chunk buffer and flush callback
+ * \param   _format 			:	"printf" style formatted string argument
+ * \param	_ap		    		:	variable argument list
+ * \return	EOK, if successful, ret< EOK returned by the flush callback
+ * ****************************************************************************/
+int lib_console_format__vstream(struct console_format_stream *_stream, const char *_format, va_list _ap)
+{
+	struct console_format_spec spec;
+	const char *literal, *conversion, *str;
+	unsigned long long uvalue;
+	long long svalue;
+	int ret, length;
+	size_t len;
+	char c;
+
+	while (*_format != '\0') {
+		/* copy the literal text up to the next conversion in one piece */
+		literal = _format;
+		while ((*_format != '\0') && (*_format != '%')) {
+			_format++;
+		}
+		ret = lib_console_format__write(_stream, literal, (size_t)(_format - literal));
+		if (ret < EOK) {
+			return ret;
+		}
+		if (*_format == '\0') {
+			break;
+		}
+		conversion = _format++;
+
+		spec.flags = 0;
+		spec.width = 0;
+		spec.precision = -1;
+		for (;; _format++) {
+			if (*_format == '-') {
+				spec.flags |= M_LIB_CONSOLE_FORMAT__FLAG_LEFT;
+			}
+			else if (*_format == '0') {
+				spec.flags |= M_LIB_CONSOLE_FORMAT__FLAG_ZERO;
+			}
+			else if (*_format == '+') {
+				spec.flags |= M_LIB_CONSOLE_FORMAT__FLAG_PLUS;
+			}
+			else if (*_format == ' ') {
+				spec.flags |= M_LIB_CONSOLE_FORMAT__FLAG_SPACE;
+			}
+			else if (*_format == '#') {
+				spec.flags |= M_LIB_CONSOLE_FORMAT__FLAG_ALT;
+			}
+			else {
+				break;
+			}
+		}
+
+		if (*_format == '*') {
+			spec.width = va_arg(_ap, int);
+			if (spec.width < 0) {
+				spec.flags |= M_LIB_CONSOLE_FORMAT__FLAG_LEFT;
+				spec.width = -spec.width;
+			}
+			_format++;
+		}
+		else {
+			while ((*_format >= '0') && (*_format <= '9')) {
+				spec.width = spec.width * 10 + (*_format++ - '0');
+			}
+		}
+
+		if (*_format == '.') {
+			_format++;
+			spec.precision = 0;
+			if (*_format == '*') {
+				spec.precision = va_arg(_ap, int);
+				_format++;
+			}
+			else {
+				while ((*_format >= '0') && (*_format <= '9')) {
+					spec.precision = spec.precision * 10 + (*_format++ - '0');
+				}
+			}
+		}
+
+		/* length modifier: 0 int, 1 long, 2 long long, 3 size_t, -1 short, -2 char */
+		length = 0;
+		if (*_format == 'h') {
+			length = -1;
+			if (*++_format == 'h') {
+				length = -2;
+				_format++;
+			}
+		}
+		else if (*_format == 'l') {
+			length = 1;
+			if (*++_format == 'l') {
+				length = 2;
+				_format++;
+			}
+		}
+		else if (*_format == 'z') {
+			length = 3;
+			_format++;
+		}
+
+		switch (c = *_format++) {
+			case 'd':
+			case 'i':
+				switch (length) {
+					case 1:	 svalue = va_arg(_ap, long); break;
+					case 2:	 svalue = va_arg(_ap, long long); break;
+					case 3:	 svalue = (long long)va_arg(_ap, size_t); break;
+					case -1: svalue = (short)va_arg(_ap, int); break;
+					case -2: svalue = (signed char)va_arg(_ap, int); break;
+					default: svalue = va_arg(_ap, int); break;
+				}
+				uvalue = (svalue < 0) ? (0ULL - (unsigned long long)svalue) : (unsigned long long)svalue;
+				ret = lib_console_format__integer(_stream, &spec, uvalue, (svalue < 0), 10);
+				break;
+
+			case 'u':
+			case 'x':
+			case 'X':
+			case 'o':
+				switch (length) {
+					case 1:	 uvalue = va_arg(_ap, unsigned long); break;
+					case 2:	 uvalue = va_arg(_ap, unsigned long long); break;
+					case 3:	 uvalue = va_arg(_ap, size_t); break;
+					case -1: uvalue = (unsigned short)va_arg(_ap, unsigned int); break;
+					case -2: uvalue = (unsigned char)va_arg(_ap, unsigned int); break;
+					default: uvalue = va_arg(_ap, unsigned int); break;
+				}
+				if (c == 'X') {
+					spec.flags |= M_LIB_CONSOLE_FORMAT__FLAG_UPPER;
+				}
+				spec.flags &= ~(unsigned int)(M_LIB_CONSOLE_FORMAT__FLAG_PLUS | M_LIB_CONSOLE_FORMAT__FLAG_SPACE);
+				ret = lib_console_format__integer(_stream, &spec, uvalue, false, (c == 'u') ? 10 : ((c == 'o') ? 8 : 16));
+				break;
+
+			case 'p':
+				uvalue = (uintptr_t)va_arg(_ap, void*);
+				spec.flags = (spec.flags & M_LIB_CONSOLE_FORMAT__FLAG_LEFT) | M_LIB_CONSOLE_FORMAT__FLAG_ALT;
+				ret = lib_console_format__integer(_stream, &spec, uvalue, false, 16);
+				break;
+
+			case 'c':
+				/* wide characters are not supported */
+				if (length != 0) {
+					ret = lib_console_format__write(_stream, conversion, (size_t)(_format - conversion));
+					break;
+				}
+				c = (char)va_arg(_ap, int);
+				ret = lib_console_format__field(_stream, &spec, NULL, 0, 0, &c, 1);
+				break;
+
+			case 's':
+				if (length != 0) {
+					ret = lib_console_format__write(_stream, conversion, (size_t)(_format - conversion));
+					break;
+				}
+				str = va_arg(_ap, const char*);
+				if (str == NULL) {
+					str = "(null)";
+				}
+				if (spec.precision >= 0) {
+					for (len = 0; (len < (size_t)spec.precision) && (str[len] != '\0'); len++);
+				}
+				else {
+					len = strlen(str);
+				}
+				ret = lib_console_format__field(_stream, &spec, NULL, 0, 0, str, len);
+				break;
+
+			case '%':
+				ret = lib_console_format__write(_stream, "%", 1);
+				break;
+
+			case '\0':
+				_format--;
+				ret = EOK;
+				break;
+
+			default:
+				/* unknown conversion, emit it unchanged with its flags and width */
+				ret = lib_console_format__write(_stream, conversion, (size_t)(_format - conversion));
+				break;
+		}
+
+		if (ret < EOK) {
+			return ret;
+		}
+	}
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Converts a value to decimal digits, two digits per step. The
+ * 			digits are written backwards and end right in front of _end.
+ * \param	_end [OUT]	:	end of the digits, M_LIB_CONSOLE_FORMAT__DEC_MAX
+ * 						bytes in front of it have to be writable
+ * \param	_value [IN]	:	value to convert
+ * \return	first digit
+ * ****************************************************************************/
+char* lib_console_format__dec(char *_end, uint64_t _value)
+{
+	const char *pair;
+
+	/* 64 bit divisions only while needed, the rest in native width */
+	while (_value > UINT32_MAX) {
+		pair = &s_decPairs[(_value % 100) * 2];
+		_value /= 100;
+		*--_end = pair[1];
+		*--_end = pair[0];
+	}
+
+	return lib_console_format__dec32(_end, (uint32_t)_value);
+}
+
+/* ************************************************************************//**
+ * \brief	Converts a value to lower case hex digits, one byte per step.
+ * 			The digits are written backwards and end right in front of _end.
+ * \param	_end [OUT]		:	end of the digits, 16 bytes in front of it have
+ * 							to be writable
+ * \param	_value [IN]		:	value to convert
+ * \param	_width [IN]		:	minimum number of digits, zero padded, up to 16
+ * \return	first digit
+ * ****************************************************************************/
+char* lib_console_format__hex(char *_end, uint64_t _value, unsigned int _width)
+{
+	char *start = _end;
+
+	if (_width > 16) {
+		_width = 16;
+	}
+
+	do {
+		*--start = s_hexDigits[_value & 0x0F];
+		*--start = s_hexDigits[(_value >> 4) & 0x0F];
+		_value >>= 8;
+	} while (_value != 0);
+
+	/* a pair may have produced one leading zero too many */
+	if ((start[0] == '0') && ((size_t)(_end - start) > _width) && (_end - start > 1)) {
+		start++;
+	}
+	while ((size_t)(_end - start) < _width) {
+		*--start = '0';
+	}
+	return start;
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+static char* lib_console_format__dec32(char *_end, uint32_t _value)
+{
+	const char *pair;
+
+	while (_value >= 100) {
+		pair = &s_decPairs[(_value % 100) * 2];
+		_value /= 100;
+		*--_end = pair[1];
+		*--_end = pair[0];
+	}
+
+	if (_value >= 10) {
+		pair = &s_decPairs[_value * 2];
+		*--_end = pair[1];
+		*--_end = pair[0];
+	}
+	else {
+		*--_end = (char)('0' + _value);
+	}
+	return _end;
+}
+
+static int lib_console_format__write(struct console_format_stream *_stream, const char *_data, size_t _len)
+{
+	size_t part;
+	int ret;
+
+	if (_len == 0) {
+		return EOK;
+	}
+
+	_stream->total += _len;
+	_stream->last = _data[_len - 1];
+	while (_len > 0) {
+		if (_stream->pos == _stream->size) {
+			ret = _stream->flush(_stream->arg, _stream->buffer, _stream->pos);
+			_stream->pos = 0;
+			if (ret < EOK) {
+				return ret;
+			}
+		}
+
+		part = _stream->size - _stream->pos;
+		if (part > _len) {
+			part = _len;
+		}
+		memcpy(&_stream->buffer[_stream->pos], _data, part);
+		_stream->pos += part;
+		_data += part;
+		_len -= part;
+	}
+	return EOK;
+}
+
+static int lib_console_format__fill(struct console_format_stream *_stream, char _c, int _count)
+{
+	static const char zeros[] = "0000000000000000";
+	static const char spaces[] = "                ";
+	const char *fill = (_c == '0') ? zeros : spaces;
+	int part, ret;
+
+	while (_count > 0) {
+		part = (_count > (int)(sizeof(zeros) - 1)) ? (int)(sizeof(zeros) - 1) : _count;
+		ret = lib_console_format__write(_stream, fill, (size_t)part);
+		if (ret < EOK) {
+			return ret;
+		}
+		_count -= part;
+	}
+	return EOK;
+}
+
+static int lib_console_format__field(struct console_format_stream *_stream, const struct console_format_spec *_spec,
+									 const char *_prefix, size_t _prefixLen, int _zeros, const char *_body, size_t _bodyLen)
+{
+	int pad, ret;
+
+	pad = _spec->width - (int)(_prefixLen + _bodyLen) - _zeros;
+	if (pad < 0) {
+		pad = 0;
+	}
+
+	if (!(_spec->flags & M_LIB_CONSOLE_FORMAT__FLAG_LEFT)) {
+		if (_spec->flags & M_LIB_CONSOLE_FORMAT__FLAG_ZERO) {
+			/* zero padding goes between sign/prefix and digits */
+			_zeros += pad;
+		}
+		else {
+			ret = lib_console_format__fill(_stream, ' ', pad);
+			if (ret < EOK) {
+				return ret;
+			}
+		}
+	}
+
+	ret = lib_console_format__write(_stream, _prefix, _prefixLen);
+	if (ret < EOK) {
+		return ret;
+	}
+	ret = lib_console_format__fill(_stream, '0', _zeros);
+	if (ret < EOK) {
+		return ret;
+	}
+	ret = lib_console_format__write(_stream, _body, _bodyLen);
+	if (ret < EOK) {
+		return ret;
+	}
+
+	if (_spec->flags & M_LIB_CONSOLE_FORMAT__FLAG_LEFT) {
+		return lib_console_format__fill(_stream, ' ', pad);
+	}
+	return EOK;
+}
+
+static int lib_console_format__integer(struct console_format_stream *_stream, struct console_format_spec *_spec,
+									   unsigned long long _value, bool _negative, unsigned int _base)
+{
+	const char *digits = (_spec->flags & M_LIB_CONSOLE_FORMAT__FLAG_UPPER) ? "0123456789ABCDEF" : "0123456789abcdef";
+	char body[24], prefix[3];
+	size_t bodyLen = 0, prefixLen = 0;
+	int zeros = 0;
+	char *pos = &body[sizeof(body)];
+
+	if (_negative) {
+		prefix[prefixLen++] = '-';
+	}
+	else if (_spec->flags & M_LIB_CONSOLE_FORMAT__FLAG_PLUS) {
+		prefix[prefixLen++] = '+';
+	}
+	else if (_spec->flags & M_LIB_CONSOLE_FORMAT__FLAG_SPACE) {
+		prefix[prefixLen++] = ' ';
+	}
+
+	if ((_spec->flags & M_LIB_CONSOLE_FORMAT__FLAG_ALT) && (_value != 0)) {
+		if (_base == 16) {
+			prefix[prefixLen++] = '0';
+			prefix[prefixLen++] = (_spec->flags & M_LIB_CONSOLE_FORMAT__FLAG_UPPER) ? 'X' : 'x';
+		}
+		else if (_base == 8) {
+			prefix[prefixLen++] = '0';
+		}
+	}
+
+	/* "%.0d" of zero prints no digits at all */
+	if ((_value != 0) || (_spec->precision != 0)) {
+		if (_base == 10) {
+			pos = lib_console_format__dec(pos, _value);
+		}
+		else {
+			do {
+				*--pos = digits[_value % _base];
+				_value /= _base;
+			} while (_value != 0);
+		}
+	}
+	bodyLen = (size_t)(&body[sizeof(body)] - pos);
+
+	if (_spec->precision >= 0) {
+		/* an explicit precision disables the zero flag */
+		_spec->flags &= ~(unsigned int)M_LIB_CONSOLE_FORMAT__FLAG_ZERO;
+		if ((size_t)_spec->precision > bodyLen) {
+			zeros = _spec->precision - (int)bodyLen;
+		}
+	}
+
+	return lib_console_format__field(_stream, _spec, prefix, prefixLen, zeros, pos, bodyLen);
+}
@@ -0,0 +1,287 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+
+/* c-runtime */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdatomic.h>
+
+/* system */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+#include <lib_convention__mem.h>
+#include <lib_thread.h>
+
+/* project */
+#include <lib_console_types_internal.h>
+#include "lib_console_mirror.h"
+
+/* ****************************************************************************
+ * defines
+ * ****************************************************************************/
+#define M_LIB_CONSOLE_MIRROR__HEADER_SIZE	64
+
+/* ****************************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ****************************************************************************/
+
+/* file layout, see lib_console_mirror.h */
+struct console_mirror_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t headerSize;
+	uint64_t size;
+	uint64_t sequence;
+	atomic_uint_least64_t head;
+	atomic_uint_least64_t tail;
+};
+
+struct console_mirror_handle {
+	struct console_mirror_header *header;
+	uint8_t *data;
+	size_t size;
+	size_t mapSize;
+	console_hdl_t owner;
+};
+
+_Static_assert(sizeof(struct console_mirror_header) <= M_LIB_CONSOLE_MIRROR__HEADER_SIZE, "mirror header too large");
+
+/* ****************************************************************************
+ * static function declarations
+ * ***************************************************************************/
+static bool lib_console_mirror__valid(const struct console_mirror_header *_header, size_t _size);
+
+/* ****************************************************************************
+ * Global Functions
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Opens a mirror file, a valid file of the same size is continued
+ * 			and keeps its history, any other file is recreated. The file is
+ * 			mapped shared, written bytes survive a crash of the process.
+ * \param	_path [IN]	:	file to map
+ * \param	_size [IN]	:	ring data in bytes, rounded up to a power of two
+ * \return	console_mirror_hdl_t if successfully, NULL if not successful
+ * ****************************************************************************/
+console_mirror_hdl_t lib_console_mirror__open(const char *_path, size_t _size)
+{
+	console_mirror_hdl_t hdl;
+	struct stat st;
+	size_t size = 1;
+	void *map;
+	int fd;
+
+	if ((_path == NULL) || (_size == 0)) {
+		return NULL;
+	}
+
+	while (size < _size) {
+		size <<= 1;
+	}
+
+	hdl = (console_mirror_hdl_t)alloc_memory(1, sizeof(struct console_mirror_handle));
+	if (hdl == NULL) {
+		return NULL;
+	}
+	hdl->size = size;
+	hdl->mapSize = M_LIB_CONSOLE_MIRROR__HEADER_SIZE + size;
+
+	fd = open(_path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		goto ERR_OPEN;
+	}
+
+	if (fstat(fd, &st) < 0) {
+		goto ERR_FILE;
+	}
+
+	if (((size_t)st.st_size != hdl->mapSize) && (ftruncate(fd, (off_t)hdl->mapSize) < 0)) {
+		goto ERR_FILE;
+	}
+
+	map = mmap(NULL, hdl->mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED) {
+		goto ERR_FILE;
+	}
+	/* the mapping stays valid without the descriptor */
+	close(fd);
+
+	hdl->header = (struct console_mirror_header*)map;
+	hdl->data = &((uint8_t*)map)[M_LIB_CONSOLE_MIRROR__HEADER_SIZE];
+	if (((size_t)st.st_size != hdl->mapSize) || !lib_console_mirror__valid(hdl->header, size)) {
+		/* the magic is written last, a half initialized file is recreated next time */
+		memset(hdl->header, 0, M_LIB_CONSOLE_MIRROR__HEADER_SIZE);
+		hdl->header->version = M_LIB_CONSOLE_MIRROR__VERSION;
+		hdl->header->headerSize = M_LIB_CONSOLE_MIRROR__HEADER_SIZE;
+		hdl->header->size = size;
+		atomic_store_explicit(&hdl->header->head, 0, memory_order_relaxed);
+		atomic_store_explicit(&hdl->header->tail, 0, memory_order_relaxed);
+		atomic_thread_fence(memory_order_release);
+		memcpy(&hdl->header->magic[0], M_LIB_CONSOLE_MIRROR__MAGIC, sizeof(hdl->header->magic));
+	}
+	hdl->header->sequence++;
+	return hdl;
+
+	ERR_FILE:
+	close(fd);
+
+	ERR_OPEN:
+	free_memory(hdl);
+	return NULL;
+}
+
+/* ************************************************************************//**
+ * \brief	Unmaps the mirror file, it is the counter-part of
+ * 			"lib_console_mirror__open". It must not be attached anymore.
+ * \param	_hdl [IN|OUT]	:	mirror handle
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_mirror__close(console_mirror_hdl_t *_hdl)
+{
+	if ((_hdl == NULL) || (*_hdl == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	if ((*_hdl)->owner != NULL) {
+		return -ESTD_BUSY;
+	}
+
+	munmap((*_hdl)->header, (*_hdl)->mapSize);
+	free_memory(*_hdl);
+	*_hdl = NULL;
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Writes the mapped pages back to the file, a crash of the process
+ * 			does not need it, a loss of power does
+ * \param	_hdl [IN]	:	mirror handle
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_mirror__sync(console_mirror_hdl_t _hdl)
+{
+	if (_hdl == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	return (msync(_hdl->header, _hdl->mapSize, MS_SYNC) < 0) ? -ESTD_IO : EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Mirrors every byte the console writes into the file, including
+ * 			the emergency prints. A mirror serves one console at a time.
+ * \param	_hdl [IN]		:	console handle used for communication
+ * \param	_mirror [IN]	:	mirror handle, NULL detaches the current one
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__set_mirror(console_hdl_t _hdl, console_mirror_hdl_t _mirror)
+{
+	int ret = EOK;
+
+	if (_hdl == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	if (_hdl->initialized != M_LIB_CONSOLE__OPENED) {
+		return -EEXEC_NOINIT;
+	}
+
+	/* the writers append under txMtx, the mirror is swapped between two writes */
+	lib_thread__mutex_lock(_hdl->txMtx);
+	if ((_mirror != NULL) && (_mirror->owner != NULL) && (_mirror->owner != _hdl)) {
+		ret = -ESTD_BUSY;
+	}
+	else {
+		if (_hdl->mirror != NULL) {
+			_hdl->mirror->owner = NULL;
+		}
+		if (_mirror != NULL) {
+			_mirror->owner = _hdl;
+		}
+		_hdl->mirror = _mirror;
+	}
+	lib_console__tx_unlock(_hdl);
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Copies written bytes into the mirror file, called with txMtx held
+ * 			or by an emergency print
+ * \param	_hdl [IN]		:	mirror handle
+ * \param	_data [IN]		:	written bytes
+ * \param	_length [IN]	:	number of bytes
+ * \return	void
+ * ****************************************************************************/
+void lib_console_mirror__append(struct console_mirror_handle *_hdl, const void *_data, size_t _length)
+{
+	struct console_mirror_header *header = _hdl->header;
+	const uint8_t *data = (const uint8_t*)_data;
+	uint64_t head = atomic_load_explicit(&header->head, memory_order_relaxed);
+	size_t idx, part;
+
+	/* only the newest bytes of a write larger than the ring are kept */
+	if (_length > _hdl->size) {
+		head += _length - _hdl->size;
+		data += _length - _hdl->size;
+		_length = _hdl->size;
+	}
+
+	/* the bytes about to be overwritten leave the intact range before the copy,
+	   an emergency print overtaking a writer may be overwritten by it */
+	if (head + _length > atomic_load_explicit(&header->tail, memory_order_relaxed) + _hdl->size) {
+		atomic_store_explicit(&header->tail, head + _length - _hdl->size, memory_order_release);
+	}
+
+	idx = (size_t)head & (_hdl->size - 1);
+	part = (_length < _hdl->size - idx) ? _length : _hdl->size - idx;
+	memcpy(&_hdl->data[idx], data, part);
+	memcpy(&_hdl->data[0], &data[part], _length - part);
+	atomic_store_explicit(&header->head, head + _length, memory_order_release);
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+static bool lib_console_mirror__valid(const struct console_mirror_header *_header, size_t _size)
+{
+	uint64_t head = atomic_load_explicit(&_header->head, memory_order_relaxed);
+	uint64_t tail = atomic_load_explicit(&_header->tail, memory_order_relaxed);
+
+	return (memcmp(&_header->magic[0], M_LIB_CONSOLE_MIRROR__MAGIC, sizeof(_header->magic)) == 0) &&
+		   (_header->version == M_LIB_CONSOLE_MIRROR__VERSION) &&
+		   (_header->headerSize == M_LIB_CONSOLE_MIRROR__HEADER_SIZE) &&
+		   (_header->size == _size) && (tail <= head) && (head - tail <= _size);
+}
@@ -0,0 +1,180 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+
+/* c-runtime */
+#include <stdint.h>
+#include <string.h>
+
+/* system */
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* project */
+#include <lib_console_newline.h>
+
+/* ****************************************************************************
+ * defines
+ * ****************************************************************************/
+#define M_LIB_CONSOLE_NEWLINE__LF		'\n'
+#define M_LIB_CONSOLE_NEWLINE__CR		'\r'
+
+/* every byte of a word set to the same value */
+#define M_LIB_CONSOLE_NEWLINE__BYTES(_b)	((uint64_t)(_b) * 0x0101010101010101ull)
+
+/* ****************************************************************************
+ * static function declarations
+ * ***************************************************************************/
+#if !defined(__SSE2__)
+static uint64_t lib_console_newline__match(const char *_data);
+#endif
+
+/* ****************************************************************************
+ * Global Functions
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Searches the first new line of a buffer
+ * \param	_data [IN]	:	buffer to search
+ * \param	_len [IN]	:	number of bytes
+ * \return	index of the first '\n', _len if there is none
+ * ****************************************************************************/
+size_t lib_console_newline__find(const char *_data, size_t _len)
+{
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	const __m128i lf = _mm_set1_epi8(M_LIB_CONSOLE_NEWLINE__LF);
+	unsigned int mask;
+
+	for (; i + 16 <= _len; i += 16) {
+		mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)&_data[i]), lf));
+		if (mask != 0) {
+			return i + (size_t)__builtin_ctz(mask);
+		}
+	}
+#else
+	/* eight bytes per step, the hit is located byte wise */
+	for (; i + 8 <= _len; i += 8) {
+		if (lib_console_newline__match(&_data[i]) != 0) {
+			break;
+		}
+	}
+#endif
+
+	for (; i < _len; i++) {
+		if (_data[i] == M_LIB_CONSOLE_NEWLINE__LF) {
+			return i;
+		}
+	}
+	return _len;
+}
+
+/* ************************************************************************//**
+ * \brief	Counts the new lines of a buffer, it is the number of bytes the
+ * 			translation adds
+ * \param	_data [IN]	:	buffer to search
+ * \param	_len [IN]	:	number of bytes
+ * \return	number of '\n'
+ * ****************************************************************************/
+size_t lib_console_newline__count(const char *_data, size_t _len)
+{
+	size_t i = 0, count = 0;
+
+#if defined(__SSE2__)
+	const __m128i lf = _mm_set1_epi8(M_LIB_CONSOLE_NEWLINE__LF);
+
+	for (; i + 16 <= _len; i += 16) {
+		count += (size_t)__builtin_popcount((unsigned int)_mm_movemask_epi8(
+					_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)&_data[i]), lf)));
+	}
+#else
+	for (; i + 8 <= _len; i += 8) {
+		count += (size_t)__builtin_popcountll(lib_console_newline__match(&_data[i]));
+	}
+#endif
+
+	for (; i < _len; i++) {
+		count += (_data[i] == M_LIB_CONSOLE_NEWLINE__LF);
+	}
+	return count;
+}
+
+/* ************************************************************************//**
+ * \brief	Copies a buffer and sends every '\n' as "\n\r". The text between
+ * 			the new lines is block copied, a new line is never split from
+ * 			its carriage return.
+ * \param	_dst [OUT]			:	translated text
+ * \param	_size [IN]			:	size of _dst, at least 2 bytes
+ * \param	_src [IN]			:	text to translate
+ * \param	_len [IN]			:	number of bytes of _src
+ * \param	_consumed [OUT]		:	number of bytes of _src translated
+ * \return	number of bytes written to _dst
+ * ****************************************************************************/
+size_t lib_console_newline__translate(char *_dst, size_t _size, const char *_src, size_t _len, size_t *_consumed)
+{
+	size_t in = 0, out = 0, block;
+
+	while (in < _len) {
+		block = lib_console_newline__find(&_src[in], _len - in);
+		if (block > _size - out) {
+			block = _size - out;
+		}
+		memcpy(&_dst[out], &_src[in], block);
+		in += block;
+		out += block;
+
+		if ((in == _len) || (_src[in] != M_LIB_CONSOLE_NEWLINE__LF) || (_size - out < 2)) {
+			break;
+		}
+		_dst[out++] = M_LIB_CONSOLE_NEWLINE__LF;
+		_dst[out++] = M_LIB_CONSOLE_NEWLINE__CR;
+		in++;
+	}
+
+	*_consumed = in;
+	return out;
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+#if !defined(__SSE2__)
+static uint64_t lib_console_newline__match(const char *_data)
+{
+	uint64_t word, low;
+
+	/* one bit 0x80 per byte equal to '\n', exact without carries between bytes */
+	memcpy(&word, _data, sizeof(word));
+	word ^= M_LIB_CONSOLE_NEWLINE__BYTES(M_LIB_CONSOLE_NEWLINE__LF);
+	low = (word & M_LIB_CONSOLE_NEWLINE__BYTES(0x7F)) + M_LIB_CONSOLE_NEWLINE__BYTES(0x7F);
+	return ~(low | word | M_LIB_CONSOLE_NEWLINE__BYTES(0x7F));
+}
+#endif
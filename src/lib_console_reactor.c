@@ -0,0 +1,330 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+
+/* c-runtime */
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+
+/* system */
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+#include <lib_convention__mem.h>
+
+/* project */
+#include <lib_console_types_internal.h>
+#include "lib_console.h"
+#include "lib_console_factory.h"
+#include "lib_console_reactor.h"
+
+/* ****************************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ****************************************************************************/
+struct console_reactor_member {
+	console_hdl_t hdl;
+	int fd;
+	/* false after a transport failure, the console waits to be reopened */
+	bool polled;
+};
+
+struct console_reactor_handle {
+	int epFd;
+	int wakeFd;
+	console_line_cb_t cb;
+	void *arg;
+	struct console_reactor_member members[M_LIB_CONSOLE__MAX_INSTANCES];
+	unsigned int count;
+	/* events of the running round, a detached console is cleared from them */
+	struct epoll_event events[M_LIB_CONSOLE__MAX_INSTANCES + 1];
+	int eventIdx;
+	int eventCount;
+	console_hdl_t current;
+};
+
+/* ****************************************************************************
+ * static function declarations
+ * ***************************************************************************/
+static void lib_console_reactor__attach_all(console_reactor_hdl_t _hdl);
+static struct console_reactor_member* lib_console_reactor__member(console_reactor_hdl_t _hdl, console_hdl_t _consoleHdl);
+static bool lib_console_reactor__line(void *_arg, console_hdl_t _hdl, const char *_line, size_t _len);
+
+/* ****************************************************************************
+ * Global Functions
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Creation of a reactor serving the received lines of all opened
+ * 			consoles of the factory on the calling thread. Consoles without
+ * 			readiness descriptor (see lib_console__fileno) or with a running
+ * 			receive engine are left out.
+ * \param	_cb [IN]	:	called with every completed line
+ * \param	_arg [IN]	:	argument passed to the callback
+ * \return	console_reactor_hdl_t if successfully, NULL if not successful
+ * ****************************************************************************/
+console_reactor_hdl_t lib_console_reactor__create(console_line_cb_t _cb, void *_arg)
+{
+	console_reactor_hdl_t hdl;
+	struct epoll_event event;
+
+	if (_cb == NULL) {
+		return NULL;
+	}
+
+	hdl = (console_reactor_hdl_t)alloc_memory(1, sizeof(struct console_reactor_handle));
+	if (hdl == NULL) {
+		return NULL;
+	}
+
+	hdl->epFd = epoll_create1(EPOLL_CLOEXEC);
+	if (hdl->epFd < 0) {
+		goto ERR_EPOLL;
+	}
+
+	hdl->wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (hdl->wakeFd < 0) {
+		goto ERR_EVENT;
+	}
+
+	/* the reactor itself marks the wakeup event */
+	event.events = EPOLLIN;
+	event.data.ptr = hdl;
+	if (epoll_ctl(hdl->epFd, EPOLL_CTL_ADD, hdl->wakeFd, &event) < 0) {
+		goto ERR_CTL;
+	}
+
+	hdl->cb = _cb;
+	hdl->arg = _arg;
+	return hdl;
+
+	ERR_CTL:
+	close(hdl->wakeFd);
+
+	ERR_EVENT:
+	close(hdl->epFd);
+
+	ERR_EPOLL:
+	free_memory(hdl);
+	return NULL;
+}
+
+/* ************************************************************************//**
+ * \brief	Destroys the reactor, it is the counter-part of
+ * 			"lib_console_reactor__create"
+ * \param	_hdl [IN|OUT]	:	reactor handle
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_reactor__destroy(console_reactor_hdl_t *_hdl)
+{
+	unsigned int idx;
+
+	if ((_hdl == NULL) || (*_hdl == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	/* the consoles are released for getline or another reactor */
+	for (idx = 0; idx < (*_hdl)->count; idx++) {
+		(*_hdl)->members[idx].hdl->reactor = NULL;
+	}
+
+	close((*_hdl)->wakeFd);
+	close((*_hdl)->epFd);
+	free_memory(*_hdl);
+	*_hdl = NULL;
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Waits for received data on the consoles and delivers the completed
+ * 			lines. Consoles opened since the last round are added first.
+ * 			Consoles are closed from the callbacks or while no round runs.
+ * \param	_hdl [IN]		:	reactor handle
+ * \param	_timeout [IN]	:	wait time in ms, -1 waits until data or wakeup
+ * \return	number of serviced consoles, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_reactor__run(console_reactor_hdl_t _hdl, int _timeout)
+{
+	struct console_reactor_member *member;
+	console_hdl_t consoleHdl;
+	uint64_t wake;
+	int ret, served = 0;
+
+	if (_hdl == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	lib_console_reactor__attach_all(_hdl);
+
+	ret = epoll_wait(_hdl->epFd, &_hdl->events[0], M_LIB_CONSOLE__MAX_INSTANCES + 1, _timeout);
+	if (ret < 0) {
+		return (errno == EINTR) ? 0 : -ESTD_IO;
+	}
+
+	_hdl->eventCount = ret;
+	for (_hdl->eventIdx = 0; _hdl->eventIdx < _hdl->eventCount; _hdl->eventIdx++) {
+		consoleHdl = (console_hdl_t)_hdl->events[_hdl->eventIdx].data.ptr;
+		if (consoleHdl == NULL) {
+			/* closed by a callback of this round */
+			continue;
+		}
+
+		if ((void*)consoleHdl == (void*)_hdl) {
+			if (read(_hdl->wakeFd, &wake, sizeof(wake)) < 0) {
+				/* already consumed, nothing to do */
+			}
+			continue;
+		}
+
+		_hdl->current = consoleHdl;
+		ret = lib_console__rx_poll(consoleHdl, &lib_console_reactor__line, _hdl);
+		if ((ret < EOK) && (_hdl->current == consoleHdl)) {
+			/* failed transport, e.g. closed peer, do not spin on it */
+			member = lib_console_reactor__member(_hdl, consoleHdl);
+			epoll_ctl(_hdl->epFd, EPOLL_CTL_DEL, member->fd, NULL);
+			member->polled = false;
+		}
+		served++;
+	}
+
+	_hdl->eventCount = 0;
+	_hdl->current = NULL;
+	return served;
+}
+
+/* ************************************************************************//**
+ * \brief	Returns from a waiting lib_console_reactor__run, e.g. to stop the
+ * 			reactor thread or to pick up a just opened console
+ * \param	_hdl [IN]	:	reactor handle
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_reactor__wakeup(console_reactor_hdl_t _hdl)
+{
+	uint64_t wake = 1;
+
+	if (_hdl == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	/* a full counter still wakes the reactor */
+	if ((write(_hdl->wakeFd, &wake, sizeof(wake)) < 0) && (errno != EAGAIN)) {
+		return -ESTD_IO;
+	}
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Removes a closing console from its reactor
+ * \param	_hdl [IN]	:	console handle used for communication
+ * \return	void
+ * ****************************************************************************/
+void lib_console_reactor__detach(console_hdl_t _hdl)
+{
+	console_reactor_hdl_t reactor = _hdl->reactor;
+	struct console_reactor_member *member;
+	int idx;
+
+	member = lib_console_reactor__member(reactor, _hdl);
+	if (member->polled) {
+		epoll_ctl(reactor->epFd, EPOLL_CTL_DEL, member->fd, NULL);
+	}
+	*member = reactor->members[--reactor->count];
+
+	/* the console may be freed right after, later events of the round must not reach it */
+	for (idx = reactor->eventIdx + 1; idx < reactor->eventCount; idx++) {
+		if (reactor->events[idx].data.ptr == _hdl) {
+			reactor->events[idx].data.ptr = NULL;
+		}
+	}
+	if (reactor->current == _hdl) {
+		reactor->current = NULL;
+	}
+	_hdl->reactor = NULL;
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+static void lib_console_reactor__attach_all(console_reactor_hdl_t _hdl)
+{
+	struct console_reactor_member *member;
+	struct epoll_event event;
+	console_hdl_t consoleHdl;
+	unsigned int idx, count;
+	int fd;
+
+	count = lib_console_factory__slots();
+	for (idx = 0; idx < count; idx++) {
+		consoleHdl = lib_console_factory__acquire(idx);
+		if (consoleHdl == NULL) {
+			continue;
+		}
+
+		/* the reference only covers the attach, a member leaves the reactor
+		   with lib_console__close before its console is freed */
+		fd = -1;
+		if ((consoleHdl->reactor == NULL) && (consoleHdl->initialized == M_LIB_CONSOLE__OPENED) &&
+			(!consoleHdl->rxActive)) {
+			fd = lib_console__fileno(consoleHdl);
+		}
+
+		if (fd >= 0) {
+			member = &_hdl->members[_hdl->count++];
+			member->hdl = consoleHdl;
+			member->fd = fd;
+			event.events = EPOLLIN;
+			event.data.ptr = consoleHdl;
+			member->polled = (epoll_ctl(_hdl->epFd, EPOLL_CTL_ADD, fd, &event) == 0);
+
+			lib_console_editor__begin(&consoleHdl->editor, NULL, 0);
+			consoleHdl->reactor = _hdl;
+		}
+		lib_console_factory__release(consoleHdl);
+	}
+}
+
+static struct console_reactor_member* lib_console_reactor__member(console_reactor_hdl_t _hdl, console_hdl_t _consoleHdl)
+{
+	unsigned int idx;
+
+	for (idx = 0; _hdl->members[idx].hdl != _consoleHdl; idx++) {
+	}
+	return &_hdl->members[idx];
+}
+
+static bool lib_console_reactor__line(void *_arg, console_hdl_t _hdl, const char *_line, size_t _len)
+{
+	console_reactor_hdl_t reactor = (console_reactor_hdl_t)_arg;
+
+	reactor->cb(reactor->arg, _hdl, _line, _len);
+	return (reactor->current == _hdl);
+}
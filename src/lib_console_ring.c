@@ -0,0 +1,385 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+
+/* c-runtime */
+#include <stdint.h>
+#include <string.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+#include <lib_convention__mem.h>
+#include <lib_thread.h>
+
+/* project */
+#include <lib_console_ring.h>
+
+/* ****************************************************************************
+ * defines
+ * ****************************************************************************/
+#define M_LIB_CONSOLE_RING__HDR_SIZE	sizeof(uint32_t)
+#define M_LIB_CONSOLE_RING__ALIGN(x)	(((x) + 3) & ~(size_t)3)
+#define M_LIB_CONSOLE_RING__PAD_FLAG	0x1
+#define M_LIB_CONSOLE_RING__SPIN_LIMIT	1000
+
+/* ****************************************************************************
+ * static function declarations
+ * ***************************************************************************/
+static inline uint32_t lib_console_ring__read_hdr(const struct console_ring *_ring, size_t _pos);
+static inline void lib_console_ring__write_hdr(struct console_ring *_ring, size_t _pos, uint32_t _hdr);
+static inline bool lib_console_ring__valid_hdr(const struct console_ring *_ring, size_t _pos, uint32_t _hdr);
+
+/* ****************************************************************************
+ * Global Functions
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Allocates the ring storage, the size is rounded up to a power of two
+ * \param	_ring [IN|OUT]	:	ring to initialize
+ * \param	_size [IN]		:	requested storage size in bytes
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_ring__init(struct console_ring *_ring, size_t _size)
+{
+	size_t size = lib_console_ring__storage_size(_size);
+	uint8_t *buffer;
+
+	if (_ring == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	buffer = (uint8_t*)alloc_memory(1, size);
+	if (buffer == NULL) {
+		return -ESTD_NOMEM;
+	}
+
+	lib_console_ring__init_static(_ring, buffer, size);
+	_ring->owned = true;
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Initializes the ring on storage of the caller, cleanup leaves it
+ * \param	_ring [IN|OUT]	:	ring to initialize
+ * \param	_buffer [IN]		:	storage of the ring
+ * \param	_size [IN]		:	storage size, see lib_console_ring__storage_size
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_ring__init_static(struct console_ring *_ring, uint8_t *_buffer, size_t _size)
+{
+	if ((_ring == NULL) || (_buffer == NULL) || (_size != lib_console_ring__storage_size(_size))) {
+		return -ESTD_INVAL;
+	}
+
+	_ring->buffer = _buffer;
+	_ring->size = _size;
+	_ring->owned = false;
+	atomic_init(&_ring->head, 0);
+	atomic_init(&_ring->commit, 0);
+	atomic_init(&_ring->tail, 0);
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Storage size of a ring, the requested size rounded up to a power of two
+ * \param	_size [IN]	:	requested storage size in bytes
+ * \return	storage size in bytes
+ * ****************************************************************************/
+size_t lib_console_ring__storage_size(size_t _size)
+{
+	size_t size = M_LIB_CONSOLE_RING__MIN_SIZE;
+
+	while (size < _size) {
+		size <<= 1;
+	}
+	return size;
+}
+
+/* ************************************************************************//**
+ * \brief	Frees the ring storage, it is the counter-part of lib_console_ring__init
+ * \param	_ring [IN|OUT]	:	ring to cleanup
+ * \return	void
+ * ****************************************************************************/
+void lib_console_ring__cleanup(struct console_ring *_ring)
+{
+	if ((_ring == NULL) || (_ring->buffer == NULL)) {
+		return;
+	}
+	if (_ring->owned) {
+		free_memory(_ring->buffer);
+	}
+	_ring->buffer = NULL;
+	_ring->size = 0;
+}
+
+/* ************************************************************************//**
+ * \brief	Largest payload a single record can carry
+ * \param	_ring [IN]	:	ring to query
+ * \return	maximum payload length in bytes
+ * ****************************************************************************/
+size_t lib_console_ring__max_payload(const struct console_ring *_ring)
+{
+	return (_ring->size / 2) - M_LIB_CONSOLE_RING__HDR_SIZE;
+}
+
+/* ************************************************************************//**
+ * \brief	Reserves a record of _len payload bytes
+ * \param	_ring [IN]	:	ring to reserve space in
+ * \param	_len [IN]	:	payload length
+ * \param	_pos [OUT]	:	record position, to be passed to lib_console_ring__commit
+ * \return	pointer to the payload area, NULL if the ring is full
+ * ****************************************************************************/
+uint8_t* lib_console_ring__reserve(struct console_ring *_ring, size_t _len, size_t *_pos)
+{
+	size_t head, tail, offset, pad, recSize;
+	size_t mask = _ring->size - 1;
+
+	if (_len > lib_console_ring__max_payload(_ring)) {
+		return NULL;
+	}
+	recSize = M_LIB_CONSOLE_RING__ALIGN(M_LIB_CONSOLE_RING__HDR_SIZE + _len);
+
+	head = atomic_load_explicit(&_ring->head, memory_order_relaxed);
+	for (;;) {
+		tail = atomic_load_explicit(&_ring->tail, memory_order_acquire);
+		if (head - tail > _ring->size) {
+			/* head snapshot older than tail, refresh it */
+			head = atomic_load_explicit(&_ring->head, memory_order_relaxed);
+			continue;
+		}
+
+		/* records never wrap, fill the end of the storage with a pad record */
+		offset = head & mask;
+		pad = (offset + recSize > _ring->size) ? _ring->size - offset : 0;
+		if (head + pad + recSize - tail > _ring->size) {
+			return NULL;
+		}
+
+		if (atomic_compare_exchange_weak_explicit(&_ring->head, &head, head + pad + recSize,
+												  memory_order_relaxed, memory_order_relaxed)) {
+			break;
+		}
+	}
+
+	if (pad) {
+		lib_console_ring__write_hdr(_ring, head, (uint32_t)(pad << 1) | M_LIB_CONSOLE_RING__PAD_FLAG);
+	}
+	lib_console_ring__write_hdr(_ring, head + pad, (uint32_t)(_len << 1));
+
+	*_pos = head;
+	return &_ring->buffer[((head + pad) & mask) + M_LIB_CONSOLE_RING__HDR_SIZE];
+}
+
+/* ************************************************************************//**
+ * \brief	Publishes a record reserved by lib_console_ring__reserve
+ * \param	_ring [IN]	:	ring the record was reserved in
+ * \param	_pos [IN]	:	record position returned by the reservation
+ * \return	void
+ * ****************************************************************************/
+void lib_console_ring__commit(struct console_ring *_ring, size_t _pos)
+{
+	uint32_t hdr;
+	size_t end = _pos;
+	unsigned int spin = 0;
+
+	hdr = lib_console_ring__read_hdr(_ring, end);
+	if (hdr & M_LIB_CONSOLE_RING__PAD_FLAG) {
+		end += hdr >> 1;
+		hdr = lib_console_ring__read_hdr(_ring, end);
+	}
+	end += M_LIB_CONSOLE_RING__ALIGN(M_LIB_CONSOLE_RING__HDR_SIZE + (hdr >> 1));
+
+	/* publish in reservation order, earlier producers are only copying */
+	while (atomic_load_explicit(&_ring->commit, memory_order_acquire) != _pos) {
+		if (++spin > M_LIB_CONSOLE_RING__SPIN_LIMIT) {
+			lib_thread__msleep(0);
+			spin = 0;
+		}
+	}
+	atomic_store_explicit(&_ring->commit, end, memory_order_release);
+}
+
+/* ************************************************************************//**
+ * \brief	Copies a message into the ring as one record
+ * \param	_ring [IN]	:	ring to push to
+ * \param	_data [IN]	:	message
+ * \param	_len [IN]	:	message length
+ * \return	EOK, -ESTD_AGAIN if the ring is full, -ESTD_MSGSIZE if the message
+ * 			can never fit
+ * ****************************************************************************/
+int lib_console_ring__push(struct console_ring *_ring, const uint8_t *_data, size_t _len)
+{
+	uint8_t *payload;
+	size_t pos;
+
+	if (_len > lib_console_ring__max_payload(_ring)) {
+		return -ESTD_MSGSIZE;
+	}
+
+	payload = lib_console_ring__reserve(_ring, _len, &pos);
+	if (payload == NULL) {
+		return -ESTD_AGAIN;
+	}
+
+	memcpy(payload, _data, _len);
+	lib_console_ring__commit(_ring, pos);
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Copies as many committed records as fit into _dst and releases them
+ * \param	_ring [IN]	:	ring to pop from (single consumer only)
+ * \param	_dst [OUT]	:	destination buffer
+ * \param	_size [IN]	:	destination size, at least lib_console_ring__max_payload
+ * \return	number of bytes copied, 0 if no committed record is pending
+ * ****************************************************************************/
+size_t lib_console_ring__pop(struct console_ring *_ring, uint8_t *_dst, size_t _size)
+{
+	size_t tail, commit, next, len, copied = 0;
+	uint32_t hdr;
+	size_t mask = _ring->size - 1;
+
+	tail = atomic_load_explicit(&_ring->tail, memory_order_acquire);
+	commit = atomic_load_explicit(&_ring->commit, memory_order_acquire);
+
+	while (tail != commit) {
+		hdr = lib_console_ring__read_hdr(_ring, tail);
+		if (!lib_console_ring__valid_hdr(_ring, tail, hdr)) {
+			/* the record was discarded and its space reused meanwhile */
+			tail = atomic_load_explicit(&_ring->tail, memory_order_acquire);
+			commit = atomic_load_explicit(&_ring->commit, memory_order_acquire);
+			continue;
+		}
+
+		if (hdr & M_LIB_CONSOLE_RING__PAD_FLAG) {
+			len = 0;
+			next = tail + (hdr >> 1);
+		}
+		else {
+			len = hdr >> 1;
+			if (copied + len > _size) {
+				break;
+			}
+			memcpy(&_dst[copied], &_ring->buffer[(tail & mask) + M_LIB_CONSOLE_RING__HDR_SIZE], len);
+			next = tail + M_LIB_CONSOLE_RING__ALIGN(M_LIB_CONSOLE_RING__HDR_SIZE + len);
+		}
+
+		/* the release only succeeds if nobody discarded the record meanwhile,
+		   a discarding producer may have seen a newer commit than ours */
+		if (!atomic_compare_exchange_strong_explicit(&_ring->tail, &tail, next,
+													 memory_order_acq_rel, memory_order_acquire)) {
+			commit = atomic_load_explicit(&_ring->commit, memory_order_acquire);
+			continue;
+		}
+		copied += len;
+		tail = next;
+	}
+	return copied;
+}
+
+/* ************************************************************************//**
+ * \brief	Discards the oldest committed record, may be called by producers
+ * 			concurrently to the consumer
+ * \param	_ring [IN]	:	ring to discard from
+ * \param	_len [OUT]	:	payload length of the discarded record
+ * \return	EOK, -ESTD_AGAIN if no committed record is pending
+ * ****************************************************************************/
+int lib_console_ring__drop(struct console_ring *_ring, size_t *_len)
+{
+	size_t tail, next;
+	uint32_t hdr;
+
+	tail = atomic_load_explicit(&_ring->tail, memory_order_acquire);
+	for (;;) {
+		if (tail == atomic_load_explicit(&_ring->commit, memory_order_acquire)) {
+			return -ESTD_AGAIN;
+		}
+
+		hdr = lib_console_ring__read_hdr(_ring, tail);
+		if (!lib_console_ring__valid_hdr(_ring, tail, hdr)) {
+			tail = atomic_load_explicit(&_ring->tail, memory_order_acquire);
+			continue;
+		}
+
+		if (hdr & M_LIB_CONSOLE_RING__PAD_FLAG) {
+			next = tail + (hdr >> 1);
+		}
+		else {
+			next = tail + M_LIB_CONSOLE_RING__ALIGN(M_LIB_CONSOLE_RING__HDR_SIZE + (hdr >> 1));
+		}
+
+		/* competes with the consumer and other producers for the same record */
+		if (!atomic_compare_exchange_strong_explicit(&_ring->tail, &tail, next,
+													 memory_order_acq_rel, memory_order_acquire)) {
+			continue;
+		}
+
+		if (hdr & M_LIB_CONSOLE_RING__PAD_FLAG) {
+			tail = next;
+			continue;
+		}
+		*_len = hdr >> 1;
+		return EOK;
+	}
+}
+
+/* ************************************************************************//**
+ * \brief	Checks if committed records are pending
+ * \param	_ring [IN]	:	ring to query
+ * \return	true if no committed record is pending
+ * ****************************************************************************/
+bool lib_console_ring__empty(struct console_ring *_ring)
+{
+	return atomic_load(&_ring->tail) == atomic_load(&_ring->commit);
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+static inline uint32_t lib_console_ring__read_hdr(const struct console_ring *_ring, size_t _pos)
+{
+	uint32_t hdr;
+	memcpy(&hdr, &_ring->buffer[_pos & (_ring->size - 1)], sizeof(hdr));
+	return hdr;
+}
+
+static inline void lib_console_ring__write_hdr(struct console_ring *_ring, size_t _pos, uint32_t _hdr)
+{
+	memcpy(&_ring->buffer[_pos & (_ring->size - 1)], &_hdr, sizeof(_hdr));
+}
+
+static inline bool lib_console_ring__valid_hdr(const struct console_ring *_ring, size_t _pos, uint32_t _hdr)
+{
+	size_t offset = _pos & (_ring->size - 1);
+
+	if (_hdr & M_LIB_CONSOLE_RING__PAD_FLAG) {
+		return (offset + (_hdr >> 1)) == _ring->size;
+	}
+	return (offset + M_LIB_CONSOLE_RING__HDR_SIZE + (_hdr >> 1)) <= _ring->size;
+}
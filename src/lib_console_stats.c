@@ -0,0 +1,128 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+
+/* c-runtime */
+#include <stdint.h>
+#include <string.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+
+/* project */
+#include <lib_console_types_internal.h>
+#include <lib_console_stats.h>
+#include "lib_console.h"
+
+/* ****************************************************************************
+ * Global Functions
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Returns a snapshot of the console counters and histograms
+ * \param	_hdl [IN]		:	console handle used for communication
+ * \param	_stats [OUT]	:	snapshot
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console__get_stats(console_hdl_t _hdl, struct console_stats *_stats)
+{
+	struct console_stats_data *data;
+
+	if ((_hdl == NULL) || (_stats == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	data = &_hdl->stats;
+	_stats->messages = atomic_load_explicit(&data->messages, memory_order_relaxed);
+	_stats->bytes = atomic_load_explicit(&data->bytes, memory_order_relaxed);
+	_stats->streamed = atomic_load_explicit(&data->streamed, memory_order_relaxed);
+	_stats->truncations = atomic_load_explicit(&data->truncations, memory_order_relaxed);
+	_stats->serialErrors = atomic_load_explicit(&data->serialErrors, memory_order_relaxed);
+	_stats->dropMessages = atomic_load_explicit(&_hdl->txDropMsgs, memory_order_relaxed);
+	_stats->dropBytes = atomic_load_explicit(&_hdl->txDropBytes, memory_order_relaxed);
+	lib_console_stats__snapshot(&data->lockWait, &_stats->lockWait);
+	lib_console_stats__snapshot(&data->format, &_stats->format);
+	lib_console_stats__snapshot(&data->write, &_stats->write);
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Estimates a percentile of a histogram
+ * \param	_hist [IN]		:	histogram of lib_console__get_stats
+ * \param	_permille [IN]	:	percentile in 1/1000, e.g. 990 for p99
+ * \return	upper bound of the bucket holding the percentile in ns
+ * ****************************************************************************/
+uint64_t lib_console__stats_percentile(const struct console_histogram *_hist, unsigned int _permille)
+{
+	uint64_t rank, seen = 0;
+	unsigned int idx, exponent, sub;
+
+	if ((_hist == NULL) || (_hist->count == 0)) {
+		return 0;
+	}
+
+	rank = (_hist->count * (_permille > 1000 ? 1000 : _permille) + 999) / 1000;
+	for (idx = 0; idx < M_LIB_CONSOLE__HIST_BUCKETS - 1; idx++) {
+		seen += _hist->bucket[idx];
+		if (seen >= rank) {
+			break;
+		}
+	}
+
+	if (idx == M_LIB_CONSOLE__HIST_BUCKETS - 1) {
+		return _hist->maxNs;
+	}
+
+	/* the lower bound of the next bucket bounds this one */
+	idx++;
+	if (idx < (1u << M_LIB_CONSOLE__HIST_SUB_BITS)) {
+		return idx - 1;
+	}
+	exponent = (idx >> M_LIB_CONSOLE__HIST_SUB_BITS) + M_LIB_CONSOLE__HIST_SUB_BITS - 1;
+	sub = idx & ((1u << M_LIB_CONSOLE__HIST_SUB_BITS) - 1);
+	return ((uint64_t)((1u << M_LIB_CONSOLE__HIST_SUB_BITS) + sub) << (exponent - M_LIB_CONSOLE__HIST_SUB_BITS)) - 1;
+}
+
+/* ************************************************************************//**
+ * \brief	Copies the histogram counters into the public representation
+ * \param	_data [IN]	:	histogram to read
+ * \param	_hist [OUT]	:	snapshot
+ * \return	void
+ * ****************************************************************************/
+void lib_console_stats__snapshot(struct console_histogram_data *_data, struct console_histogram *_hist)
+{
+	unsigned int idx;
+
+	_hist->count = atomic_load_explicit(&_data->count, memory_order_relaxed);
+	_hist->sumNs = atomic_load_explicit(&_data->sumNs, memory_order_relaxed);
+	_hist->maxNs = atomic_load_explicit(&_data->maxNs, memory_order_relaxed);
+	for (idx = 0; idx < M_LIB_CONSOLE__HIST_BUCKETS; idx++) {
+		_hist->bucket[idx] = atomic_load_explicit(&_data->bucket[idx], memory_order_relaxed);
+	}
+}
@@ -0,0 +1,126 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+
+/* c-runtime */
+#include <stdint.h>
+#include <string.h>
+
+/* project */
+#include <lib_console_timestamp.h>
+
+/* ****************************************************************************
+ * static function declarations
+ * ***************************************************************************/
+static void lib_console_timestamp__full(struct console_timestamp_cache *_cache, enum console_timestamp _mode, uint64_t _value);
+
+/* ****************************************************************************
+ * Global Functions
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Updates the cached prefix to a new time
+ * \param	_cache [IN|OUT]	:	prefix of the previous call, zero initialized
+ * 								before the first one
+ * \param	_mode [IN]		:	resolution of the prefix, not CONSOLE_TIMESTAMP_OFF
+ * \param	_ns [IN]		:	monotonic time in ns
+ * \return	length of the prefix in _cache->text
+ * ****************************************************************************/
+size_t lib_console_timestamp__render(struct console_timestamp_cache *_cache, enum console_timestamp _mode, uint64_t _ns)
+{
+	uint64_t value, now, old;
+	size_t pos;
+
+	value = (_mode == CONSOLE_TIMESTAMP_MS) ? _ns / 1000000u : _ns / 1000u;
+	if ((_cache->mode != _mode) || (value < _cache->value) || (value >= _cache->limit)) {
+		lib_console_timestamp__full(_cache, _mode, value);
+		return _cache->len;
+	}
+
+	/* digits above the first equal quotient are the same in both values */
+	now = value;
+	old = _cache->value;
+	pos = _cache->last;
+	while (now != old) {
+		if (pos == _cache->dot) {
+			pos--;
+		}
+		_cache->text[pos--] = (char)('0' + now % 10);
+		now /= 10;
+		old /= 10;
+	}
+	_cache->value = value;
+	return _cache->len;
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+static void lib_console_timestamp__full(struct console_timestamp_cache *_cache, enum console_timestamp _mode, uint64_t _value)
+{
+	unsigned int fraction = (_mode == CONSOLE_TIMESTAMP_MS) ? 3 : 6;
+	unsigned int seconds = M_LIB_CONSOLE_TIMESTAMP__SECONDS;
+	unsigned int idx;
+	uint64_t limit = 1, value;
+	size_t pos;
+
+	for (idx = 0; idx < fraction + seconds; idx++) {
+		limit *= 10;
+	}
+	/* the field only grows after days of uptime */
+	while ((_value >= limit) && (limit <= UINT64_MAX / 10)) {
+		limit *= 10;
+		seconds++;
+	}
+
+	_cache->mode = _mode;
+	_cache->value = _value;
+	_cache->limit = (_value >= limit) ? UINT64_MAX : limit;
+	_cache->dot = 1 + seconds;
+	_cache->last = _cache->dot + fraction;
+	_cache->len = _cache->last + 3;
+
+	memset(&_cache->text[0], ' ', _cache->len);
+	_cache->text[0] = '[';
+	_cache->text[_cache->dot] = '.';
+	_cache->text[_cache->last + 1] = ']';
+
+	/* fraction with leading zeros, seconds with leading spaces */
+	value = _value;
+	pos = _cache->last;
+	for (idx = 0; idx < fraction; idx++) {
+		_cache->text[pos--] = (char)('0' + value % 10);
+		value /= 10;
+	}
+	pos--;
+	do {
+		_cache->text[pos--] = (char)('0' + value % 10);
+		value /= 10;
+	} while (value != 0);
+}
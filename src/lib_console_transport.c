@@ -0,0 +1,304 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+
+/* c-runtime */
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+#include <lib_convention__mem.h>
+#include <lib_thread.h>
+#include <lib_serial.h>
+
+/* project */
+#include "lib_console_transport.h"
+
+/* ****************************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ****************************************************************************/
+struct console_loopback_handle {
+	mutex_hdl_t mtx;
+	cond_hdl_t cond;
+	uint8_t *buffer;
+	size_t size;
+	size_t head;
+	size_t tail;
+	console_loopback_tap_t tap;
+	void *tapArg;
+	atomic_uint_least64_t txBytes;
+	atomic_uint_least64_t txWrites;
+};
+
+/* ****************************************************************************
+ * static function declarations
+ * ***************************************************************************/
+static int lib_console_transport__serial_open(void *_ctx, enum baudrate _baudrate, enum data_format _format);
+static int lib_console_transport__serial_close(void *_ctx);
+static int lib_console_transport__serial_write(void *_ctx, const uint8_t *_data, unsigned int _length);
+static int lib_console_transport__serial_read(void *_ctx, uint8_t *_data, unsigned int _length, int _timeout);
+static int lib_console_transport__loopback_open(void *_ctx, enum baudrate _baudrate, enum data_format _format);
+static int lib_console_transport__loopback_close(void *_ctx);
+static int lib_console_transport__loopback_write(void *_ctx, const uint8_t *_data, unsigned int _length);
+static int lib_console_transport__loopback_read(void *_ctx, uint8_t *_data, unsigned int _length, int _timeout);
+
+/* *******************************************************************
+ * (static) variables declarations
+ * ******************************************************************/
+const struct lib_console_transport lib_console_transport__serial = {
+	.open	= &lib_console_transport__serial_open,
+	.close	= &lib_console_transport__serial_close,
+	.write	= &lib_console_transport__serial_write,
+	.read	= &lib_console_transport__serial_read
+};
+
+const struct lib_console_transport lib_console_transport__loopback = {
+	.open	= &lib_console_transport__loopback_open,
+	.close	= &lib_console_transport__loopback_close,
+	.write	= &lib_console_transport__loopback_write,
+	.read	= &lib_console_transport__loopback_read
+};
+
+/* ****************************************************************************
+ * Global Functions
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Creation of an in-memory transport. Written data is handed to the
+ * 			tap without a copy, received data is injected by the peer.
+ * \param	_size [IN]	:	size of the receive buffer in bytes
+ * \return	console_loopback_hdl_t if successfully, NULL if not successful
+ * ****************************************************************************/
+console_loopback_hdl_t lib_console_loopback__create(size_t _size)
+{
+	console_loopback_hdl_t hdl;
+
+	if (_size == 0) {
+		return NULL;
+	}
+
+	hdl = (console_loopback_hdl_t)alloc_memory(1, sizeof(struct console_loopback_handle));
+	if (hdl == NULL) {
+		return NULL;
+	}
+
+	hdl->buffer = (uint8_t*)alloc_memory(1, _size);
+	if (hdl->buffer == NULL) {
+		goto ERR_BUFFER;
+	}
+
+	if (lib_thread__mutex_init(&hdl->mtx) < EOK) {
+		goto ERR_MTX;
+	}
+
+	if (lib_thread__cond_init(&hdl->cond) < EOK) {
+		goto ERR_COND;
+	}
+
+	hdl->size = _size;
+	atomic_init(&hdl->txBytes, 0);
+	atomic_init(&hdl->txWrites, 0);
+	return hdl;
+
+	ERR_COND:
+	lib_thread__mutex_destroy(&hdl->mtx);
+
+	ERR_MTX:
+	free_memory(hdl->buffer);
+
+	ERR_BUFFER:
+	free_memory(hdl);
+	return NULL;
+}
+
+/* ************************************************************************//**
+ * \brief	Destroys the in-memory transport, it is the counter-part of
+ * 			"lib_console_loopback__create"
+ * \param	_hdl [IN|OUT]	:	loopback handle
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_loopback__destroy(console_loopback_hdl_t *_hdl)
+{
+	if ((_hdl == NULL) || (*_hdl == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	lib_thread__cond_destroy(&(*_hdl)->cond);
+	lib_thread__mutex_destroy(&(*_hdl)->mtx);
+	free_memory((*_hdl)->buffer);
+	free_memory(*_hdl);
+	*_hdl = NULL;
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Installs the consumer of the written data, NULL discards it
+ * \param	_hdl [IN]	:	loopback handle
+ * \param	_tap [IN]	:	callback receiving the written data
+ * \param	_arg [IN]	:	argument passed to the callback
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_loopback__set_tap(console_loopback_hdl_t _hdl, console_loopback_tap_t _tap, void *_arg)
+{
+	if (_hdl == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	_hdl->tapArg = _arg;
+	_hdl->tap = _tap;
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Provides data to be read by the console
+ * \param	_hdl [IN]	:	loopback handle
+ * \param	_data [IN]	:	data to inject
+ * \param	_length [IN]:	number of bytes
+ * \return	number of injected bytes, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_loopback__inject(console_loopback_hdl_t _hdl, const uint8_t *_data, size_t _length)
+{
+	size_t idx, part, len;
+
+	if ((_hdl == NULL) || (_data == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	lib_thread__mutex_lock(_hdl->mtx);
+	len = _hdl->size - (_hdl->head - _hdl->tail);
+	if (len > _length) {
+		len = _length;
+	}
+
+	idx = _hdl->head % _hdl->size;
+	part = (len < _hdl->size - idx) ? len : _hdl->size - idx;
+	memcpy(&_hdl->buffer[idx], _data, part);
+	memcpy(&_hdl->buffer[0], &_data[part], len - part);
+	_hdl->head += len;
+
+	lib_thread__cond_broadcast(_hdl->cond);
+	lib_thread__mutex_unlock(_hdl->mtx);
+	return (int)len;
+}
+
+/* ************************************************************************//**
+ * \brief	Returns the number of bytes and write calls seen by the transport
+ * \param	_hdl [IN]		:	loopback handle
+ * \param	_bytes [OUT]	:	written bytes, may be NULL
+ * \param	_writes [OUT]	:	write calls, may be NULL
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_loopback__counters(console_loopback_hdl_t _hdl, uint64_t *_bytes, uint64_t *_writes)
+{
+	if (_hdl == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	if (_bytes != NULL) {
+		*_bytes = atomic_load_explicit(&_hdl->txBytes, memory_order_relaxed);
+	}
+	if (_writes != NULL) {
+		*_writes = atomic_load_explicit(&_hdl->txWrites, memory_order_relaxed);
+	}
+	return EOK;
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+static int lib_console_transport__serial_open(void *_ctx, enum baudrate _baudrate, enum data_format _format)
+{
+	return lib_serial_open((lib_serial_hdl)_ctx, _baudrate, _format);
+}
+
+static int lib_console_transport__serial_close(void *_ctx)
+{
+	return lib_serial_close((lib_serial_hdl)_ctx);
+}
+
+static int lib_console_transport__serial_write(void *_ctx, const uint8_t *_data, unsigned int _length)
+{
+	return lib_serial_write((lib_serial_hdl)_ctx, (uint8_t*)_data, _length);
+}
+
+static int lib_console_transport__serial_read(void *_ctx, uint8_t *_data, unsigned int _length, int _timeout)
+{
+	return lib_serial_read((lib_serial_hdl)_ctx, _data, _length, _timeout);
+}
+
+static int lib_console_transport__loopback_open(void *_ctx, enum baudrate _baudrate, enum data_format _format)
+{
+	(void)_baudrate;
+	(void)_format;
+	return (_ctx == NULL) ? -ESTD_INVAL : EOK;
+}
+
+static int lib_console_transport__loopback_close(void *_ctx)
+{
+	return (_ctx == NULL) ? -ESTD_INVAL : EOK;
+}
+
+static int lib_console_transport__loopback_write(void *_ctx, const uint8_t *_data, unsigned int _length)
+{
+	console_loopback_hdl_t hdl = (console_loopback_hdl_t)_ctx;
+	console_loopback_tap_t tap = hdl->tap;
+
+	atomic_fetch_add_explicit(&hdl->txBytes, _length, memory_order_relaxed);
+	atomic_fetch_add_explicit(&hdl->txWrites, 1, memory_order_relaxed);
+	if (tap != NULL) {
+		tap(hdl->tapArg, _data, _length);
+	}
+	return (int)_length;
+}
+
+static int lib_console_transport__loopback_read(void *_ctx, uint8_t *_data, unsigned int _length, int _timeout)
+{
+	console_loopback_hdl_t hdl = (console_loopback_hdl_t)_ctx;
+	size_t idx, part, len;
+
+	lib_thread__mutex_lock(hdl->mtx);
+	if (hdl->head == hdl->tail) {
+		lib_thread__cond_timedwait(hdl->cond, hdl->mtx, _timeout);
+	}
+
+	len = hdl->head - hdl->tail;
+	if (len > _length) {
+		len = _length;
+	}
+
+	idx = hdl->tail % hdl->size;
+	part = (len < hdl->size - idx) ? len : hdl->size - idx;
+	memcpy(_data, &hdl->buffer[idx], part);
+	memcpy(&_data[part], &hdl->buffer[0], len - part);
+	hdl->tail += len;
+	lib_thread__mutex_unlock(hdl->mtx);
+	return (int)len;
+}
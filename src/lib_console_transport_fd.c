@@ -0,0 +1,260 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+
+/* ptsname_r */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/* c-runtime */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/* system */
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+#include <lib_convention__mem.h>
+
+/* project */
+#include "lib_console_transport.h"
+
+/* ****************************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ****************************************************************************/
+struct console_fd_handle {
+	int rdFd;
+	int wrFd;
+	bool owned;
+	/* terminal settings before the open, restored by the close */
+	struct termios savedTio;
+	bool restoreTio;
+};
+
+/* ****************************************************************************
+ * static function declarations
+ * ***************************************************************************/
+static int lib_console_transport__fd_open(void *_ctx, enum baudrate _baudrate, enum data_format _format);
+static int lib_console_transport__fd_close(void *_ctx);
+static int lib_console_transport__fd_write(void *_ctx, const uint8_t *_data, unsigned int _length);
+static int lib_console_transport__fd_read(void *_ctx, uint8_t *_data, unsigned int _length, int _timeout);
+static int lib_console_transport__fd_fileno(void *_ctx);
+
+/* *******************************************************************
+ * (static) variables declarations
+ * ******************************************************************/
+const struct lib_console_transport lib_console_transport__fd = {
+	.open	= &lib_console_transport__fd_open,
+	.close	= &lib_console_transport__fd_close,
+	.write	= &lib_console_transport__fd_write,
+	.read	= &lib_console_transport__fd_read,
+	.fileno	= &lib_console_transport__fd_fileno
+};
+
+/* ****************************************************************************
+ * Global Functions
+ * ****************************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Creation of a file descriptor transport
+ * \param	_rdFd [IN]	:	descriptor to read from
+ * \param	_wrFd [IN]	:	descriptor to write to, may equal _rdFd
+ * \return	console_fd_hdl_t if successfully, NULL if not successful
+ * ****************************************************************************/
+console_fd_hdl_t lib_console_fd__create(int _rdFd, int _wrFd)
+{
+	console_fd_hdl_t hdl;
+
+	if ((_rdFd < 0) || (_wrFd < 0)) {
+		return NULL;
+	}
+
+	hdl = (console_fd_hdl_t)alloc_memory(1, sizeof(struct console_fd_handle));
+	if (hdl == NULL) {
+		return NULL;
+	}
+
+	hdl->rdFd = _rdFd;
+	hdl->wrFd = _wrFd;
+	hdl->owned = false;
+	return hdl;
+}
+
+/* ************************************************************************//**
+ * \brief	Creation of a pseudo terminal transport, the console operates
+ * 			the master side
+ * \param	_slaveName [OUT]	:	path of the slave device to attach to
+ * \param	_size [IN]			:	size of _slaveName
+ * \return	console_fd_hdl_t if successfully, NULL if not successful
+ * ****************************************************************************/
+console_fd_hdl_t lib_console_fd__openpty(char *_slaveName, size_t _size)
+{
+	console_fd_hdl_t hdl;
+	int fd;
+
+	fd = posix_openpt(O_RDWR | O_NOCTTY);
+	if (fd < 0) {
+		return NULL;
+	}
+
+	if ((grantpt(fd) < 0) || (unlockpt(fd) < 0)) {
+		goto ERR_PTY;
+	}
+
+	if ((_slaveName != NULL) && (ptsname_r(fd, _slaveName, _size) != 0)) {
+		goto ERR_PTY;
+	}
+
+	hdl = lib_console_fd__create(fd, fd);
+	if (hdl == NULL) {
+		goto ERR_PTY;
+	}
+	hdl->owned = true;
+	return hdl;
+
+	ERR_PTY:
+	close(fd);
+	return NULL;
+}
+
+/* ************************************************************************//**
+ * \brief	Destroys the file descriptor transport, descriptors opened by
+ * 			"lib_console_fd__openpty" are closed
+ * \param	_hdl [IN|OUT]	:	file descriptor handle
+ * \return	EOK, if successful, ret< EOK if not successful
+ * ****************************************************************************/
+int lib_console_fd__destroy(console_fd_hdl_t *_hdl)
+{
+	if ((_hdl == NULL) || (*_hdl == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	if ((*_hdl)->owned) {
+		close((*_hdl)->rdFd);
+	}
+
+	free_memory(*_hdl);
+	*_hdl = NULL;
+	return EOK;
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+static int lib_console_transport__fd_open(void *_ctx, enum baudrate _baudrate, enum data_format _format)
+{
+	console_fd_hdl_t hdl = (console_fd_hdl_t)_ctx;
+	struct termios tio;
+
+	(void)_baudrate;
+	(void)_format;
+
+	if (hdl == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	/* terminals are switched to raw mode, the console does echo and editing */
+	if (isatty(hdl->rdFd) && (tcgetattr(hdl->rdFd, &hdl->savedTio) == 0)) {
+		tio = hdl->savedTio;
+		cfmakeraw(&tio);
+		hdl->restoreTio = (tcsetattr(hdl->rdFd, TCSANOW, &tio) == 0);
+	}
+	return EOK;
+}
+
+static int lib_console_transport__fd_close(void *_ctx)
+{
+	console_fd_hdl_t hdl = (console_fd_hdl_t)_ctx;
+
+	if (hdl == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	/* the terminal is handed back in the mode it was opened in */
+	if (hdl->restoreTio) {
+		tcsetattr(hdl->rdFd, TCSADRAIN, &hdl->savedTio);
+		hdl->restoreTio = false;
+	}
+	return EOK;
+}
+
+static int lib_console_transport__fd_write(void *_ctx, const uint8_t *_data, unsigned int _length)
+{
+	console_fd_hdl_t hdl = (console_fd_hdl_t)_ctx;
+	unsigned int done = 0;
+	ssize_t ret;
+
+	while (done < _length) {
+		ret = write(hdl->wrFd, &_data[done], _length - done);
+		if (ret < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			/* a non-blocking descriptor is full, the caller may retry */
+			return ((errno == EAGAIN) || (errno == EWOULDBLOCK)) ? -ESTD_AGAIN : -ESTD_IO;
+		}
+		done += (unsigned int)ret;
+	}
+	return (int)done;
+}
+
+static int lib_console_transport__fd_read(void *_ctx, uint8_t *_data, unsigned int _length, int _timeout)
+{
+	console_fd_hdl_t hdl = (console_fd_hdl_t)_ctx;
+	struct pollfd pfd = { .fd = hdl->rdFd, .events = POLLIN, .revents = 0 };
+	ssize_t ret;
+
+	ret = poll(&pfd, 1, _timeout);
+	if (ret <= 0) {
+		return ((ret == 0) || (errno == EINTR)) ? 0 : -ESTD_IO;
+	}
+
+	ret = read(hdl->rdFd, _data, _length);
+	if (ret < 0) {
+		return ((errno == EAGAIN) || (errno == EINTR)) ? 0 : -ESTD_IO;
+	}
+	else if (ret == 0) {
+		/* peer closed its end */
+		return -ESTD_IO;
+	}
+	return (int)ret;
+}
+
+static int lib_console_transport__fd_fileno(void *_ctx)
+{
+	return (_ctx == NULL) ? -ESTD_INVAL : ((console_fd_hdl_t)_ctx)->rdFd;
+}
@@ -0,0 +1,1540 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/* ****************************************************************************
+ * includes
+ * ****************************************************************************/
+
+/* c-runtime */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+
+/* system */
+#include <unistd.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+#include <lib_thread.h>
+
+/* project */
+#include <lib_console.h>
+#include <lib_console_command.h>
+#include <lib_console_factory.h>
+#include <lib_console_mirror.h>
+#include <lib_console_reactor.h>
+#include <lib_console_transport.h>
+#include <lib_console_ring.h>
+#include <lib_console_newline.h>
+#include <lib_console_format.h>
+#include <lib_console_editor.h>
+#include <lib_console_stats.h>
+#include <lib_console_timestamp.h>
+
+/* ****************************************************************************
+ * defines
+ * ****************************************************************************/
+#define M_TEST__CAPTURE_SIZE	8192
+#define M_TEST__MIRROR_SIZE		256
+#define M_TEST__REGISTRY_ROUNDS	2000
+#define M_TEST__REGISTRY_READERS	2
+#define M_TEST__LONG_LINE		300
+#define M_TEST__ASYNC_SHORT		20
+#define M_TEST__FORMAT_CHUNK	8
+#define M_TEST__STREAM_LINE		150
+/* beyond the default transmit ring */
+#define M_TEST__WRITEV_LARGE	6000
+#define M_TEST__OVERFLOW_RING	256
+#define M_TEST__OVERFLOW_PRINTS	100
+#define M_TEST__TIMESTAMP_STEPS	10000
+#define M_TEST__SCAN_LINE		64
+#define M_TEST__REACTOR_CONSOLES	3
+#define M_TEST__REACTOR_LINES	50
+#define M_TEST__ARENA_SIZE		32768
+#define M_TEST__COALESCE_SIZE	64
+#define M_TEST__COALESCE_DELAY	50
+
+/* a failed check is reported and the test continues */
+#define M_TEST__CHECK(_cond)																\
+	do {																					\
+		if (!(_cond)) {																		\
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #_cond);		\
+			s_failures++;																	\
+		}																					\
+	} while (0)
+
+/* ****************************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ****************************************************************************/
+
+/* console on the loopback transport, its output is collected */
+struct test_console {
+	console_loopback_hdl_t loopback;
+	console_hdl_t console;
+	uint8_t data[M_TEST__CAPTURE_SIZE];
+	size_t len;
+};
+
+/* arguments seen by the last command call */
+struct test_command_call {
+	int argc;
+	char argv[M_LIB_CONSOLE_COMMAND__MAX_ARGS][32];
+	bool terminated;
+};
+
+/* output of the chunked formatter */
+struct test_format_output {
+	char data[256];
+	size_t len;
+};
+
+/* lines delivered by the reactor per console */
+struct test_reactor {
+	console_hdl_t consoles[M_TEST__REACTOR_CONSOLES];
+	unsigned int lines[M_TEST__REACTOR_CONSOLES];
+	bool ordered;
+};
+
+/* readers of the registry racing with create and destroy */
+struct test_registry_reader {
+	atomic_bool *stop;
+	atomic_ulong found;
+	thread_hdl_t thd;
+};
+
+/* ****************************************************************************
+ * static function declarations
+ * ***************************************************************************/
+static int test__console_open(struct test_console *_target);
+static void test__console_close(struct test_console *_target);
+static void test__tap(void *_arg, const uint8_t *_data, unsigned int _length);
+static int test__command(console_hdl_t _hdl, int _argc, char *_argv[], void *_arg);
+static uint64_t test__varint(const uint8_t **_pos);
+static void test__ring_wraparound(void);
+static void test__ring_drop_oldest(void);
+static void test__newline(void);
+static void test__deferred(const char *_capturePath);
+static void test__command_lookup(void);
+static void test__mirror_wrap(void);
+static void test__rx_engine(void);
+static void* test__registry_reader(void *_arg);
+static void test__registry(void);
+static void test__async_order(void);
+static int test__format_flush(void *_arg, const char *_data, size_t _len);
+static bool test__format(const char *_expected, const char *_format, ...);
+static void test__format_conversions(void);
+static void test__stream_print(void);
+static void test__echo_discard(void *_arg, const char *_data, size_t _len);
+static size_t test__edit(struct console_editor *_editor, const char *_keys, char _delimiter);
+static void test__editor(void);
+static void test__writev(bool _async);
+static void test__broadcast(void);
+static console_hdl_t test__counted(console_hdl_t _hdl, unsigned int *_calls);
+static void test__levels(void);
+static void test__tap_held(void *_arg, const uint8_t *_data, unsigned int _length);
+static void test__overflow(void);
+static void test__stats(void);
+static bool test__timestamp_render(struct console_timestamp_cache *_cache, enum console_timestamp _mode, uint64_t _ns);
+static void test__timestamps(void);
+static void test__typed(void);
+static void test__print_buffer(bool _async);
+static void test__rx_raw(void);
+static void test__reactor_line(void *_arg, console_hdl_t _hdl, const char *_line, size_t _len);
+static void test__reactor(void);
+static void test__arena(void);
+static void test__tap_panic(void *_arg, const uint8_t *_data, unsigned int _length);
+static void* test__panic_writer(void *_arg);
+static void test__panic(void);
+static void test__coalesce(void);
+
+/* *******************************************************************
+ * (static) variables declarations
+ * ******************************************************************/
+static unsigned int s_failures;
+
+/* holds the transport of test__tap_held, the writer thread waits in it */
+static atomic_bool s_tapHold;
+/* set by test__tap_panic once the normal print waits in the transport */
+static atomic_bool s_tapEntered;
+
+/* start of the format string table, provided by the linker */
+extern const char __start_lib_console_fmt[] __attribute__((weak));
+
+/* ****************************************************************************
+ * Global Functions
+ * ****************************************************************************/
+int main(int _argc, char *_argv[])
+{
+	test__ring_wraparound();
+	test__ring_drop_oldest();
+	test__newline();
+	test__deferred((_argc > 1) ? _argv[1] : NULL);
+	test__command_lookup();
+	test__mirror_wrap();
+	test__registry();
+	test__rx_engine();
+	test__async_order();
+	test__format_conversions();
+	test__stream_print();
+	test__editor();
+	test__writev(false);
+	test__writev(true);
+	test__broadcast();
+	test__levels();
+	test__overflow();
+	test__stats();
+	test__timestamps();
+	test__typed();
+	test__print_buffer(false);
+	test__print_buffer(true);
+	test__rx_raw();
+	test__reactor();
+	test__arena();
+	test__panic();
+	test__coalesce();
+
+	if (s_failures > 0) {
+		fprintf(stderr, "%u checks failed\n", s_failures);
+		return EXIT_FAILURE;
+	}
+	printf("all checks passed\n");
+	return EXIT_SUCCESS;
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+static int test__console_open(struct test_console *_target)
+{
+	_target->len = 0;
+	_target->loopback = lib_console_loopback__create(64);
+	if (_target->loopback == NULL) {
+		return -ESTD_NOMEM;
+	}
+	lib_console_loopback__set_tap(_target->loopback, &test__tap, _target);
+
+	_target->console = lib_console_factory__getTransportInstance(&lib_console_transport__loopback, _target->loopback);
+	if (_target->console == NULL) {
+		lib_console_loopback__destroy(&_target->loopback);
+		return -ESTD_NOMEM;
+	}
+	return lib_console__open(_target->console, BAUD_115200, DATA_8N1);
+}
+
+static void test__console_close(struct test_console *_target)
+{
+	lib_console_factory__destroy(&_target->console);
+	lib_console_loopback__destroy(&_target->loopback);
+}
+
+static void test__tap(void *_arg, const uint8_t *_data, unsigned int _length)
+{
+	struct test_console *target = (struct test_console*)_arg;
+
+	if (target->len + _length <= sizeof(target->data)) {
+		memcpy(&target->data[target->len], _data, _length);
+	}
+	target->len += _length;
+}
+
+static int test__command(console_hdl_t _hdl, int _argc, char *_argv[], void *_arg)
+{
+	struct test_command_call *call = (struct test_command_call*)_arg;
+	int i;
+
+	(void)_hdl;
+	call->argc = _argc;
+	for (i = 0; i < _argc; i++) {
+		snprintf(&call->argv[i][0], sizeof(call->argv[i]), "%s", _argv[i]);
+	}
+	call->terminated = (_argv[_argc] == NULL);
+	return _argc;
+}
+
+static uint64_t test__varint(const uint8_t **_pos)
+{
+	uint64_t value = 0;
+	unsigned int shift = 0;
+	uint8_t byte;
+
+	do {
+		byte = *(*_pos)++;
+		value |= (uint64_t)(byte & 0x7F) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+	return value;
+}
+
+static void test__ring_wraparound(void)
+{
+	struct console_ring ring;
+	uint8_t record[64], out[M_LIB_CONSOLE_RING__MIN_SIZE];
+	size_t len, idx;
+	unsigned int i;
+
+	M_TEST__CHECK(lib_console_ring__init(&ring, M_LIB_CONSOLE_RING__MIN_SIZE) == EOK);
+	M_TEST__CHECK(lib_console_ring__empty(&ring));
+	M_TEST__CHECK(lib_console_ring__pop(&ring, &out[0], sizeof(out)) == 0);
+
+	/* odd record sizes move the records across the end of the storage */
+	for (i = 0; i < 1000; i++) {
+		len = (i % 37) + 1;
+		for (idx = 0; idx < len; idx++) {
+			record[idx] = (uint8_t)(i + idx);
+		}
+		M_TEST__CHECK(lib_console_ring__push(&ring, &record[0], len) == EOK);
+		M_TEST__CHECK(!lib_console_ring__empty(&ring));
+		M_TEST__CHECK(lib_console_ring__pop(&ring, &out[0], sizeof(out)) == len);
+		M_TEST__CHECK(memcmp(&out[0], &record[0], len) == 0);
+		M_TEST__CHECK(lib_console_ring__empty(&ring));
+	}
+	M_TEST__CHECK(atomic_load(&ring.tail) > 10 * ring.size);
+
+	M_TEST__CHECK(lib_console_ring__push(&ring, &out[0], lib_console_ring__max_payload(&ring) + 1) == -ESTD_MSGSIZE);
+	lib_console_ring__cleanup(&ring);
+}
+
+static void test__ring_drop_oldest(void)
+{
+	struct console_ring ring;
+	uint8_t record[20], out[M_LIB_CONSOLE_RING__MIN_SIZE];
+	size_t len, pushed, popped, idx;
+	int ret;
+
+	M_TEST__CHECK(lib_console_ring__init(&ring, M_LIB_CONSOLE_RING__MIN_SIZE) == EOK);
+	M_TEST__CHECK(lib_console_ring__drop(&ring, &len) == -ESTD_AGAIN);
+
+	/* fill the ring, record n carries the byte n */
+	for (pushed = 0; ; pushed++) {
+		memset(&record[0], (int)pushed, sizeof(record));
+		ret = lib_console_ring__push(&ring, &record[0], sizeof(record));
+		if (ret < EOK) {
+			break;
+		}
+	}
+	M_TEST__CHECK(ret == -ESTD_AGAIN);
+	M_TEST__CHECK(pushed > 1);
+
+	/* discarding the oldest record makes room for the newest one */
+	M_TEST__CHECK(lib_console_ring__drop(&ring, &len) == EOK);
+	M_TEST__CHECK(len == sizeof(record));
+	memset(&record[0], (int)pushed, sizeof(record));
+	M_TEST__CHECK(lib_console_ring__push(&ring, &record[0], sizeof(record)) == EOK);
+
+	popped = lib_console_ring__pop(&ring, &out[0], sizeof(out));
+	M_TEST__CHECK(popped == pushed * sizeof(record));
+	for (idx = 0; (idx < pushed) && (idx * sizeof(record) < popped); idx++) {
+		M_TEST__CHECK(out[idx * sizeof(record)] == (uint8_t)(idx + 1));
+	}
+	M_TEST__CHECK(lib_console_ring__empty(&ring));
+	lib_console_ring__cleanup(&ring);
+}
+
+static void test__newline(void)
+{
+	const char text[] = "ab\ncd\n\nef";
+	char out[32];
+	size_t len, used;
+
+	M_TEST__CHECK(lib_console_newline__find(&text[0], sizeof(text) - 1) == 2);
+	M_TEST__CHECK(lib_console_newline__find("abc", 3) == 3);
+	M_TEST__CHECK(lib_console_newline__count(&text[0], sizeof(text) - 1) == 3);
+	M_TEST__CHECK(lib_console_newline__count("", 0) == 0);
+
+	len = lib_console_newline__translate(&out[0], sizeof(out), &text[0], sizeof(text) - 1, &used);
+	M_TEST__CHECK(used == sizeof(text) - 1);
+	M_TEST__CHECK((len == 12) && (memcmp(&out[0], "ab\n\rcd\n\r\n\ref", 12) == 0));
+
+	/* a new line is never split from its carriage return */
+	len = lib_console_newline__translate(&out[0], 3, &text[0], sizeof(text) - 1, &used);
+	M_TEST__CHECK((len == 2) && (used == 2));
+	len = lib_console_newline__translate(&out[0], 4, &text[0], sizeof(text) - 1, &used);
+	M_TEST__CHECK((len == 4) && (used == 3) && (memcmp(&out[0], "ab\n\r", 4) == 0));
+}
+
+static void test__deferred(const char *_capturePath)
+{
+	struct test_console target;
+	const uint8_t *pos, *end;
+	uint64_t zigzag, offset, len;
+	FILE *file;
+
+	if (test__console_open(&target) < EOK) {
+		M_TEST__CHECK(false);
+		return;
+	}
+
+	M_LIB_CONSOLE__LOG(target.console, CONSOLE_LEVEL_ERROR, "deferred %d %x %u %s\n", -42, 42u, 7u, "str");
+	lib_console__flush(target.console);
+
+	/* magic, body length, sequence, format offset and the raw arguments */
+	M_TEST__CHECK((target.len > 3) && (target.len < 0x80));
+	if ((target.len <= 3) || (target.len >= 0x80)) {
+		test__console_close(&target);
+		return;
+	}
+	M_TEST__CHECK(target.data[0] == M_LIB_CONSOLE__DEFERRED_MAGIC);
+	M_TEST__CHECK(target.data[1] == target.len - 2);
+	pos = &target.data[2];
+	end = &target.data[target.len];
+	M_TEST__CHECK(test__varint(&pos) == 0);
+	offset = test__varint(&pos);
+	M_TEST__CHECK(strcmp(&__start_lib_console_fmt[offset], "deferred %d %x %u %s\n") == 0);
+	zigzag = test__varint(&pos);
+	M_TEST__CHECK((int64_t)((zigzag >> 1) ^ (0 - (zigzag & 1))) == -42);
+	M_TEST__CHECK(test__varint(&pos) == 42);
+	M_TEST__CHECK(test__varint(&pos) == 7);
+	len = test__varint(&pos);
+	M_TEST__CHECK((len == 3) && (memcmp(pos, "str", 3) == 0));
+	M_TEST__CHECK(pos + len == end);
+
+	/* tools/lib_console_decode.py rebuilds the text from the capture */
+	if (_capturePath != NULL) {
+		file = fopen(_capturePath, "wb");
+		M_TEST__CHECK(file != NULL);
+		if (file != NULL) {
+			M_TEST__CHECK(fwrite(&target.data[0], 1, target.len, file) == target.len);
+			fclose(file);
+		}
+	}
+	test__console_close(&target);
+}
+
+static void test__command_lookup(void)
+{
+	struct test_command_call call;
+	struct console_command commands[] = {
+		{ "help", &test__command, &call, "lists the commands" },
+		{ "reset", &test__command, &call, "restarts the device" },
+		{ "set", &test__command, &call, "sets a value" }
+	};
+	const char line[] = "  set key \"a b\"\r\n";
+	char buffer[sizeof(line)];
+	console_command_table_hdl_t table;
+	size_t i;
+
+	table = lib_console_command__create(&commands[0], sizeof(commands) / sizeof(commands[0]));
+	M_TEST__CHECK(table != NULL);
+	if (table == NULL) {
+		return;
+	}
+
+	for (i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+		M_TEST__CHECK(lib_console_command__find(table, commands[i].name, strlen(commands[i].name)) == &commands[i]);
+	}
+	M_TEST__CHECK(lib_console_command__find(table, "res", 3) == NULL);
+	M_TEST__CHECK(lib_console_command__find(table, "resets", 6) == NULL);
+	M_TEST__CHECK(lib_console_command__find(table, "reset now", 5) == &commands[1]);
+	M_TEST__CHECK(lib_console_command__register(table, &commands[0]) == -ESTD_EXIST);
+
+	/* the line is split in the buffer, it stays untouched */
+	memset(&call, 0, sizeof(call));
+	M_TEST__CHECK(lib_console_command__dispatch(table, NULL, &line[0], sizeof(line) - 1, &buffer[0], sizeof(buffer)) == 3);
+	M_TEST__CHECK(call.argc == 3);
+	M_TEST__CHECK(strcmp(&call.argv[0][0], "set") == 0);
+	M_TEST__CHECK(strcmp(&call.argv[1][0], "key") == 0);
+	M_TEST__CHECK(strcmp(&call.argv[2][0], "a b") == 0);
+	M_TEST__CHECK(call.terminated);
+	M_TEST__CHECK(strcmp(&line[0], "  set key \"a b\"\r\n") == 0);
+
+	M_TEST__CHECK(lib_console_command__dispatch(table, NULL, "nope\n", 5, &buffer[0], sizeof(buffer)) == -ESTD_NOENT);
+	M_TEST__CHECK(lib_console_command__dispatch(table, NULL, " \r\n", 3, &buffer[0], sizeof(buffer)) == 0);
+	M_TEST__CHECK(lib_console_command__dispatch(table, NULL, "help", 4, &buffer[0], 4) == -ESTD_NOSPC);
+
+	M_TEST__CHECK(lib_console_command__destroy(&table) == EOK);
+	M_TEST__CHECK(table == NULL);
+}
+
+static void test__mirror_wrap(void)
+{
+	char path[] = "/tmp/lib_console_test_XXXXXX";
+	uint8_t file[64 + M_TEST__MIRROR_SIZE];
+	struct test_console target;
+	console_mirror_hdl_t mirror;
+	uint64_t size, head, tail, sequence;
+	uint32_t headerSize;
+	size_t idx;
+	FILE *stream;
+	int fd;
+
+	fd = mkstemp(&path[0]);
+	M_TEST__CHECK(fd >= 0);
+	if (fd < 0) {
+		return;
+	}
+	close(fd);
+
+	mirror = lib_console_mirror__open(&path[0], M_TEST__MIRROR_SIZE);
+	M_TEST__CHECK(mirror != NULL);
+	if ((mirror == NULL) || (test__console_open(&target) < EOK)) {
+		M_TEST__CHECK(false);
+		unlink(&path[0]);
+		return;
+	}
+
+	/* four times the ring, each line is "line nnn\n\r" */
+	M_TEST__CHECK(lib_console__set_mirror(target.console, mirror) == EOK);
+	for (idx = 0; idx < 4 * M_TEST__MIRROR_SIZE / 10; idx++) {
+		lib_console__print_debug_message(target.console, "line %03u\n", (unsigned int)idx);
+	}
+	lib_console__flush(target.console);
+	M_TEST__CHECK(lib_console__set_mirror(target.console, NULL) == EOK);
+	M_TEST__CHECK(lib_console_mirror__sync(mirror) == EOK);
+
+	stream = fopen(&path[0], "rb");
+	M_TEST__CHECK(stream != NULL);
+	if (stream != NULL) {
+		M_TEST__CHECK(fread(&file[0], 1, sizeof(file), stream) == sizeof(file));
+		fclose(stream);
+
+		M_TEST__CHECK(memcmp(&file[0], M_LIB_CONSOLE_MIRROR__MAGIC, 8) == 0);
+		memcpy(&headerSize, &file[12], sizeof(headerSize));
+		memcpy(&size, &file[16], sizeof(size));
+		memcpy(&head, &file[32], sizeof(head));
+		memcpy(&tail, &file[40], sizeof(tail));
+		M_TEST__CHECK(headerSize == 64);
+		M_TEST__CHECK(size == M_TEST__MIRROR_SIZE);
+		M_TEST__CHECK(head == target.len);
+		M_TEST__CHECK(tail == head - size);
+
+		/* the intact range holds the newest bytes written to the transport */
+		for (idx = 0; (idx < size) && (head == target.len); idx++) {
+			if (file[headerSize + ((tail + idx) % size)] != target.data[tail + idx]) {
+				M_TEST__CHECK(false);
+				break;
+			}
+		}
+	}
+	M_TEST__CHECK(lib_console_mirror__close(&mirror) == EOK);
+
+	/* a reopened file of the same size keeps its history */
+	mirror = lib_console_mirror__open(&path[0], M_TEST__MIRROR_SIZE);
+	M_TEST__CHECK(mirror != NULL);
+	M_TEST__CHECK(lib_console_mirror__close(&mirror) == EOK);
+	stream = fopen(&path[0], "rb");
+	if (stream != NULL) {
+		M_TEST__CHECK(fread(&file[0], 1, sizeof(file), stream) == sizeof(file));
+		fclose(stream);
+		memcpy(&sequence, &file[24], sizeof(sequence));
+		memcpy(&size, &file[32], sizeof(size));
+		M_TEST__CHECK(sequence == 2);
+		M_TEST__CHECK(size == target.len);
+	}
+
+	test__console_close(&target);
+	unlink(&path[0]);
+}
+
+static void* test__registry_reader(void *_arg)
+{
+	struct test_registry_reader *reader = (struct test_registry_reader*)_arg;
+	console_hdl_t consoleHdl;
+	unsigned int slot;
+
+	while (!atomic_load(reader->stop)) {
+		for (slot = 0; slot < lib_console_factory__slots(); slot++) {
+			consoleHdl = lib_console_factory__acquire(slot);
+			if (consoleHdl != NULL) {
+				atomic_fetch_add(&reader->found, (lib_console__get_level(consoleHdl) == CONSOLE_LEVEL_TRACE));
+				lib_console_factory__release(consoleHdl);
+			}
+		}
+	}
+	return NULL;
+}
+
+static void test__registry(void)
+{
+	struct test_registry_reader readers[M_TEST__REGISTRY_READERS];
+	struct test_console targets[3];
+	console_hdl_t consoleHdl;
+	atomic_bool stop;
+	unsigned int base, idx, round;
+
+	/* the consoles are counted in registration order, a destroyed one is skipped */
+	base = lib_console_factory__instances();
+	for (idx = 0; idx < 3; idx++) {
+		M_TEST__CHECK(test__console_open(&targets[idx]) == EOK);
+	}
+	M_TEST__CHECK(lib_console_factory__instances() == base + 3);
+	for (idx = 0; idx < 3; idx++) {
+		M_TEST__CHECK(lib_console_factory__instance(base + idx) == targets[idx].console);
+	}
+
+	test__console_close(&targets[1]);
+	M_TEST__CHECK(lib_console_factory__instances() == base + 2);
+	M_TEST__CHECK(lib_console_factory__instance(base + 1) == targets[2].console);
+	M_TEST__CHECK(lib_console_factory__instance(base + 2) == NULL);
+
+	/* a referenced console outlives the unregistration, the slot is free again */
+	consoleHdl = NULL;
+	for (idx = 0; (idx < lib_console_factory__slots()) && (consoleHdl != targets[2].console); idx++) {
+		consoleHdl = lib_console_factory__acquire(idx);
+		lib_console_factory__release(consoleHdl);
+	}
+	M_TEST__CHECK(consoleHdl == targets[2].console);
+
+	/* readers take and return references while consoles come and go */
+	atomic_store(&stop, false);
+	for (idx = 0; idx < M_TEST__REGISTRY_READERS; idx++) {
+		readers[idx].stop = &stop;
+		atomic_init(&readers[idx].found, 0);
+		M_TEST__CHECK(lib_thread__create(&readers[idx].thd, &test__registry_reader, &readers[idx], 0, "test_reader") == EOK);
+	}
+	/* the rounds start once every reader is running */
+	for (idx = 0; idx < M_TEST__REGISTRY_READERS; idx++) {
+		while (atomic_load(&readers[idx].found) == 0) {
+			lib_thread__msleep(1);
+		}
+	}
+	for (round = 0; round < M_TEST__REGISTRY_ROUNDS; round++) {
+		M_TEST__CHECK(test__console_open(&targets[1]) == EOK);
+		test__console_close(&targets[1]);
+	}
+	atomic_store(&stop, true);
+	for (idx = 0; idx < M_TEST__REGISTRY_READERS; idx++) {
+		lib_thread__join(&readers[idx].thd, NULL);
+	}
+
+	test__console_close(&targets[0]);
+	test__console_close(&targets[2]);
+	M_TEST__CHECK(lib_console_factory__instances() == base);
+}
+
+static void test__rx_engine(void)
+{
+	const char input[] = "hello\nworld\nabcdefghij\n";
+	struct test_console target;
+	char line[32];
+	size_t n;
+
+	if (test__console_open(&target) < EOK) {
+		M_TEST__CHECK(false);
+		return;
+	}
+	M_TEST__CHECK(lib_console__rx_start(target.console, 0) == EOK);
+	M_TEST__CHECK(lib_console_loopback__inject(target.loopback, (const uint8_t*)&input[0], sizeof(input) - 1) ==
+				  (int)(sizeof(input) - 1));
+
+	/* a call without room returns at once instead of waiting for a line */
+	n = 0;
+	M_TEST__CHECK(lib_console__getline(target.console, &line[0], &n) == EOK);
+	M_TEST__CHECK(n == 0);
+
+	n = sizeof(line);
+	M_TEST__CHECK(lib_console__getline(target.console, &line[0], &n) == EOK);
+	M_TEST__CHECK((n == 6) && (memcmp(&line[0], "hello\n", 6) == 0));
+	n = sizeof(line);
+	M_TEST__CHECK(lib_console__getline(target.console, &line[0], &n) == EOK);
+	M_TEST__CHECK((n == 6) && (memcmp(&line[0], "world\n", 6) == 0));
+
+	/* a line longer than the caller buffer is handed out in pieces */
+	n = 4;
+	M_TEST__CHECK(lib_console__getline(target.console, &line[0], &n) == EOK);
+	M_TEST__CHECK((n == 4) && (memcmp(&line[0], "abcd", 4) == 0));
+	n = sizeof(line);
+	M_TEST__CHECK(lib_console__getline(target.console, &line[0], &n) == EOK);
+	M_TEST__CHECK((n == 7) && (memcmp(&line[0], "efghij\n", 7) == 0));
+
+	M_TEST__CHECK(lib_console__rx_stop(target.console) == EOK);
+	test__console_close(&target);
+}
+
+static void test__async_order(void)
+{
+	struct test_console target;
+	char expected[M_TEST__CAPTURE_SIZE];
+	char line[M_TEST__LONG_LINE + 1];
+	size_t len = 0;
+	unsigned int i;
+
+	if (test__console_open(&target) < EOK) {
+		M_TEST__CHECK(false);
+		return;
+	}
+	M_TEST__CHECK(lib_console__async_start(target.console, 0) == EOK);
+	memset(&line[0], 'x', M_TEST__LONG_LINE);
+	line[M_TEST__LONG_LINE] = '\0';
+
+	/* the long message bypasses the writer thread, the queued ones go first */
+	for (i = 0; i < M_TEST__ASYNC_SHORT; i++) {
+		M_TEST__CHECK(lib_console__print_debug_message(target.console, "short %u\n", i) == EOK);
+		len += snprintf(&expected[len], sizeof(expected) - len, "short %u\n\r", i);
+	}
+	M_TEST__CHECK(lib_console__print_debug_message(target.console, "%s\n", &line[0]) >= EOK);
+	len += snprintf(&expected[len], sizeof(expected) - len, "%s\n\r", &line[0]);
+	M_TEST__CHECK(lib_console__print_debug_message(target.console, "end\n") == EOK);
+	len += snprintf(&expected[len], sizeof(expected) - len, "end\n\r");
+
+	M_TEST__CHECK(lib_console__flush(target.console) == EOK);
+	M_TEST__CHECK((target.len == len) && (memcmp(&target.data[0], &expected[0], len) == 0));
+
+	M_TEST__CHECK(lib_console__async_stop(target.console) == EOK);
+	test__console_close(&target);
+}
+
+static int test__format_flush(void *_arg, const char *_data, size_t _len)
+{
+	struct test_format_output *output = (struct test_format_output*)_arg;
+
+	if (output->len + _len <= sizeof(output->data)) {
+		memcpy(&output->data[output->len], _data, _len);
+	}
+	output->len += _len;
+	return EOK;
+}
+
+static bool test__format(const char *_expected, const char *_format, ...)
+{
+	struct test_format_output output;
+	struct console_format_stream stream;
+	char chunk[M_TEST__FORMAT_CHUNK];
+	va_list ap;
+	int ret;
+
+	/* a small chunk makes every conversion cross a flush */
+	output.len = 0;
+	stream.buffer = &chunk[0];
+	stream.size = sizeof(chunk);
+	stream.pos = 0;
+	stream.flush = &test__format_flush;
+	stream.arg = &output;
+	stream.total = 0;
+	stream.last = 0;
+
+	va_start(ap, _format);
+	ret = lib_console_format__vstream(&stream, _format, ap);
+	va_end(ap);
+
+	/* the last chunk stays in the buffer */
+	test__format_flush(&output, &chunk[0], stream.pos);
+	if ((ret < EOK) || (output.len != strlen(_expected)) || (memcmp(&output.data[0], _expected, output.len) != 0)) {
+		fprintf(stderr, "format \"%s\": \"%.*s\"\n", _format, (int)output.len, &output.data[0]);
+		return false;
+	}
+	return true;
+}
+
+static void test__format_conversions(void)
+{
+	M_TEST__CHECK(test__format("-42|  2a|0x2a|052|+7| 7", "%d|%4x|%#x|%#o|%+d|% d", -42, 42u, 42u, 42u, 7, 7));
+	M_TEST__CHECK(test__format("00042|42   |-9223372036854775808", "%05u|%-5u|%lld", 42u, 42u, (long long)INT64_MIN));
+	M_TEST__CHECK(test__format("18446744073709551615|-1|255|4096", "%llu|%hhd|%hhu|%zu",
+							   (unsigned long long)UINT64_MAX, 255, 255, (size_t)4096));
+	M_TEST__CHECK(test__format("abc|  ab|x |(null)|%", "%s|%4.2s|%-2c|%s|%%", "abc", "abc", 'x', (const char*)NULL));
+
+	/* unknown conversions are copied with their flags and width, no argument is taken */
+	M_TEST__CHECK(test__format("%5q|7", "%5q|%d", 7));
+	M_TEST__CHECK(test__format("%-08.3q|7", "%-08.3q|%d", 7));
+	M_TEST__CHECK(test__format("%ls|%lc|7", "%ls|%lc|%d", 7));
+}
+
+static void test__stream_print(void)
+{
+	struct test_console target;
+	char message[3 * (M_TEST__STREAM_LINE + 1) + 1];
+	char expected[M_TEST__CAPTURE_SIZE];
+	size_t i, len = 0;
+
+	if (test__console_open(&target) < EOK) {
+		M_TEST__CHECK(false);
+		return;
+	}
+
+	/* beyond the format buffer, the new lines fall into different chunks */
+	for (i = 0; i < 3; i++) {
+		memset(&message[i * (M_TEST__STREAM_LINE + 1)], 'a' + i, M_TEST__STREAM_LINE);
+		message[i * (M_TEST__STREAM_LINE + 1) + M_TEST__STREAM_LINE] = '\n';
+		memset(&expected[len], 'a' + i, M_TEST__STREAM_LINE);
+		memcpy(&expected[len + M_TEST__STREAM_LINE], "\n\r", 2);
+		len += M_TEST__STREAM_LINE + 2;
+	}
+	message[3 * (M_TEST__STREAM_LINE + 1)] = '\0';
+
+	M_TEST__CHECK(lib_console__print_debug_message(target.console, "%s%d\n", &message[0], -1) >= EOK);
+	len += snprintf(&expected[len], sizeof(expected) - len, "-1\n\r");
+	M_TEST__CHECK((target.len == len) && (memcmp(&target.data[0], &expected[0], len) == 0));
+
+	test__console_close(&target);
+}
+
+static void test__echo_discard(void *_arg, const char *_data, size_t _len)
+{
+	(void)_arg;
+	(void)_data;
+	(void)_len;
+}
+
+static size_t test__edit(struct console_editor *_editor, const char *_keys, char _delimiter)
+{
+	size_t pos = 0, len = strlen(_keys);
+	bool complete = false;
+
+	/* the echo is dropped after every batch, like a sent one */
+	lib_console_editor__begin(_editor, NULL, 0);
+	while ((pos < len) && !complete) {
+		pos += lib_console_editor__feed(_editor, (const uint8_t*)&_keys[pos], len - pos, _delimiter, &complete);
+		_editor->echoLen = 0;
+	}
+	return complete ? _editor->len : 0;
+}
+
+static void test__editor(void)
+{
+	static struct console_editor editor;
+	char storage[M_LIB_CONSOLE_EDITOR__LINE_SIZE];
+	char line[4];
+	bool complete;
+
+	lib_console_editor__init(&editor, &storage[0], sizeof(storage), &test__echo_discard, NULL);
+
+	/* cursor keys, home/end, kill to the end, delete and backspace */
+	M_TEST__CHECK((test__edit(&editor, "abc\x1b[D\x1b[DX\r", '\n') == 5) && (memcmp(&storage[0], "aXbc\n", 5) == 0));
+	M_TEST__CHECK((test__edit(&editor, "hello\x01>\x05<\r", '\n') == 8) && (memcmp(&storage[0], ">hello<\n", 8) == 0));
+	M_TEST__CHECK((test__edit(&editor, "abcdef\x1b[H\x1b[C\x1b[C\x0b\r", '\n') == 3) && (memcmp(&storage[0], "ab\n", 3) == 0));
+	M_TEST__CHECK((test__edit(&editor, "abc\x7f\bz\r", '\n') == 3) && (memcmp(&storage[0], "az\n", 3) == 0));
+	M_TEST__CHECK((test__edit(&editor, "abc\x01\x1b[3~\r", '\n') == 3) && (memcmp(&storage[0], "bc\n", 3) == 0));
+	M_TEST__CHECK((test__edit(&editor, "junk\x15ok\r", '\n') == 3) && (memcmp(&storage[0], "ok\n", 3) == 0));
+
+	/* history, a repeated line is kept once and the draft comes back */
+	M_TEST__CHECK((test__edit(&editor, "ok\r", '\n') == 3) && (memcmp(&storage[0], "ok\n", 3) == 0));
+	M_TEST__CHECK((test__edit(&editor, "\x1b[A\x1b[A\r", '\n') == 3) && (memcmp(&storage[0], "bc\n", 3) == 0));
+	M_TEST__CHECK((test__edit(&editor, "new\x1b[A\x1bOA\x1b[B\x1b[B\r", '\n') == 4) && (memcmp(&storage[0], "new\n", 4) == 0));
+
+	/* "\r\n" is one enter key, also across two lines */
+	M_TEST__CHECK((test__edit(&editor, "x\r", '\n') == 2) && (memcmp(&storage[0], "x\n", 2) == 0));
+	M_TEST__CHECK((test__edit(&editor, "\ny\r", '\n') == 2) && (memcmp(&storage[0], "y\n", 2) == 0));
+
+	/* another delimiter keeps enter as a new line of the line */
+	M_TEST__CHECK((test__edit(&editor, "a\rb;", ';') == 4) && (memcmp(&storage[0], "a\nb;", 4) == 0));
+
+	/* a full caller buffer ends the line */
+	lib_console_editor__begin(&editor, &line[0], sizeof(line));
+	M_TEST__CHECK(lib_console_editor__feed(&editor, (const uint8_t*)"abcdef", 6, '\n', &complete) == 4);
+	M_TEST__CHECK(complete && (editor.len == 4) && (memcmp(&line[0], "abcd", 4) == 0));
+}
+
+static void test__writev(bool _async)
+{
+	static char large[M_TEST__WRITEV_LARGE];
+	struct test_console target;
+	struct iovec iov[3];
+
+	if (test__console_open(&target) < EOK) {
+		M_TEST__CHECK(false);
+		return;
+	}
+	if (_async) {
+		M_TEST__CHECK(lib_console__async_start(target.console, 0) == EOK);
+	}
+
+	/* the new lines are translated in every buffer, empty ones are skipped */
+	iov[0].iov_base = "one\ntw";
+	iov[0].iov_len = 6;
+	iov[1].iov_base = "";
+	iov[1].iov_len = 0;
+	iov[2].iov_base = "o\n";
+	iov[2].iov_len = 2;
+	M_TEST__CHECK(lib_console__writev(target.console, &iov[0], 3) >= EOK);
+	M_TEST__CHECK(lib_console__flush(target.console) == EOK);
+	M_TEST__CHECK((target.len == 10) && (memcmp(&target.data[0], "one\n\rtwo\n\r", 10) == 0));
+
+	/* beyond a ring record the buffers are written directly */
+	memset(&large[0], 'z', sizeof(large));
+	iov[0].iov_base = &large[0];
+	iov[0].iov_len = sizeof(large);
+	iov[1].iov_base = "\n";
+	iov[1].iov_len = 1;
+	target.len = 0;
+	M_TEST__CHECK(lib_console__writev(target.console, &iov[0], 2) >= EOK);
+	M_TEST__CHECK(lib_console__flush(target.console) == EOK);
+	M_TEST__CHECK((target.len == sizeof(large) + 2) && (memcmp(&target.data[sizeof(large)], "\n\r", 2) == 0));
+
+	M_TEST__CHECK(lib_console__writev(target.console, &iov[0], 0) == EOK);
+	M_TEST__CHECK(lib_console__writev(NULL, &iov[0], 1) == -ESTD_INVAL);
+
+	if (_async) {
+		M_TEST__CHECK(lib_console__async_stop(target.console) == EOK);
+	}
+	test__console_close(&target);
+}
+
+static void test__broadcast(void)
+{
+	struct test_console targets[2];
+	char message[M_TEST__LONG_LINE + 1];
+	unsigned int idx;
+
+	for (idx = 0; idx < 2; idx++) {
+		if (test__console_open(&targets[idx]) < EOK) {
+			M_TEST__CHECK(false);
+			return;
+		}
+	}
+	M_TEST__CHECK(lib_console__async_start(targets[1].console, 0) == EOK);
+
+	/* every console gets the same translated text, a long one included */
+	memset(&message[0], 'm', M_TEST__LONG_LINE);
+	message[M_TEST__LONG_LINE] = '\0';
+	M_TEST__CHECK(lib_console_factory__broadcast("all %d\n", 7) == EOK);
+	M_TEST__CHECK(lib_console_factory__broadcast("%s\n", &message[0]) == EOK);
+	M_TEST__CHECK(lib_console__flush(targets[1].console) == EOK);
+	for (idx = 0; idx < 2; idx++) {
+		M_TEST__CHECK((targets[idx].len == 7 + M_TEST__LONG_LINE + 2) &&
+					  (memcmp(&targets[idx].data[0], "all 7\n\r", 7) == 0) &&
+					  (memcmp(&targets[idx].data[7], &message[0], M_TEST__LONG_LINE) == 0) &&
+					  (memcmp(&targets[idx].data[7 + M_TEST__LONG_LINE], "\n\r", 2) == 0));
+	}
+	M_TEST__CHECK(lib_console_factory__broadcast(NULL) == -ESTD_INVAL);
+
+	M_TEST__CHECK(lib_console__async_stop(targets[1].console) == EOK);
+	for (idx = 0; idx < 2; idx++) {
+		test__console_close(&targets[idx]);
+	}
+}
+
+static console_hdl_t test__counted(console_hdl_t _hdl, unsigned int *_calls)
+{
+	(*_calls)++;
+	return _hdl;
+}
+
+static void test__levels(void)
+{
+	struct test_console target;
+	unsigned int calls = 0, args = 0;
+	enum console_level level = CONSOLE_LEVEL_INFO;
+
+	if (test__console_open(&target) < EOK) {
+		M_TEST__CHECK(false);
+		return;
+	}
+	M_TEST__CHECK(lib_console__set_level(target.console, CONSOLE_LEVEL_INFO) == EOK);
+	M_TEST__CHECK(lib_console__get_level(target.console) == CONSOLE_LEVEL_INFO);
+
+	/* below the level the arguments are not evaluated */
+	M_LIB_CONSOLE__PRINT_DEBUG(target.console, "debug %u\n", ++args);
+	M_TEST__CHECK((args == 0) && (target.len == 0));
+
+	/* handle and level are evaluated once */
+	M_LIB_CONSOLE__PRINT(test__counted(target.console, &calls), level++, "info %u\n", ++args);
+	M_TEST__CHECK((calls == 1) && (level == CONSOLE_LEVEL_INFO + 1) && (args == 1));
+	M_TEST__CHECK((target.len == 8) && (memcmp(&target.data[0], "info 1\n\r", 8) == 0));
+	M_LIB_CONSOLE__PRINT_ERROR(test__counted(target.console, &calls), "error\n");
+	M_TEST__CHECK((calls == 2) && (target.len == 15));
+
+	/* a missing handle prints nothing */
+	M_TEST__CHECK(lib_console__level_enabled(NULL, CONSOLE_LEVEL_ERROR) == 0);
+	M_LIB_CONSOLE__PRINT_ERROR(NULL, "error %u\n", ++args);
+	M_TEST__CHECK(args == 1);
+
+	M_TEST__CHECK(lib_console__set_level(target.console, CONSOLE_LEVEL_TRACE) == EOK);
+	test__console_close(&target);
+}
+
+static void test__tap_held(void *_arg, const uint8_t *_data, unsigned int _length)
+{
+	while (atomic_load(&s_tapHold)) {
+		lib_thread__msleep(1);
+	}
+	test__tap(_arg, _data, _length);
+}
+
+static void test__overflow(void)
+{
+	struct test_console target;
+	uint64_t messages = 0, bytes = 0;
+	unsigned long delivered = 0, noted = 0;
+	unsigned int i, value;
+	size_t pos, end;
+	char line[32];
+
+	if (test__console_open(&target) < EOK) {
+		M_TEST__CHECK(false);
+		return;
+	}
+	lib_console_loopback__set_tap(target.loopback, &test__tap_held, &target);
+	M_TEST__CHECK(lib_console__async_start(target.console, M_TEST__OVERFLOW_RING) == EOK);
+	M_TEST__CHECK(lib_console__set_overflow(target.console, CONSOLE_OVERFLOW_DROP_NEWEST, 0) == EOK);
+
+	/* the stuck transport fills the ring, the prints beyond it are dropped */
+	atomic_store(&s_tapHold, true);
+	for (i = 0; i < M_TEST__OVERFLOW_PRINTS; i++) {
+		lib_console__print_debug_message(target.console, "message %03u\n", i);
+	}
+	M_TEST__CHECK(lib_console__get_drops(target.console, &messages, &bytes) == EOK);
+	M_TEST__CHECK((messages > 0) && (bytes == messages * 13));
+	atomic_store(&s_tapHold, false);
+
+	/* the drops are announced once the output flows again */
+	M_TEST__CHECK(lib_console__print_debug_message(target.console, "after\n") == EOK);
+	M_TEST__CHECK(lib_console__flush(target.console) == EOK);
+	for (pos = 0; pos < target.len; pos = end + 2) {
+		for (end = pos; (end + 1 < target.len) && (memcmp(&target.data[end], "\n\r", 2) != 0); end++) {
+		}
+		snprintf(&line[0], sizeof(line), "%.*s", (int)(end - pos), (const char*)&target.data[pos]);
+		if (sscanf(&line[0], "message %u", &value) == 1) {
+			delivered++;
+		}
+		else if (sscanf(&line[0], "%u messages dropped", &value) == 1) {
+			noted += value;
+		}
+	}
+	M_TEST__CHECK((delivered + messages == M_TEST__OVERFLOW_PRINTS) && (noted == messages));
+	M_TEST__CHECK((target.len >= 7) && (memcmp(&target.data[target.len - 7], "after\n\r", 7) == 0));
+
+	M_TEST__CHECK(lib_console__async_stop(target.console) == EOK);
+	test__console_close(&target);
+}
+
+static void test__stats(void)
+{
+	static const uint64_t values[3] = { 5, 1000, 123456 };
+	static const unsigned int permille[3] = { 333, 666, 1000 };
+	struct console_histogram hist;
+	struct console_stats stats;
+	struct test_console target;
+	char message[M_TEST__LONG_LINE + 1];
+	uint64_t bound;
+	unsigned int idx;
+
+	if (test__console_open(&target) < EOK) {
+		M_TEST__CHECK(false);
+		return;
+	}
+
+	memset(&message[0], 's', M_TEST__LONG_LINE);
+	message[M_TEST__LONG_LINE] = '\0';
+	for (idx = 0; idx < 3; idx++) {
+		M_TEST__CHECK(lib_console__print_debug_message(target.console, "stat %u\n", idx) >= EOK);
+	}
+	M_TEST__CHECK(lib_console__print_debug_message(target.console, "%s\n", &message[0]) >= EOK);
+
+	/* a streamed message is counted, only the buffered ones are timed as formatting */
+	M_TEST__CHECK(lib_console__get_stats(target.console, &stats) == EOK);
+	M_TEST__CHECK((stats.messages == 4) && (stats.streamed == 1) && (stats.bytes == target.len));
+	M_TEST__CHECK((stats.dropMessages == 0) && (stats.serialErrors == 0));
+	M_TEST__CHECK((stats.lockWait.count == 4) && (stats.format.count == 3) && (stats.write.count >= 4));
+	M_TEST__CHECK(lib_console__stats_percentile(&stats.write, 1000) >= stats.write.maxNs);
+	M_TEST__CHECK(lib_console__get_stats(target.console, NULL) == -ESTD_INVAL);
+	test__console_close(&target);
+
+	/* the bound of a percentile is at most a sub-bucket above the value */
+	memset(&hist, 0, sizeof(hist));
+	M_TEST__CHECK(lib_console__stats_percentile(&hist, 500) == 0);
+	for (idx = 0; idx < 3; idx++) {
+		hist.bucket[lib_console_stats__bucket(values[idx])]++;
+		hist.count++;
+		hist.maxNs = values[idx];
+	}
+	for (idx = 0; idx < 3; idx++) {
+		bound = lib_console__stats_percentile(&hist, permille[idx]);
+		M_TEST__CHECK((bound >= values[idx]) && (bound <= values[idx] + (values[idx] >> M_LIB_CONSOLE__HIST_SUB_BITS)));
+	}
+}
+
+static bool test__timestamp_render(struct console_timestamp_cache *_cache, enum console_timestamp _mode, uint64_t _ns)
+{
+	char expected[M_LIB_CONSOLE_TIMESTAMP__SIZE];
+	unsigned long long seconds = _ns / 1000000000ull;
+	size_t len;
+	int ret;
+
+	if (_mode == CONSOLE_TIMESTAMP_MS) {
+		ret = snprintf(&expected[0], sizeof(expected), "[%5llu.%03llu] ", seconds, (_ns / 1000000ull) % 1000ull);
+	}
+	else {
+		ret = snprintf(&expected[0], sizeof(expected), "[%5llu.%06llu] ", seconds, (_ns / 1000ull) % 1000000ull);
+	}
+
+	len = lib_console_timestamp__render(_cache, _mode, _ns);
+	if ((len != (size_t)ret) || (memcmp(&_cache->text[0], &expected[0], len) != 0)) {
+		fprintf(stderr, "timestamp %llu: \"%.*s\"\n", (unsigned long long)_ns, (int)len, &_cache->text[0]);
+		return false;
+	}
+	return true;
+}
+
+static void test__timestamps(void)
+{
+	static const uint64_t edges[] = {
+		0, 1000000ull, 999000000ull, 1000000000ull, 9999000000ull, 10000000000ull,
+		99999999000000ull, 100000000000000ull, 123456789000000ull
+	};
+	struct console_timestamp_cache cache;
+	struct test_console target;
+	uint64_t ns, step = 1;
+	unsigned int idx;
+	size_t prefix;
+
+	/* carries over all digits and a growing seconds field, only changed digits are rewritten */
+	memset(&cache, 0, sizeof(cache));
+	for (idx = 0; idx < sizeof(edges) / sizeof(edges[0]); idx++) {
+		M_TEST__CHECK(test__timestamp_render(&cache, CONSOLE_TIMESTAMP_MS, edges[idx]));
+	}
+	M_TEST__CHECK(test__timestamp_render(&cache, CONSOLE_TIMESTAMP_US, edges[idx - 1] + 1000));
+
+	memset(&cache, 0, sizeof(cache));
+	for (idx = 0, ns = 0; idx < M_TEST__TIMESTAMP_STEPS; idx++) {
+		step = step * 6364136223846793005ull + 1442695040888963407ull;
+		ns += (step >> 33) >> (idx % 24);
+		M_TEST__CHECK(test__timestamp_render(&cache, (idx & 1) ? CONSOLE_TIMESTAMP_US : CONSOLE_TIMESTAMP_MS, ns));
+	}
+
+	/* the prefix goes in front of a print starting a line only */
+	if (test__console_open(&target) < EOK) {
+		M_TEST__CHECK(false);
+		return;
+	}
+	M_TEST__CHECK(lib_console__set_timestamp(target.console, CONSOLE_TIMESTAMP_MS) == EOK);
+	M_TEST__CHECK(lib_console__print_debug_message(target.console, "one ") >= EOK);
+	M_TEST__CHECK(lib_console__print_debug_message(target.console, "two\n") >= EOK);
+	M_TEST__CHECK(lib_console__print_debug_message(target.console, "three\n") >= EOK);
+	for (prefix = 0; (prefix + 1 < target.len) && (target.data[prefix] != ']'); prefix++) {
+	}
+	prefix += 2;
+	M_TEST__CHECK((target.len == 2 * prefix + 16) && (target.data[0] == '[') && (target.data[prefix - 6] == '.') &&
+				  (memcmp(&target.data[prefix - 2], "] one two\n\r[", 12) == 0) &&
+				  (memcmp(&target.data[2 * prefix + 9], "three\n\r", 7) == 0));
+	M_TEST__CHECK(lib_console__set_timestamp(target.console, CONSOLE_TIMESTAMP_OFF) == EOK);
+	test__console_close(&target);
+}
+
+static void test__typed(void)
+{
+	static const char expected[] =
+		"u32: 4294967295\n\r" "0\n\r"
+		"i64: -9223372036854775808\n\r" "i64: 9223372036854775807\n\r" "i64: 0\n\r"
+		"hex: 00000abc\n\r" "hex: ffffffffffffffff\n\r" "hex: 0\n\r"
+		"fixed: 12.345\n\r" "fixed: -0.005\n\r" "fixed: -9.223372036854775808\n\r" "fixed: 7\n\r" "fixed: 0.00\n\r"
+		"str: text\n\r" "str: (null)\n\r";
+	struct test_console target;
+
+	if (test__console_open(&target) < EOK) {
+		M_TEST__CHECK(false);
+		return;
+	}
+
+	M_TEST__CHECK(lib_console__print_u32(target.console, "u32: ", UINT32_MAX) >= EOK);
+	M_TEST__CHECK(lib_console__print_u32(target.console, NULL, 0) >= EOK);
+	M_TEST__CHECK(lib_console__print_i64(target.console, "i64: ", INT64_MIN) >= EOK);
+	M_TEST__CHECK(lib_console__print_i64(target.console, "i64: ", INT64_MAX) >= EOK);
+	M_TEST__CHECK(lib_console__print_i64(target.console, "i64: ", 0) >= EOK);
+	M_TEST__CHECK(lib_console__print_hex(target.console, "hex: ", 0xabc, 8) >= EOK);
+	M_TEST__CHECK(lib_console__print_hex(target.console, "hex: ", UINT64_MAX, 0) >= EOK);
+	M_TEST__CHECK(lib_console__print_hex(target.console, "hex: ", 0, 0) >= EOK);
+	M_TEST__CHECK(lib_console__print_fixed(target.console, "fixed: ", 12345, 3) >= EOK);
+	M_TEST__CHECK(lib_console__print_fixed(target.console, "fixed: ", -5, 3) >= EOK);
+	M_TEST__CHECK(lib_console__print_fixed(target.console, "fixed: ", INT64_MIN, 18) >= EOK);
+	M_TEST__CHECK(lib_console__print_fixed(target.console, "fixed: ", 7, 0) >= EOK);
+	M_TEST__CHECK(lib_console__print_fixed(target.console, "fixed: ", 0, 2) >= EOK);
+	M_TEST__CHECK(lib_console__print_str(target.console, "str: ", "text") >= EOK);
+	M_TEST__CHECK(lib_console__print_str(target.console, "str: ", NULL) >= EOK);
+	M_TEST__CHECK((target.len == sizeof(expected) - 1) && (memcmp(&target.data[0], &expected[0], target.len) == 0));
+
+	/* nothing is printed for invalid arguments */
+	M_TEST__CHECK(lib_console__print_fixed(target.console, "fixed: ", 1, 19) == -ESTD_INVAL);
+	M_TEST__CHECK(lib_console__print_u32(NULL, "u32: ", 1) == -ESTD_INVAL);
+	M_TEST__CHECK(target.len == sizeof(expected) - 1);
+
+	test__console_close(&target);
+}
+
+static void test__print_buffer(bool _async)
+{
+	char message[M_TEST__LONG_LINE];
+	char expected[M_TEST__CAPTURE_SIZE];
+	struct console_stats stats;
+	struct test_console target;
+	size_t idx, len = 0;
+
+	if (test__console_open(&target) < EOK) {
+		M_TEST__CHECK(false);
+		return;
+	}
+	if (_async) {
+		M_TEST__CHECK(lib_console__async_start(target.console, 0) == EOK);
+	}
+
+	/* a long buffer keeps its zero bytes and follows the short one */
+	for (idx = 0; idx < sizeof(message); idx++) {
+		message[idx] = (idx % 50 == 49) ? '\n' : (char)(idx % 7);
+	}
+	M_TEST__CHECK(lib_console__print_buffer(target.console, "short\n", 6) >= EOK);
+	memcpy(&expected[len], "short\n\r", 7);
+	len += 7;
+	M_TEST__CHECK(lib_console__print_buffer(target.console, &message[0], sizeof(message)) >= EOK);
+	for (idx = 0; idx < sizeof(message); idx++) {
+		expected[len++] = message[idx];
+		if (message[idx] == '\n') {
+			expected[len++] = '\r';
+		}
+	}
+
+	M_TEST__CHECK(lib_console__flush(target.console) == EOK);
+	M_TEST__CHECK((target.len == len) && (memcmp(&target.data[0], &expected[0], len) == 0));
+	M_TEST__CHECK((lib_console__get_stats(target.console, &stats) == EOK) && (stats.messages == 2) && (stats.streamed == 1));
+	M_TEST__CHECK(lib_console__print_buffer(target.console, NULL, 1) == -ESTD_INVAL);
+
+	if (_async) {
+		M_TEST__CHECK(lib_console__async_stop(target.console) == EOK);
+	}
+	test__console_close(&target);
+}
+
+static void test__rx_raw(void)
+{
+	static struct console_editor editor;
+	const char raw[] = "ab\r;cd\x7f;tail";
+	const char edit[] = "xy\x1b[Dz\r";
+	char storage[M_LIB_CONSOLE_EDITOR__LINE_SIZE];
+	char keys[M_TEST__SCAN_LINE + 2];
+	char expected[M_TEST__SCAN_LINE + 1];
+	struct test_console target;
+	char line[32];
+	size_t n, pos, idx;
+
+	/* a delete key at every position of a line, across the blocks of the scanner */
+	lib_console_editor__init(&editor, &storage[0], sizeof(storage), &test__echo_discard, NULL);
+	for (pos = 0; pos < M_TEST__SCAN_LINE; pos++) {
+		for (idx = 0, n = 0; idx < M_TEST__SCAN_LINE; idx++) {
+			keys[idx] = (idx == pos) ? '\x7f' : (char)('A' + idx % 26);
+			if (idx + 1 == pos) {
+				continue;
+			}
+			if (idx != pos) {
+				expected[n++] = keys[idx];
+			}
+		}
+		keys[M_TEST__SCAN_LINE] = '\r';
+		keys[M_TEST__SCAN_LINE + 1] = '\0';
+		expected[n++] = '\n';
+		M_TEST__CHECK((test__edit(&editor, &keys[0], '\n') == n) && (memcmp(&storage[0], &expected[0], n) == 0));
+	}
+
+	if (test__console_open(&target) < EOK) {
+		M_TEST__CHECK(false);
+		return;
+	}
+
+	/* raw bytes up to the delimiter, no editing and no echo */
+	M_TEST__CHECK(lib_console__set_rx_mode(target.console, CONSOLE_RX_MODE_RAW) == EOK);
+	M_TEST__CHECK(lib_console_loopback__inject(target.loopback, (const uint8_t*)&raw[0], sizeof(raw) - 1) ==
+				  (int)(sizeof(raw) - 1));
+	n = sizeof(line);
+	M_TEST__CHECK(lib_console__getdelim(target.console, &line[0], &n, ';') == EOK);
+	M_TEST__CHECK((n == 4) && (memcmp(&line[0], "ab\r;", 4) == 0));
+	n = sizeof(line);
+	M_TEST__CHECK(lib_console__getdelim(target.console, &line[0], &n, ';') == EOK);
+	M_TEST__CHECK((n == 4) && (memcmp(&line[0], "cd\x7f;", 4) == 0));
+	n = 2;
+	M_TEST__CHECK(lib_console__getdelim(target.console, &line[0], &n, ';') == EOK);
+	M_TEST__CHECK((n == 2) && (memcmp(&line[0], "ta", 2) == 0));
+	n = 2;
+	M_TEST__CHECK(lib_console__getdelim(target.console, &line[0], &n, ';') == EOK);
+	M_TEST__CHECK((n == 2) && (memcmp(&line[0], "il", 2) == 0));
+	M_TEST__CHECK(target.len == 0);
+
+	/* back in edit mode the keys are applied and echoed */
+	M_TEST__CHECK(lib_console__set_rx_mode(target.console, CONSOLE_RX_MODE_EDIT) == EOK);
+	M_TEST__CHECK(lib_console_loopback__inject(target.loopback, (const uint8_t*)&edit[0], sizeof(edit) - 1) ==
+				  (int)(sizeof(edit) - 1));
+	n = sizeof(line);
+	M_TEST__CHECK(lib_console__getline(target.console, &line[0], &n) == EOK);
+	M_TEST__CHECK((n == 4) && (memcmp(&line[0], "xzy\n", 4) == 0));
+	M_TEST__CHECK(target.len > 0);
+	M_TEST__CHECK(lib_console__set_rx_mode(target.console, (enum console_rx_mode)2) == -ESTD_INVAL);
+
+	test__console_close(&target);
+}
+
+static void test__reactor_line(void *_arg, console_hdl_t _hdl, const char *_line, size_t _len)
+{
+	struct test_reactor *reactor = (struct test_reactor*)_arg;
+	char expected[32];
+	unsigned int idx;
+	int len;
+
+	for (idx = 0; (idx < M_TEST__REACTOR_CONSOLES) && (reactor->consoles[idx] != _hdl); idx++) {
+	}
+	if (idx == M_TEST__REACTOR_CONSOLES) {
+		reactor->ordered = false;
+		return;
+	}
+
+	/* every console delivers its own lines in order, the raw one keeps "\r" */
+	len = snprintf(&expected[0], sizeof(expected), "c%u l%u%s", idx, reactor->lines[idx], (idx == 1) ? "\r\n" : "\n");
+	if ((_len != (size_t)len) || (memcmp(_line, &expected[0], _len) != 0)) {
+		reactor->ordered = false;
+	}
+	reactor->lines[idx]++;
+}
+
+static void test__reactor(void)
+{
+	struct test_reactor reactor;
+	console_reactor_hdl_t reactorHdl;
+	console_fd_hdl_t fdHdl[M_TEST__REACTOR_CONSOLES];
+	int in[M_TEST__REACTOR_CONSOLES][2], out[M_TEST__REACTOR_CONSOLES][2];
+	unsigned int idx, line, total;
+	char text[32], echo[32];
+	int len;
+
+	reactor.ordered = true;
+	for (idx = 0; idx < M_TEST__REACTOR_CONSOLES; idx++) {
+		M_TEST__CHECK((pipe(in[idx]) == 0) && (pipe(out[idx]) == 0));
+		fdHdl[idx] = lib_console_fd__create(in[idx][0], out[idx][1]);
+		reactor.consoles[idx] = lib_console_factory__getTransportInstance(&lib_console_transport__fd, fdHdl[idx]);
+		M_TEST__CHECK(lib_console__open(reactor.consoles[idx], BAUD_115200, DATA_8N1) == EOK);
+		reactor.lines[idx] = 0;
+	}
+	M_TEST__CHECK(lib_console__set_rx_mode(reactor.consoles[1], CONSOLE_RX_MODE_RAW) == EOK);
+
+	reactorHdl = lib_console_reactor__create(&test__reactor_line, &reactor);
+	M_TEST__CHECK(reactorHdl != NULL);
+
+	/* the input of all consoles is interleaved, enter ends a line in edit mode */
+	for (line = 0; line < M_TEST__REACTOR_LINES; line++) {
+		for (idx = 0; idx < M_TEST__REACTOR_CONSOLES; idx++) {
+			len = snprintf(&text[0], sizeof(text), "c%u l%u%s", idx, line, (idx == 1) ? "\r\n" : "\r");
+			M_TEST__CHECK(write(in[idx][1], &text[0], (size_t)len) == len);
+		}
+	}
+	for (total = 0; (total < M_TEST__REACTOR_CONSOLES * M_TEST__REACTOR_LINES) && (lib_console_reactor__run(reactorHdl, 1000) > 0);) {
+		for (idx = 0, total = 0; idx < M_TEST__REACTOR_CONSOLES; idx++) {
+			total += reactor.lines[idx];
+		}
+	}
+	for (idx = 0; idx < M_TEST__REACTOR_CONSOLES; idx++) {
+		M_TEST__CHECK(reactor.lines[idx] == M_TEST__REACTOR_LINES);
+	}
+	M_TEST__CHECK(reactor.ordered);
+
+	/* the edit mode console echoes its input, a wakeup ends a waiting round */
+	M_TEST__CHECK((read(out[0][0], &echo[0], 5) == 5) && (memcmp(&echo[0], "c0 l0", 5) == 0));
+	M_TEST__CHECK(lib_console_reactor__wakeup(reactorHdl) == EOK);
+	M_TEST__CHECK(lib_console_reactor__run(reactorHdl, -1) >= EOK);
+	M_TEST__CHECK(lib_console_reactor__destroy(&reactorHdl) == EOK);
+
+	for (idx = 0; idx < M_TEST__REACTOR_CONSOLES; idx++) {
+		lib_console_factory__destroy(&reactor.consoles[idx]);
+		lib_console_fd__destroy(&fdHdl[idx]);
+		close(in[idx][0]);
+		close(in[idx][1]);
+		close(out[idx][0]);
+		close(out[idx][1]);
+	}
+}
+
+static void test__arena(void)
+{
+	static _Alignas(max_align_t) uint8_t memory[M_TEST__ARENA_SIZE];
+	struct console_attr attr;
+	struct console_arena arena;
+	struct test_console target;
+	size_t size;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.rxChunkSize = 32;
+	attr.txRingSize = 512;
+	attr.rxRingSize = 256;
+	attr.lineSize = 64;
+	attr.coalesceSize = 128;
+	attr.arena = &arena;
+	size = lib_console_factory__memory_size(&attr);
+	if ((size == 0) || (size > sizeof(memory))) {
+		M_TEST__CHECK(false);
+		return;
+	}
+	M_TEST__CHECK(lib_console_arena__init(&arena, &memory[0], size) == EOK);
+
+	/* the handle and all of its buffers are one block of the arena */
+	target.len = 0;
+	target.loopback = lib_console_loopback__create(64);
+	lib_console_loopback__set_tap(target.loopback, &test__tap, &target);
+	target.console = lib_console_factory__create(&attr, &lib_console_transport__loopback, target.loopback);
+	M_TEST__CHECK(((uint8_t*)target.console >= &memory[0]) && ((uint8_t*)target.console < &memory[size]));
+	M_TEST__CHECK(lib_console_factory__create(&attr, &lib_console_transport__loopback, target.loopback) == NULL);
+	M_TEST__CHECK(lib_console__open(target.console, BAUD_115200, DATA_8N1) == EOK);
+
+	/* the reservations bound the rings and the coalescing buffer */
+	M_TEST__CHECK(lib_console__async_start(target.console, 4096) == -ESTD_NOSPC);
+	M_TEST__CHECK(lib_console__async_start(target.console, 0) == EOK);
+	M_TEST__CHECK(lib_console__set_coalesce(target.console, 256, CONSOLE_FLUSH_FULL, 0) == -ESTD_NOSPC);
+	M_TEST__CHECK(lib_console__set_coalesce(target.console, 128, CONSOLE_FLUSH_FULL, 0) == EOK);
+	M_TEST__CHECK(lib_console__print_debug_message(target.console, "pooled\n") == EOK);
+	M_TEST__CHECK(lib_console__flush(target.console) >= EOK);
+	M_TEST__CHECK((target.len == 8) && (memcmp(&target.data[0], "pooled\n\r", 8) == 0));
+	M_TEST__CHECK(lib_console__set_coalesce(target.console, 0, CONSOLE_FLUSH_FULL, 0) == EOK);
+	M_TEST__CHECK(lib_console__async_stop(target.console) == EOK);
+	M_TEST__CHECK(lib_console__rx_start(target.console, 0) == EOK);
+	M_TEST__CHECK(lib_console__rx_stop(target.console) == EOK);
+
+	/* the block is not given back */
+	test__console_close(&target);
+	M_TEST__CHECK(arena.used > 0);
+
+	/* without a reservation a pooled console does not coalesce */
+	attr.coalesceSize = 0;
+	M_TEST__CHECK(lib_console_arena__init(&arena, &memory[0], sizeof(memory)) == EOK);
+	M_TEST__CHECK(test__console_open(&target) == EOK);
+	lib_console_factory__destroy(&target.console);
+	target.console = lib_console_factory__create(&attr, &lib_console_transport__loopback, target.loopback);
+	M_TEST__CHECK((target.console != NULL) && (lib_console__open(target.console, BAUD_115200, DATA_8N1) == EOK));
+	M_TEST__CHECK(lib_console__set_coalesce(target.console, 64, CONSOLE_FLUSH_FULL, 0) == -ESTD_NOSPC);
+	test__console_close(&target);
+
+	attr.lineSize = SIZE_MAX / 2;
+	M_TEST__CHECK(lib_console_factory__memory_size(&attr) == 0);
+}
+
+static void test__tap_panic(void *_arg, const uint8_t *_data, unsigned int _length)
+{
+	/* only the normal print is held, the panic output passes */
+	if ((_length > 0) && (_data[0] == 'h')) {
+		atomic_store(&s_tapEntered, true);
+		test__tap_held(_arg, _data, _length);
+		return;
+	}
+	test__tap(_arg, _data, _length);
+}
+
+static void* test__panic_writer(void *_arg)
+{
+	struct test_console *target = (struct test_console*)_arg;
+
+	lib_console__print_debug_message(target->console, "held\n");
+	return NULL;
+}
+
+static void test__panic(void)
+{
+	struct test_console target;
+	thread_hdl_t writer;
+	uint64_t start;
+
+	if (test__console_open(&target) < EOK) {
+		M_TEST__CHECK(false);
+		return;
+	}
+
+	M_TEST__CHECK(lib_console__panic(target.console, "panic %d\n", 1) == EOK);
+	M_TEST__CHECK((target.len == 9) && (memcmp(&target.data[0], "panic 1\n\r", 9) == 0));
+	M_TEST__CHECK(lib_console__panic(NULL, "panic\n") == -ESTD_INVAL);
+
+	/* a holder stuck in the transport is overtaken after the bounded wait */
+	target.len = 0;
+	lib_console_loopback__set_tap(target.loopback, &test__tap_panic, &target);
+	atomic_store(&s_tapEntered, false);
+	atomic_store(&s_tapHold, true);
+	M_TEST__CHECK(lib_thread__create(&writer, &test__panic_writer, &target, 0, "test_writer") == EOK);
+	while (!atomic_load(&s_tapEntered)) {
+		lib_thread__msleep(1);
+	}
+	start = lib_console_timestamp__now();
+	M_TEST__CHECK(lib_console__panic(target.console, "panic %d\n", 2) == EOK);
+	M_TEST__CHECK(lib_console_timestamp__now() - start < 1000000000ull);
+	M_TEST__CHECK((target.len == 9) && (memcmp(&target.data[0], "panic 2\n\r", 9) == 0));
+	atomic_store(&s_tapHold, false);
+	lib_thread__join(&writer, NULL);
+	M_TEST__CHECK((target.len == 15) && (memcmp(&target.data[9], "held\n\r", 6) == 0));
+
+	test__console_close(&target);
+}
+
+static void test__coalesce(void)
+{
+	const char input[] = "x\n";
+	struct test_console target;
+	char line[8];
+	unsigned int i;
+	size_t n;
+
+	if (test__console_open(&target) < EOK) {
+		M_TEST__CHECK(false);
+		return;
+	}
+	M_TEST__CHECK(lib_console__set_coalesce(target.console, M_TEST__COALESCE_SIZE, CONSOLE_FLUSH_LINE + 1, 0) == -ESTD_INVAL);
+
+	/* the output is held until the flush */
+	M_TEST__CHECK(lib_console__set_coalesce(target.console, M_TEST__COALESCE_SIZE, CONSOLE_FLUSH_FULL, 0) == EOK);
+	M_TEST__CHECK(lib_console__print_debug_message(target.console, "a\n") >= EOK);
+	M_TEST__CHECK(lib_console__print_debug_message(target.console, "b\n") >= EOK);
+	M_TEST__CHECK(target.len == 0);
+	M_TEST__CHECK(lib_console__flush(target.console) == 6);
+	M_TEST__CHECK((target.len == 6) && (memcmp(&target.data[0], "a\n\rb\n\r", 6) == 0));
+	M_TEST__CHECK(lib_console__flush(target.console) == EOK);
+
+	/* or until the next message does not fit, 5 lines of 12 bytes fill 60 of 64 */
+	target.len = 0;
+	for (i = 0; i < 5; i++) {
+		M_TEST__CHECK(lib_console__print_debug_message(target.console, "%010u\n", i) >= EOK);
+	}
+	M_TEST__CHECK(target.len == 0);
+	M_TEST__CHECK(lib_console__print_debug_message(target.console, "%010u\n", i) >= EOK);
+	M_TEST__CHECK((target.len == 60) && (memcmp(&target.data[48], "0000000004\n\r", 12) == 0));
+
+	/* switching coalescing off writes out the rest */
+	M_TEST__CHECK(lib_console__set_coalesce(target.console, 0, CONSOLE_FLUSH_FULL, 0) == EOK);
+	M_TEST__CHECK((target.len == 72) && (memcmp(&target.data[60], "0000000005\n\r", 12) == 0));
+
+	/* the line policy flushes with every new line */
+	target.len = 0;
+	M_TEST__CHECK(lib_console__set_coalesce(target.console, M_TEST__COALESCE_SIZE, CONSOLE_FLUSH_LINE, 0) == EOK);
+	M_TEST__CHECK(lib_console__print_debug_message(target.console, "part") >= EOK);
+	M_TEST__CHECK(target.len == 0);
+	M_TEST__CHECK(lib_console__print_debug_message(target.console, "end\n") >= EOK);
+	M_TEST__CHECK((target.len == 9) && (memcmp(&target.data[0], "partend\n\r", 9) == 0));
+
+	/* the delay writes out through the flush thread, the later flush finds nothing */
+	target.len = 0;
+	M_TEST__CHECK(lib_console__set_coalesce(target.console, M_TEST__COALESCE_SIZE, CONSOLE_FLUSH_FULL, M_TEST__COALESCE_DELAY) == EOK);
+	M_TEST__CHECK(lib_console__print_debug_message(target.console, "late\n") >= EOK);
+	M_TEST__CHECK(target.len == 0);
+	lib_thread__msleep(10 * M_TEST__COALESCE_DELAY);
+	M_TEST__CHECK(lib_console__flush(target.console) == EOK);
+	M_TEST__CHECK((target.len == 6) && (memcmp(&target.data[0], "late\n\r", 6) == 0));
+
+	/* an echo is not held back, it takes the held output along */
+	target.len = 0;
+	M_TEST__CHECK(lib_console__set_coalesce(target.console, M_TEST__COALESCE_SIZE, CONSOLE_FLUSH_FULL, 0) == EOK);
+	M_TEST__CHECK(lib_console__rx_start(target.console, 0) == EOK);
+	M_TEST__CHECK(lib_console__print_debug_message(target.console, "held") >= EOK);
+	M_TEST__CHECK(lib_console_loopback__inject(target.loopback, (const uint8_t*)&input[0], sizeof(input) - 1) ==
+				  (int)(sizeof(input) - 1));
+	n = sizeof(line);
+	M_TEST__CHECK(lib_console__getline(target.console, &line[0], &n) == EOK);
+	M_TEST__CHECK((n == 2) && (memcmp(&line[0], "x\n", 2) == 0));
+	M_TEST__CHECK((target.len > 5) && (memcmp(&target.data[0], "heldx", 5) == 0));
+	M_TEST__CHECK(lib_console__rx_stop(target.console) == EOK);
+
+	M_TEST__CHECK(lib_console__set_coalesce(target.console, 0, CONSOLE_FLUSH_FULL, 0) == EOK);
+	test__console_close(&target);
+}
@@ -0,0 +1,246 @@
+#!/usr/bin/env python3
+#
+# This file is part of the EMBTOM project
+# Copyright (c) 2018-2019 Thomas Willetal
+# (https://github.com/tom3333)
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal in the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+# LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+# OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+"""Host side decoder of the lib_console deferred records (M_LIB_CONSOLE__LOG).
+
+A record on the wire is
+
+    0xFE | varint body length | body
+    body = varint sequence | varint format offset | arguments
+
+Arguments follow the conversions of the format string: signed integers and
+"*" width/precision are zigzag varints, unsigned integers, pointers and
+characters are varints, strings are a varint length plus the bytes.
+Everything outside of a record is passed through as plain text.
+
+The format table is the "lib_console_fmt" section of the firmware, either
+read from the ELF file (--elf) or from the binary written by the CMake
+helper lib_console_format_table() (--table).
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+MAGIC = 0xFE
+SECTION = "lib_console_fmt"
+
+CONVERSION = re.compile(rb"%([-0+ #]*)(\*|[0-9]+)?(?:\.(\*|[0-9]*))?(hh|h|ll|l|z)?(.?)", re.S)
+
+
+def elf_section(path, name):
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] != b"\x7fELF":
+        raise ValueError("%s is not an ELF file" % path)
+
+    bits64 = data[4] == 2
+    endian = "<" if data[5] == 1 else ">"
+    if bits64:
+        shoff, = struct.unpack_from(endian + "Q", data, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", data, 0x3A)
+        entry = endian + "IIQQQQIIQQ"
+    else:
+        shoff, = struct.unpack_from(endian + "I", data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", data, 0x2E)
+        entry = endian + "IIIIIIIIII"
+
+    sections = [struct.unpack_from(entry, data, shoff + i * shentsize) for i in range(shnum)]
+    strtab = sections[shstrndx]
+    for sec in sections:
+        start = strtab[4] + sec[0]
+        sec_name = data[start:data.index(b"\0", start)].decode()
+        if sec_name == name:
+            return data[sec[4]:sec[4] + sec[5]]
+    raise ValueError("%s has no %s section" % (path, name))
+
+
+class Reader:
+    def __init__(self, body):
+        self.body = body
+        self.pos = 0
+
+    def varint(self):
+        value = 0
+        shift = 0
+        while True:
+            byte = self.body[self.pos]
+            self.pos += 1
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                return value
+
+    def zigzag(self):
+        value = self.varint()
+        return (value >> 1) ^ -(value & 1)
+
+    def string(self):
+        length = self.varint()
+        value = self.body[self.pos:self.pos + length]
+        self.pos += length
+        return value
+
+
+def render(fmt, reader):
+    out = bytearray()
+    pos = 0
+    for match in CONVERSION.finditer(fmt):
+        out += fmt[pos:match.start()]
+        pos = match.end()
+        flags, width, precision, _, conv = match.groups()
+        if conv == b"%":
+            out += b"%"
+            continue
+
+        width = b"" if width is None else width
+        if width == b"*":
+            value = reader.zigzag()
+            width = str(abs(value)).encode()
+            if value < 0:
+                flags += b"-"
+        if precision is not None:
+            if precision == b"*":
+                value = reader.zigzag()
+                precision = b"" if value < 0 else (b"." + str(value).encode())
+            else:
+                precision = b"." + (precision or b"0")
+        else:
+            precision = b""
+
+        spec = b"%" + flags + width + precision
+        if conv in (b"d", b"i"):
+            out += (spec + b"d") % reader.zigzag()
+        elif conv == b"u":
+            out += (spec + b"d") % reader.varint()
+        elif conv in (b"x", b"X"):
+            out += (spec + conv) % reader.varint()
+        elif conv == b"o":
+            # C raises the precision for "#", python would write "0o" instead
+            value = reader.varint()
+            if b"#" in flags:
+                digits = len(b"%o" % value) + 1 if value else 1
+                precision = b".%d" % max(digits, int(precision[1:] or b"0"))
+            out += (b"%" + flags.replace(b"#", b"") + width + precision + b"o") % value
+        elif conv == b"p":
+            out += (b"%" + flags.replace(b"#", b"") + b"#" + width + b"x") % reader.varint()
+        elif conv == b"c":
+            out += (b"%" + flags + width + b"c") % reader.varint()
+        elif conv == b"s":
+            out += (spec + b"s") % reader.string()
+        else:
+            # unknown conversion, the device sent no argument for it
+            out += match.group(0)
+    out += fmt[pos:]
+    return bytes(out)
+
+
+class Decoder:
+    def __init__(self, table, out):
+        self.table = table
+        self.out = out
+        self.buffer = bytearray()
+        self.sequence = None
+
+    def record(self, body):
+        reader = Reader(body)
+        sequence = reader.varint()
+        offset = reader.varint()
+        if self.sequence is not None:
+            lost = (sequence - self.sequence - 1) & 0xFFFFFFFF
+            if lost:
+                self.out.write(b"<%d deferred records lost>\n" % lost)
+        self.sequence = sequence
+
+        if offset >= len(self.table):
+            self.out.write(b"<unknown format offset %d>\n" % offset)
+            return
+        fmt = self.table[offset:self.table.index(b"\0", offset)]
+        try:
+            self.out.write(render(fmt, reader))
+        except (IndexError, TypeError, ValueError):
+            self.out.write(b"<malformed record for \"" + fmt + b"\">\n")
+
+    def feed(self, data):
+        self.buffer += data
+        while self.buffer:
+            start = self.buffer.find(MAGIC)
+            if start < 0:
+                self.text(self.buffer)
+                self.buffer.clear()
+                return
+            self.text(self.buffer[:start])
+            del self.buffer[:start]
+
+            # magic, one or two length bytes and the body
+            if len(self.buffer) < 2:
+                return
+            length = self.buffer[1] & 0x7F
+            header = 2
+            if self.buffer[1] & 0x80:
+                if len(self.buffer) < 3:
+                    return
+                length |= self.buffer[2] << 7
+                header = 3
+            if len(self.buffer) < header + length:
+                return
+            self.record(bytes(self.buffer[header:header + length]))
+            del self.buffer[:header + length]
+
+    def text(self, data):
+        # the console sends "\n\r", the carriage return is only for terminals
+        self.out.write(bytes(data).replace(b"\r", b""))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--elf", help="firmware ELF file containing the format table")
+    source.add_argument("--table", help="format table extracted by lib_console_format_table()")
+    parser.add_argument("input", nargs="?", default="-",
+                        help="captured stream or serial device, default stdin")
+    args = parser.parse_args()
+
+    if args.elf:
+        table = elf_section(args.elf, SECTION)
+    else:
+        with open(args.table, "rb") as f:
+            table = f.read()
+
+    out = sys.stdout.buffer
+    decoder = Decoder(table, out)
+    stream = sys.stdin.buffer if args.input == "-" else open(args.input, "rb", buffering=0)
+    with stream:
+        while True:
+            data = stream.read1(4096) if hasattr(stream, "read1") else stream.read(4096)
+            if not data:
+                break
+            decoder.feed(data)
+            out.flush()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+#
+# This file is part of the EMBTOM project
+# Copyright (c) 2018-2019 Thomas Willetal
+# (https://github.com/tom3333)
+#
+# Permission is hereby granted, free of charge, to any person obtaining
+# a copy of this software and associated documentation files (the
+# "Software"), to deal in the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+# LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+# OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+# WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+"""Extracts the console history of a lib_console mirror file (lib_console_mirror__open).
+
+The file starts with a header in the byte order of the device
+
+    char magic[8] | u32 version | u32 header size | u64 ring size |
+    u64 sequence | u64 head | u64 tail
+
+followed by the ring data. The bytes [max(tail, head - size), head) are
+intact, the oldest one is at that position modulo the ring size. Deferred
+records in the history are decoded by piping the raw output into
+tools/lib_console_decode.py.
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = b"LCMIRROR"
+VERSION = 1
+HEADER = "8sIIQQQQ"
+
+
+def extract(data):
+    for endian in "<>":
+        magic, version, header_size, size, sequence, head, tail = struct.unpack_from(endian + HEADER, data, 0)
+        if magic == MAGIC and version == VERSION:
+            break
+    else:
+        raise ValueError("not a lib_console mirror file")
+
+    if size == 0 or len(data) < header_size + size or tail > head:
+        raise ValueError("corrupted mirror header")
+
+    ring = data[header_size:header_size + size]
+    start = max(tail, head - size)
+    first = start % size
+    length = head - start
+    history = ring[first:first + length]
+    history += ring[:length - len(history)]
+    return sequence, bytes(history)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("mirror", help="mirror file written by the device")
+    parser.add_argument("--raw", action="store_true",
+                        help="keep the bytes as sent, e.g. for lib_console_decode.py")
+    args = parser.parse_args()
+
+    with open(args.mirror, "rb") as f:
+        data = f.read()
+    sequence, history = extract(data)
+
+    if not args.raw:
+        # the console sends "\n\r", the carriage return is only for terminals
+        history = history.replace(b"\r", b"")
+        sys.stderr.write("session %d, %d bytes\n" % (sequence, len(history)))
+    sys.stdout.buffer.write(history)
+
+
+if __name__ == "__main__":
+    main()